@@ -1,643 +1,1203 @@
 /*
   mbcet_cgpa_final.c
   Final CGPA/SGPA calculator with CE, ME, EEE, ECE and CS streams (CT removed).
-  - Branch order: CE, ME, EEE, ECE, CS
-  - P/F subjects: asked by marks, credits = 0 (not counted in GPA). Pass >= 50.
+  - Syllabus loaded at startup from mbcet_syllabus.txt (or --syllabus FILE, text or compiled snapshot).
+  - Branch order: as listed in the syllabus file (CE, ME, EEE, ECE, CS)
+  - P/F subjects: asked by marks, credits = 0 (not counted in GPA). Pass mark from the grading scheme (50).
+  - Grading schemes (grading_schemes.txt): marks -> grade point tables, per branch/semester.
   - Activity points tracked; required >= 150.
   - CS: minors/honours removed (as requested). CE/ME/EEE include minors/honours as per provided syllabus.
+  - Batch mode (--batch FILE): grades a whole cohort from a CSV/TSV marks file without prompts.
+  - Student store (--store DIR): entered results persist across runs (append log + snapshot).
+  - Parquet export (--export FILE): every graded subject of the store, for analytics tools.
+  - Transcripts (--transcripts DIR|FILE.tar): HTML or PDF per stored student from a compiled template.
+  - Result service (--serve PORT): stored results as JSON over HTTP on localhost.
+  - Mark entry (--entry PORT): several operators commit marks to the store at once, durable on reply.
+  - Degree eligibility rules (eligibility_rules.txt): per-branch checks, --eligibility lists who qualifies.
+  - Metrics (--metrics FILE, /metrics): hot-path counters and latency histograms; -DCGPA_NO_METRICS drops them.
 */
 
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <pthread.h>
+#define HAVE_POSIX 1
+#define HAVE_THREADS 1
+#endif
+
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#define HAVE_EPOLL 1
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GRADE_LANES 32                /* students per SIMD register, one byte each */
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define GRADE_LANES 16
+#else
+#define GRADE_LANES 1
+#endif
 
-#define MAX_BRANCHES 5
-#define SEM_COUNT 8
-#define MAX_SUBJECTS 10
+#define SEMESTER_NUMBER_LIMIT 16      // sanity bound for syllabus validation only
 #define ACTIVITY_REQUIRED 150
+#define DEFAULT_SYLLABUS "mbcet_syllabus.txt"
+#define DEFAULT_SCHEMES "grading_schemes.txt"
 
+#define MARKS_NOT_ENTERED 255
+#define GP_PF_PASS (-1)
+#define GP_PF_FAIL (-2)
+
+/* Curriculum: immutable after load_syllabus(), shared by every student.
+   Strings point into the single interned string arena of the loaded syllabus image. */
 typedef struct {
-    char name[80];
+    const char *name;
     int credits;            // 0 for pass/fail (not counted in GPA)
-    int marks_obtained;
-    int grade_points;       // >=0 for normal mapping; -1 = P/F PASS; -2 = P/F FAIL
     int is_passfail;        // 1 if pass/fail (audit) subject
 } Subject;
 
 typedef struct {
     int sem_number;
-    Subject subjects[MAX_SUBJECTS];
+    Subject *subjects;
     int num_subjects;
-    float sgpa;
-    int is_completed;       // set after marks entered/calculation
-    int pf_failed;          // set if any P/F subject failed in this semester
-    int activity_points;    // per-semester
+    int first_subject;      // offset of this semester's row in a student's marks/grade_points
+    int scheme;             // index into grading_schemes
+    /* derived at load, read-only like the rest (see install_syllabus_image) */
+    int gpa_credits;                    // credits counted for GPA
+    int num_pf;                         // P/F subjects
+    const unsigned char *weight;        // [num_subjects] GPA credits, 0 for P/F subjects
+    const unsigned long long *pf_mask;  // [(num_subjects + 63) / 64] bit i: subject i is P/F
 } Semester;
 
 typedef struct {
-    char name[60];
-    char code[6];
-    Semester semesters[SEM_COUNT];
-    float cgpa;
+    const char *name;
+    const char *code;
+    Semester *semesters;
+    int num_semesters;
+    int num_subjects;       // over all semesters
 } Branch;
 
-Branch all_branches[MAX_BRANCHES];
+/* Bump allocator: memory is carved from large blocks and released all at once */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;
+} Arena;
+
+#define ARENA_BLOCK_SIZE (1u << 20)
+
+Arena syllabus_arena;           // all_branches and its semester/subject tables
+Branch *all_branches;
+int num_branches;
+
+/* A grading scheme precomputed for marks 0-100 (see load_grading_schemes) */
+typedef struct {
+    char name[32];
+    signed char grade_point[101];   // marks -> grade point
+    unsigned char pf_pass;          // P/F subjects pass at marks >= pf_pass
+    int num_steps;                  // the same table as thresholds, for the SIMD kernel:
+    unsigned char step_marks[101];  // grade point rises by step_gp[k] at marks >= step_marks[k]
+    unsigned char step_gp[101];
+} GradingScheme;
+
+GradingScheme *grading_schemes;
+int num_schemes;
+
+#define SEMESTER_SCHEME(syl) (&grading_schemes[(syl)->scheme])
+
+/* Per-student results: small integer arrays laid out like the branch syllabus, carved from an arena */
+typedef struct {
+    float sgpa;                     // approximate, for statistics; printed results use SGPA_X100
+    unsigned short credit_points;   // sum of grade points x credits for GPA subjects
+    unsigned char gpa_credits;      // credits counted for GPA in this semester
+    unsigned char is_completed;     // set after marks entered/calculation
+    unsigned char pf_failed;        // set if any P/F subject failed in this semester
+    unsigned char activity_points;  // per-semester, 0-150
+} SemesterResult;
+
+typedef struct {
+    char reg_no[16];
+    int branch;                                         // index into all_branches
+    float cgpa;                                         // approximate, for statistics; see CGPA_X100
+    int total_credit_points;                            // running totals over completed semesters,
+    int total_credits;                                  // updated by delta (see commit_semester_totals)
+    SemesterResult *sems;                               // [branch num_semesters]
+    unsigned char *marks;                               // [branch num_subjects] 0-100, MARKS_NOT_ENTERED if not entered
+    signed char *grade_points;                          // [branch num_subjects] >=0 normal; GP_PF_PASS / GP_PF_FAIL for P/F
+    const char *name;                                   // stored students only, NULL if not given
+} StudentRecord;
+
+/* One semester's row of a student's marks / grade points */
+#define STUDENT_MARKS(st, s) ((st)->marks + all_branches[(st)->branch].semesters[s].first_subject)
+#define STUDENT_GP(st, s)    ((st)->grade_points + all_branches[(st)->branch].semesters[s].first_subject)
+
+/* A cohort is a flat growable array of student records whose arrays live in the cohort's arena */
+typedef struct {
+    StudentRecord *students;
+    int count;
+    int capacity;
+    Arena arena;
+} Cohort;
+
+/* Column-major block of students of one branch/semester for bulk grading (see grade_block_run) */
+typedef struct {
+    int branch;
+    int sem_index;
+    int num_students;
+    int stride;                     // allocated students per column, multiple of GRADE_BLOCK_ALIGN
+    int max_subjects;               // columns allocated
+    int num_subjects;
+    int *credits;                   // [num_subjects] copied from the syllabus, 0 for P/F
+    int *is_passfail;               // [num_subjects]
+    int gpa_credits;                // credits counted for GPA in this semester
+    const GradingScheme *scheme;    // of the semester
+    unsigned char *marks;           // [num_subjects * stride] input, 0-100
+    signed char *grade_points;      // [num_subjects * stride] output, GP_PF_PASS / GP_PF_FAIL for P/F
+    int *credit_points;             // [stride] output, sum of grade points x credits
+    float *sgpa;                    // [stride] output
+    unsigned char *pf_failed;       // [stride] output
+} GradeBlock;
+
+/* Growable output buffer for rendered reports, flushed to fd with plain write() calls */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    FILE *file;                     // destination of ob_flush
+    int failed;                     // out of memory or write error
+} OutBuf;
+
+/* Secondary indexes over the stored cohort (see index_build): bitmaps hold one bit per cohort index */
+typedef struct {
+    int ready;
+    int max_semesters;
+    size_t words;                   // allocated 64-bit words per bitmap
+    unsigned long long **branch_bits;       // [num_branches] students of the branch
+    unsigned long long **completed_bits;    // [max_semesters] semester graded
+    unsigned long long **failed_bits;       // [max_semesters] a GPA subject at grade point 0
+    unsigned long long **pf_failed_bits;    // [max_semesters] a P/F subject failed
+    int *by_name;                   // cohort indices of named students, sorted by name
+    int num_named;
+    int names_dirty;                // by_name must be rebuilt before the next name lookup
+} StudentIndex;
+
+#define STUDENT_NAME_MAX 63
+#define QUERY_PASSED 1              // index_query filters on one semester
+#define QUERY_FAILED 2
+#define QUERY_PF_FAILED 3
+
+/* Students persisted under --store DIR, with a register-number index into the cohort */
+typedef struct {
+    Cohort cohort;
+    int *slots;                     // open-addressing table of cohort index + 1, 0 = empty
+    unsigned int num_slots;         // power of two
+    FILE *log;                      // marks.log, opened for append
+    long log_records;               // records in the log since the last snapshot
+    int pending;                    // records written but not yet fsync'ed
+    int sync_every;                 // group commit size
+    int is_open;
+    char dir[512];
+    StudentIndex index;
+} StudentStore;
+
+/* The student whose marks are being entered at the console, one per branch menu.
+   With a store open, console_store_index[b] selects the stored record instead (-1 = none). */
+Arena console_arena;
+StudentRecord *console_students;
+int *console_store_index;
+StudentStore student_store;
 
 /* Function prototypes */
 void initialize_branches();
-void preload_subjects_mbcet();
+int load_syllabus(const char *path);
+int load_grading_schemes(const char *path, int required);
+int compile_syllabus(const char *text_path, const char *bin_path);
+const char *map_file(const char *path, size_t *size, int *mapped);
+void unmap_file(const char *data, size_t size, int mapped);
 void show_main_menu();
+void find_student_menu();
 void select_semester(int branch_index);
 int get_grade_point(int marks);
 void calculate_sgpa_and_cgpa(int branch_index, int sem_index);
 void input_marks_and_calculate_sgpa(int branch_index, int sem_index);
 void display_report(int branch_index, int sem_index);
+void render_report(OutBuf *ob, const StudentRecord *st, int sem_index);
+int ob_flush(OutBuf *ob);
 int total_activity_points(int branch_index);
 int total_pf_failures(int branch_index);
 void show_branch_pf_summary(int branch_index);
+void revaluate_subject(int branch_index);
+void *arena_alloc(Arena *a, size_t size);
+void arena_free(Arena *a);
+int student_attach(StudentRecord *st, Arena *a, const char *reg_no, int branch_index);
+void student_init(StudentRecord *st, const char *reg_no, int branch_index);
+void set_subject_marks(StudentRecord *st, int sem_index, int subject_index, int marks);
+void update_pf_failed(StudentRecord *st, int sem_index);
+void grade_semester(StudentRecord *st, int sem_index);
+int sum_activity_points(const StudentRecord *st);
+int count_pf_failures(const StudentRecord *st);
+void cohort_init(Cohort *c);
+StudentRecord *cohort_add(Cohort *c, const char *reg_no, int branch_index);
+void cohort_free(Cohort *c);
+void update_cgpa(StudentRecord *st);
+void commit_semester_totals(StudentRecord *st, int sem_index, int credit_points, int credits);
+void apply_revaluation(StudentRecord *st, int sem_index, int subject_index, int marks);
+int grade_block_init(GradeBlock *blk, int branch_index, int sem_index, int capacity);
+void grade_block_select(GradeBlock *blk, int branch_index, int sem_index);
+void grade_block_free(GradeBlock *blk);
+void grade_block_scalar(GradeBlock *blk);
+void grade_block_run(GradeBlock *blk);
+int grade_block_compare(GradeBlock *blk);
+long cohort_grade(Cohort *c);
+int find_branch_by_code(const char *code);
+int run_batch(const char *in_path, const char *out_path, int threads);
+int run_batch_parallel(const char *in_path, const char *out_path, int threads);
+int run_reports(const char *in_path, const char *out_path, const char *dir);
+int run_bench(const char *scales);
+int run_analytics(const char *in_path, const char *out_path, int top_k);
+int run_archive_write(const char *in_path, const char *out_path);
+int run_archive_scan(const char *path, const char *out_path);
+int run_export(const char *out_path);
+int run_transcripts(const char *out, const char *template_path, int pdf, int threads);
+int run_serve(int port);
+int run_entry(int port);
+int run_plan(const char *in_path, const char *out_path, int target_x100);
+void what_if_planner(int branch_index);
+int run_revaluation(const char *in_path, const char *out_path);
+int count_backlogs(const StudentRecord *st);
+int gpa_x100(int credit_points, int credits);
+int gpa_text(char *buf, int x100);
+int run_verify_gpa(const char *in_path, const char *out_path);
+int load_eligibility_rules(const char *path, int required);
+unsigned long long eligibility_failures(const StudentRecord *st);
+int run_eligibility(const char *in_path, const char *out_path);
+StudentRecord *console_student(int branch_index);
+int store_open(StudentStore *ss, const char *dir, int sync_every);
+int store_sync(StudentStore *ss);
+int store_compact(StudentStore *ss);
+void store_close(StudentStore *ss);
+int student_index_find(const StudentStore *ss, const char *reg_no);
+StudentRecord *store_student(StudentStore *ss, const char *reg_no, int branch_index);
+int store_log_semester(StudentStore *ss, const StudentRecord *st, int sem_index);
+int store_log_revaluation(StudentStore *ss, const StudentRecord *st, int sem_index, int subject_index);
+int store_set_name(StudentStore *ss, StudentRecord *st, const char *name);
+int index_find_name_prefix(StudentStore *ss, const char *prefix, int *out, int max_out);
+int index_query(StudentStore *ss, int branch_index, int sem_index, int filter, int *out, int max_out);
 
-/* Initialize basic branch metadata and clear arrays */
+/* Per-branch setup driven by the loaded syllabus table (call after load_syllabus) */
 void initialize_branches() {
-    strcpy(all_branches[0].name, "Civil Engineering");                 strcpy(all_branches[0].code, "CE");
-    strcpy(all_branches[1].name, "Mechanical Engineering");            strcpy(all_branches[1].code, "ME");
-    strcpy(all_branches[2].name, "Electrical & Electronics Engg.");   strcpy(all_branches[2].code, "EEE");
-    strcpy(all_branches[3].name, "Electronics & Communication Engg.");strcpy(all_branches[3].code, "ECE");
-    strcpy(all_branches[4].name, "Computer Science & Engineering");   strcpy(all_branches[4].code, "CS");
-
-    for (int i = 0; i < MAX_BRANCHES; i++) {
-        all_branches[i].cgpa = 0.0f;
-        for (int s = 0; s < SEM_COUNT; s++) {
-            all_branches[i].semesters[s].sem_number = s + 1;
-            all_branches[i].semesters[s].sgpa = 0.0f;
-            all_branches[i].semesters[s].is_completed = 0;
-            all_branches[i].semesters[s].pf_failed = 0;
-            all_branches[i].semesters[s].num_subjects = 0;
-            all_branches[i].semesters[s].activity_points = 0;
-            for (int k = 0; k < MAX_SUBJECTS; k++) {
-                all_branches[i].semesters[s].subjects[k].name[0] = '\0';
-                all_branches[i].semesters[s].subjects[k].credits = 0;
-                all_branches[i].semesters[s].subjects[k].marks_obtained = -1;
-                all_branches[i].semesters[s].subjects[k].grade_points = 0;
-                all_branches[i].semesters[s].subjects[k].is_passfail = 0;
-            }
-        }
-    }
-}
-
-/* Preload subjects:
-   - Exact CE, ME, EEE, ECE and CS syllabi per user-provided lists.
-   - P/F subjects: is_passfail = 1, credits = 0 (they won't contribute to GPA)
-*/
-void preload_subjects_mbcet() {
-    /* ===========================
-       CE: exact syllabus per user input (index 0)
-       =========================== */
-    int b_ce = 0;
-    // S1 (Total Credits: 20)
-    Semester *ce_s1 = &all_branches[b_ce].semesters[0];
-    ce_s1->num_subjects = 9;
-    strcpy(ce_s1->subjects[0].name, "Linear Algebra and Calculus"); ce_s1->subjects[0].credits = 4; ce_s1->subjects[0].is_passfail = 0;
-    strcpy(ce_s1->subjects[1].name, "Engineering Chemistry"); ce_s1->subjects[1].credits = 4; ce_s1->subjects[1].is_passfail = 0;
-    strcpy(ce_s1->subjects[2].name, "Engineering Graphics"); ce_s1->subjects[2].credits = 3; ce_s1->subjects[2].is_passfail = 0;
-    strcpy(ce_s1->subjects[3].name, "Basics of Electrical Engineering B"); ce_s1->subjects[3].credits = 2; ce_s1->subjects[3].is_passfail = 0;
-    strcpy(ce_s1->subjects[4].name, "Basics of Mechanical Engineering"); ce_s1->subjects[4].credits = 2; ce_s1->subjects[4].is_passfail = 0;
-    strcpy(ce_s1->subjects[5].name, "Basics of Civil Engineering"); ce_s1->subjects[5].credits = 2; ce_s1->subjects[5].is_passfail = 0;
-    strcpy(ce_s1->subjects[6].name, "Environmental Science (P/F)"); ce_s1->subjects[6].credits = 0; ce_s1->subjects[6].is_passfail = 1;
-    strcpy(ce_s1->subjects[7].name, "Engineering Chemistry Lab"); ce_s1->subjects[7].credits = 1; ce_s1->subjects[7].is_passfail = 0;
-    strcpy(ce_s1->subjects[8].name, "Manufacturing and Construction Practices A"); ce_s1->subjects[8].credits = 1; ce_s1->subjects[8].is_passfail = 0;
-
-    // S2 (Total Credits: 20)
-    Semester *ce_s2 = &all_branches[b_ce].semesters[1];
-    ce_s2->num_subjects = 8;
-    strcpy(ce_s2->subjects[0].name, "Vector Calculus, Differential Equations and Transforms"); ce_s2->subjects[0].credits = 4; ce_s2->subjects[0].is_passfail = 0;
-    strcpy(ce_s2->subjects[1].name, "Engineering Physics"); ce_s2->subjects[1].credits = 4; ce_s2->subjects[1].is_passfail = 0;
-    strcpy(ce_s2->subjects[2].name, "Applied Mechanics"); ce_s2->subjects[2].credits = 3; ce_s2->subjects[2].is_passfail = 0;
-    strcpy(ce_s2->subjects[3].name, "Problem Solving and Programming"); ce_s2->subjects[3].credits = 3; ce_s2->subjects[3].is_passfail = 0;
-    strcpy(ce_s2->subjects[4].name, "Building Materials and Construction Technology"); ce_s2->subjects[4].credits = 3; ce_s2->subjects[4].is_passfail = 0;
-    strcpy(ce_s2->subjects[5].name, "Professional Communication (P/F)"); ce_s2->subjects[5].credits = 0; ce_s2->subjects[5].is_passfail = 1;
-    strcpy(ce_s2->subjects[6].name, "Engineering Physics Lab"); ce_s2->subjects[6].credits = 1; ce_s2->subjects[6].is_passfail = 0;
-    strcpy(ce_s2->subjects[7].name, "Design Studio I"); ce_s2->subjects[7].credits = 1; ce_s2->subjects[7].is_passfail = 0;
-
-    // S3 (Total Credits: 22)
-    Semester *ce_s3 = &all_branches[b_ce].semesters[2];
-    ce_s3->num_subjects = 9;
-    strcpy(ce_s3->subjects[0].name, "Partial Differential Equations and Complex Analysis"); ce_s3->subjects[0].credits = 4; ce_s3->subjects[0].is_passfail = 0;
-    strcpy(ce_s3->subjects[1].name, "Mechanics of Structures"); ce_s3->subjects[1].credits = 4; ce_s3->subjects[1].is_passfail = 0;
-    strcpy(ce_s3->subjects[2].name, "Fluid Mechanics and Hydraulics"); ce_s3->subjects[2].credits = 4; ce_s3->subjects[2].is_passfail = 0;
-    strcpy(ce_s3->subjects[3].name, "Surveying and Geomatics"); ce_s3->subjects[3].credits = 3; ce_s3->subjects[3].is_passfail = 0;
-    strcpy(ce_s3->subjects[4].name, "Design Engineering"); ce_s3->subjects[4].credits = 2; ce_s3->subjects[4].is_passfail = 0;
-    strcpy(ce_s3->subjects[5].name, "Professional Ethics (P/F)"); ce_s3->subjects[5].credits = 0; ce_s3->subjects[5].is_passfail = 1;
-    strcpy(ce_s3->subjects[6].name, "Fluid Mechanics Lab"); ce_s3->subjects[6].credits = 2; ce_s3->subjects[6].is_passfail = 0;
-    strcpy(ce_s3->subjects[7].name, "Surveying Lab"); ce_s3->subjects[7].credits = 2; ce_s3->subjects[7].is_passfail = 0;
-    strcpy(ce_s3->subjects[8].name, "Minor Course"); ce_s3->subjects[8].credits = 3; ce_s3->subjects[8].is_passfail = 0;
-
-    // S4 (Total Credits: 20)
-    Semester *ce_s4 = &all_branches[b_ce].semesters[3];
-    ce_s4->num_subjects = 8;
-    strcpy(ce_s4->subjects[0].name, "Probability, Statistics and Numerical Methods"); ce_s4->subjects[0].credits = 4; ce_s4->subjects[0].is_passfail = 0;
-    strcpy(ce_s4->subjects[1].name, "Structural Analysis"); ce_s4->subjects[1].credits = 4; ce_s4->subjects[1].is_passfail = 0;
-    strcpy(ce_s4->subjects[2].name, "Hydrology and Water Resources Engineering"); ce_s4->subjects[2].credits = 4; ce_s4->subjects[2].is_passfail = 0;
-    strcpy(ce_s4->subjects[3].name, "Water and Wastewater Engineering"); ce_s4->subjects[3].credits = 5; ce_s4->subjects[3].is_passfail = 0;
-    strcpy(ce_s4->subjects[4].name, "Universal Human Values II (P/F)"); ce_s4->subjects[4].credits = 0; ce_s4->subjects[4].is_passfail = 1;
-    strcpy(ce_s4->subjects[5].name, "Industrial Safety Engineering (P/F)"); ce_s4->subjects[5].credits = 0; ce_s4->subjects[5].is_passfail = 1;
-    strcpy(ce_s4->subjects[6].name, "Material Testing Lab I"); ce_s4->subjects[6].credits = 1; ce_s4->subjects[6].is_passfail = 0;
-    strcpy(ce_s4->subjects[7].name, "Minor/Honours Course"); ce_s4->subjects[7].credits = 3; ce_s4->subjects[7].is_passfail = 0;
-
-    // S5 (Total Credits: 25)
-    Semester *ce_s5 = &all_branches[b_ce].semesters[4];
-    ce_s5->num_subjects = 9;
-    strcpy(ce_s5->subjects[0].name, "Design of Reinforced Concrete Structures"); ce_s5->subjects[0].credits = 3; ce_s5->subjects[0].is_passfail = 0;
-    strcpy(ce_s5->subjects[1].name, "Applications of AI in Civil Engineering"); ce_s5->subjects[1].credits = 3; ce_s5->subjects[1].is_passfail = 0;
-    strcpy(ce_s5->subjects[2].name, "Soil Mechanics"); ce_s5->subjects[2].credits = 4; ce_s5->subjects[2].is_passfail = 0;
-    strcpy(ce_s5->subjects[3].name, "Transportation Engineering"); ce_s5->subjects[3].credits = 3; ce_s5->subjects[3].is_passfail = 0;
-    strcpy(ce_s5->subjects[4].name, "Quantity Surveying and Valuation"); ce_s5->subjects[4].credits = 5; ce_s5->subjects[4].is_passfail = 0;
-    strcpy(ce_s5->subjects[5].name, "Program Elective I"); ce_s5->subjects[5].credits = 3; ce_s5->subjects[5].is_passfail = 0;
-    strcpy(ce_s5->subjects[6].name, "Material Testing Lab II"); ce_s5->subjects[6].credits = 2; ce_s5->subjects[6].is_passfail = 0;
-    strcpy(ce_s5->subjects[7].name, "Transportation Engineering Lab"); ce_s5->subjects[7].credits = 2; ce_s5->subjects[7].is_passfail = 0;
-    strcpy(ce_s5->subjects[8].name, "Minor/Honours Course"); ce_s5->subjects[8].credits = 3; ce_s5->subjects[8].is_passfail = 0;
-
-    // S6 (Total Credits: 22)
-    Semester *ce_s6 = &all_branches[b_ce].semesters[5];
-    ce_s6->num_subjects = 9;
-    strcpy(ce_s6->subjects[0].name, "Design of Steel Structures"); ce_s6->subjects[0].credits = 4; ce_s6->subjects[0].is_passfail = 0;
-    strcpy(ce_s6->subjects[1].name, "Foundation Engineering"); ce_s6->subjects[1].credits = 3; ce_s6->subjects[1].is_passfail = 0;
-    strcpy(ce_s6->subjects[2].name, "Program Elective II"); ce_s6->subjects[2].credits = 3; ce_s6->subjects[2].is_passfail = 0;
-    strcpy(ce_s6->subjects[3].name, "Institute Elective I"); ce_s6->subjects[3].credits = 3; ce_s6->subjects[3].is_passfail = 0;
-    strcpy(ce_s6->subjects[4].name, "Business Economics and Accountancy"); ce_s6->subjects[4].credits = 3; ce_s6->subjects[4].is_passfail = 0;
-    strcpy(ce_s6->subjects[5].name, "Geotechnical Engineering Lab"); ce_s6->subjects[5].credits = 2; ce_s6->subjects[5].is_passfail = 0;
-    strcpy(ce_s6->subjects[6].name, "Design Studio II"); ce_s6->subjects[6].credits = 2; ce_s6->subjects[6].is_passfail = 0;
-    strcpy(ce_s6->subjects[7].name, "Seminar"); ce_s6->subjects[7].credits = 2; ce_s6->subjects[7].is_passfail = 0;
-    strcpy(ce_s6->subjects[8].name, "Minor/Honours Course"); ce_s6->subjects[8].credits = 3; ce_s6->subjects[8].is_passfail = 0;
-
-    // S7 (Total Credits: 21)
-    Semester *ce_s7 = &all_branches[b_ce].semesters[6];
-    ce_s7->num_subjects = 7;
-    strcpy(ce_s7->subjects[0].name, "Traffic Engineering and Management"); ce_s7->subjects[0].credits = 5; ce_s7->subjects[0].is_passfail = 0;
-    strcpy(ce_s7->subjects[1].name, "Program Elective III"); ce_s7->subjects[1].credits = 3; ce_s7->subjects[1].is_passfail = 0;
-    strcpy(ce_s7->subjects[2].name, "Construction Project Management"); ce_s7->subjects[2].credits = 4; ce_s7->subjects[2].is_passfail = 0;
-    strcpy(ce_s7->subjects[3].name, "Institute Elective II"); ce_s7->subjects[3].credits = 3; ce_s7->subjects[3].is_passfail = 0;
-    strcpy(ce_s7->subjects[4].name, "Comprehensive Course Viva"); ce_s7->subjects[4].credits = 1; ce_s7->subjects[4].is_passfail = 0;
-    strcpy(ce_s7->subjects[5].name, "Project"); ce_s7->subjects[5].credits = 5; ce_s7->subjects[5].is_passfail = 0;
-    strcpy(ce_s7->subjects[6].name, "Honours/Minor Course"); ce_s7->subjects[6].credits = 3; ce_s7->subjects[6].is_passfail = 0;
-
-    // S8 (Total Credits: 17)
-    Semester *ce_s8 = &all_branches[b_ce].semesters[7];
-    ce_s8->num_subjects = 5;
-    strcpy(ce_s8->subjects[0].name, "Integrated Waste Management"); ce_s8->subjects[0].credits = 3; ce_s8->subjects[0].is_passfail = 0;
-    strcpy(ce_s8->subjects[1].name, "Program Elective IV"); ce_s8->subjects[1].credits = 3; ce_s8->subjects[1].is_passfail = 0;
-    strcpy(ce_s8->subjects[2].name, "Program Elective V"); ce_s8->subjects[2].credits = 3; ce_s8->subjects[2].is_passfail = 0;
-    strcpy(ce_s8->subjects[3].name, "Program Elective VI"); ce_s8->subjects[3].credits = 3; ce_s8->subjects[3].is_passfail = 0;
-    strcpy(ce_s8->subjects[4].name, "Project"); ce_s8->subjects[4].credits = 5; ce_s8->subjects[4].is_passfail = 0;
-
-
-    /* ===========================
-       ME: exact syllabus per user input (index 1)
-       =========================== */
-    int b_me = 1;
-    // S1 (Total Credits: 18)
-    Semester *me_s1 = &all_branches[b_me].semesters[0];
-    me_s1->num_subjects = 8;
-    strcpy(me_s1->subjects[0].name, "Linear Algebra and Calculus"); me_s1->subjects[0].credits = 4; me_s1->subjects[0].is_passfail = 0;
-    strcpy(me_s1->subjects[1].name, "Engineering Chemistry"); me_s1->subjects[1].credits = 4; me_s1->subjects[1].is_passfail = 0;
-    strcpy(me_s1->subjects[2].name, "Engineering Graphics"); me_s1->subjects[2].credits = 3; me_s1->subjects[2].is_passfail = 0;
-    strcpy(me_s1->subjects[3].name, "Basics of Mechanical Engineering"); me_s1->subjects[3].credits = 2; me_s1->subjects[3].is_passfail = 0;
-    strcpy(me_s1->subjects[4].name, "Basics of Civil Engineering"); me_s1->subjects[4].credits = 2; me_s1->subjects[4].is_passfail = 0;
-    strcpy(me_s1->subjects[5].name, "Environmental Science (P/F)"); me_s1->subjects[5].credits = 0; me_s1->subjects[5].is_passfail = 1;
-    strcpy(me_s1->subjects[6].name, "Engineering Chemistry Lab"); me_s1->subjects[6].credits = 1; me_s1->subjects[6].is_passfail = 0;
-    strcpy(me_s1->subjects[7].name, "Manufacturing and Construction Practices A"); me_s1->subjects[7].credits = 1; me_s1->subjects[7].is_passfail = 0;
-
-    // S2 (Total Credits: 22)
-    Semester *me_s2 = &all_branches[b_me].semesters[1];
-    me_s2->num_subjects = 9;
-    strcpy(me_s2->subjects[0].name, "Vector Calculus, Differential Equations and Transforms"); me_s2->subjects[0].credits = 4; me_s2->subjects[0].is_passfail = 0;
-    strcpy(me_s2->subjects[1].name, "Engineering Physics"); me_s2->subjects[1].credits = 4; me_s2->subjects[1].is_passfail = 0;
-    strcpy(me_s2->subjects[2].name, "Engineering Mechanics"); me_s2->subjects[2].credits = 3; me_s2->subjects[2].is_passfail = 0;
-    strcpy(me_s2->subjects[3].name, "Problem Solving and Programming in C"); me_s2->subjects[3].credits = 4; me_s2->subjects[3].is_passfail = 0;
-    strcpy(me_s2->subjects[4].name, "Basics of Electrical Engineering A"); me_s2->subjects[4].credits = 2; me_s2->subjects[4].is_passfail = 0;
-    strcpy(me_s2->subjects[5].name, "Basics of Electronics Engineering"); me_s2->subjects[5].credits = 2; me_s2->subjects[5].is_passfail = 0;
-    strcpy(me_s2->subjects[6].name, "Professional Communication (P/F)"); me_s2->subjects[6].credits = 0; me_s2->subjects[6].is_passfail = 1;
-    strcpy(me_s2->subjects[7].name, "Engineering Physics Lab"); me_s2->subjects[7].credits = 1; me_s2->subjects[7].is_passfail = 0;
-    strcpy(me_s2->subjects[8].name, "Electrical and Electronics Workshop"); me_s2->subjects[8].credits = 1; me_s2->subjects[8].is_passfail = 0;
-
-    // S3 (Total Credits: 22)
-    Semester *me_s3 = &all_branches[b_me].semesters[2];
-    me_s3->num_subjects = 9;
-    strcpy(me_s3->subjects[0].name, "Partial Differential Equations and Complex Analysis"); me_s3->subjects[0].credits = 4; me_s3->subjects[0].is_passfail = 0;
-    strcpy(me_s3->subjects[1].name, "Mechanics of Solids"); me_s3->subjects[1].credits = 4; me_s3->subjects[1].is_passfail = 0;
-    strcpy(me_s3->subjects[2].name, "Engineering Thermodynamics"); me_s3->subjects[2].credits = 3; me_s3->subjects[2].is_passfail = 0;
-    strcpy(me_s3->subjects[3].name, "Metallurgy and Materials Science"); me_s3->subjects[3].credits = 4; me_s3->subjects[3].is_passfail = 0;
-    strcpy(me_s3->subjects[4].name, "Mechanics of Fluids"); me_s3->subjects[4].credits = 3; me_s3->subjects[4].is_passfail = 0;
-    strcpy(me_s3->subjects[5].name, "Computer Aided Machine Drawing"); me_s3->subjects[5].credits = 2; me_s3->subjects[5].is_passfail = 0;
-    strcpy(me_s3->subjects[6].name, "Professional Ethics (P/F)"); me_s3->subjects[6].credits = 0; me_s3->subjects[6].is_passfail = 1;
-    strcpy(me_s3->subjects[7].name, "Material Testing Lab"); me_s3->subjects[7].credits = 1; me_s3->subjects[7].is_passfail = 0;
-    strcpy(me_s3->subjects[8].name, "Minor Course"); me_s3->subjects[8].credits = 3; me_s3->subjects[8].is_passfail = 0;
-
-    // S4 (Total Credits: 21)
-    Semester *me_s4 = &all_branches[b_me].semesters[3];
-    me_s4->num_subjects = 9;
-    strcpy(me_s4->subjects[0].name, "Probability, Statistics and Numerical Methods"); me_s4->subjects[0].credits = 4; me_s4->subjects[0].is_passfail = 0;
-    strcpy(me_s4->subjects[1].name, "Mechanics of Machinery"); me_s4->subjects[1].credits = 4; me_s4->subjects[1].is_passfail = 0;
-    strcpy(me_s4->subjects[2].name, "Fluid Machinery"); me_s4->subjects[2].credits = 4; me_s4->subjects[2].is_passfail = 0;
-    strcpy(me_s4->subjects[3].name, "Manufacturing Processes"); me_s4->subjects[3].credits = 4; me_s4->subjects[3].is_passfail = 0;
-    strcpy(me_s4->subjects[4].name, "Universal Human Values II (P/F)"); me_s4->subjects[4].credits = 0; me_s4->subjects[4].is_passfail = 1;
-    strcpy(me_s4->subjects[5].name, "Industrial Safety Engineering (P/F)"); me_s4->subjects[5].credits = 0; me_s4->subjects[5].is_passfail = 1;
-    strcpy(me_s4->subjects[6].name, "Hydraulic Machines Lab"); me_s4->subjects[6].credits = 2; me_s4->subjects[6].is_passfail = 0;
-    strcpy(me_s4->subjects[7].name, "Machine Tools Lab"); me_s4->subjects[7].credits = 1; me_s4->subjects[7].is_passfail = 0;
-    strcpy(me_s4->subjects[8].name, "Minor/Honours Course"); me_s4->subjects[8].credits = 3; me_s4->subjects[8].is_passfail = 0;
-
-    // S5 (Total Credits: 23)
-    Semester *me_s5 = &all_branches[b_me].semesters[4];
-    me_s5->num_subjects = 9;
-    strcpy(me_s5->subjects[0].name, "Dynamics and Design of Machinery"); me_s5->subjects[0].credits = 4; me_s5->subjects[0].is_passfail = 0;
-    strcpy(me_s5->subjects[1].name, "Thermal Engineering"); me_s5->subjects[1].credits = 4; me_s5->subjects[1].is_passfail = 0;
-    strcpy(me_s5->subjects[2].name, "Machine Tools and Metrology"); me_s5->subjects[2].credits = 4; me_s5->subjects[2].is_passfail = 0;
-    strcpy(me_s5->subjects[3].name, "Production and Operations Management"); me_s5->subjects[3].credits = 3; me_s5->subjects[3].is_passfail = 0;
-    strcpy(me_s5->subjects[4].name, "Program Elective I (Management Course)"); me_s5->subjects[4].credits = 3; me_s5->subjects[4].is_passfail = 0;
-    strcpy(me_s5->subjects[5].name, "Design Engineering"); me_s5->subjects[5].credits = 2; me_s5->subjects[5].is_passfail = 0;
-    strcpy(me_s5->subjects[6].name, "Metrology and Instrumentation Lab"); me_s5->subjects[6].credits = 1; me_s5->subjects[6].is_passfail = 0;
-    strcpy(me_s5->subjects[7].name, "Thermal Engineering Lab"); me_s5->subjects[7].credits = 2; me_s5->subjects[7].is_passfail = 0;
-    strcpy(me_s5->subjects[8].name, "Minor/Honours Course"); me_s5->subjects[8].credits = 3; me_s5->subjects[8].is_passfail = 0;
-
-    // S6 (Total Credits: 22)
-    Semester *me_s6 = &all_branches[b_me].semesters[5];
-    me_s6->num_subjects = 9;
-    strcpy(me_s6->subjects[0].name, "Heat and Mass Transfer"); me_s6->subjects[0].credits = 4; me_s6->subjects[0].is_passfail = 0;
-    strcpy(me_s6->subjects[1].name, "Computer Aided Design and FEM"); me_s6->subjects[1].credits = 4; me_s6->subjects[1].is_passfail = 0;
-    strcpy(me_s6->subjects[2].name, "Mechatronics and Control Systems"); me_s6->subjects[2].credits = 4; me_s6->subjects[2].is_passfail = 0;
-    strcpy(me_s6->subjects[3].name, "Institute Elective I"); me_s6->subjects[3].credits = 3; me_s6->subjects[3].is_passfail = 0;
-    strcpy(me_s6->subjects[4].name, "Business Economics and Accountancy"); me_s6->subjects[4].credits = 3; me_s6->subjects[4].is_passfail = 0;
-    strcpy(me_s6->subjects[5].name, "Heat Transfer Lab"); me_s6->subjects[5].credits = 2; me_s6->subjects[5].is_passfail = 0;
-    strcpy(me_s6->subjects[6].name, "Seminar"); me_s6->subjects[6].credits = 2; me_s6->subjects[6].is_passfail = 0;
-    strcpy(me_s6->subjects[7].name, "Minor/Honours Course"); me_s6->subjects[7].credits = 3; me_s6->subjects[7].is_passfail = 0;
-    strcpy(me_s6->subjects[8].name, ""); me_s6->subjects[8].credits = 0; me_s6->subjects[8].is_passfail = 0;
-
-    // S7 (Total Credits: 22)
-    Semester *me_s7 = &all_branches[b_me].semesters[6];
-    me_s7->num_subjects = 8;
-    strcpy(me_s7->subjects[0].name, "Design of Machine Elements"); me_s7->subjects[0].credits = 4; me_s7->subjects[0].is_passfail = 0;
-    strcpy(me_s7->subjects[1].name, "Robotics and Automation"); me_s7->subjects[1].credits = 4; me_s7->subjects[1].is_passfail = 0;
-    strcpy(me_s7->subjects[2].name, "Program Elective II"); me_s7->subjects[2].credits = 3; me_s7->subjects[2].is_passfail = 0;
-    strcpy(me_s7->subjects[3].name, "Institute Elective II"); me_s7->subjects[3].credits = 3; me_s7->subjects[3].is_passfail = 0;
-    strcpy(me_s7->subjects[4].name, "Mechanical Engineering Lab"); me_s7->subjects[4].credits = 2; me_s7->subjects[4].is_passfail = 0;
-    strcpy(me_s7->subjects[5].name, "Comprehensive Viva Voce"); me_s7->subjects[5].credits = 1; me_s7->subjects[5].is_passfail = 0;
-    strcpy(me_s7->subjects[6].name, "Project"); me_s7->subjects[6].credits = 5; me_s7->subjects[6].is_passfail = 0;
-    strcpy(me_s7->subjects[7].name, "Minor/Honours Course"); me_s7->subjects[7].credits = 3; me_s7->subjects[7].is_passfail = 0;
-
-    // S8 (Total Credits: 17)
-    Semester *me_s8 = &all_branches[b_me].semesters[7];
-    me_s8->num_subjects = 5;
-    strcpy(me_s8->subjects[0].name, "Program Elective III"); me_s8->subjects[0].credits = 3; me_s8->subjects[0].is_passfail = 0;
-    strcpy(me_s8->subjects[1].name, "Program Elective IV (Management Course)"); me_s8->subjects[1].credits = 3; me_s8->subjects[1].is_passfail = 0;
-    strcpy(me_s8->subjects[2].name, "Program Elective V"); me_s8->subjects[2].credits = 3; me_s8->subjects[2].is_passfail = 0;
-    strcpy(me_s8->subjects[3].name, "Program Elective VI"); me_s8->subjects[3].credits = 3; me_s8->subjects[3].is_passfail = 0;
-    strcpy(me_s8->subjects[4].name, "Project"); me_s8->subjects[4].credits = 5; me_s8->subjects[4].is_passfail = 0;
-
-
-    /* ===========================
-       EEE: exact syllabus per user input (index 2)
-       =========================== */
-    int b_eee = 2;
-    // S1 (Total Credits: 19)
-    Semester *ee_s1 = &all_branches[b_eee].semesters[0];
-    ee_s1->num_subjects = 7;
-    strcpy(ee_s1->subjects[0].name, "Linear Algebra and Calculus"); ee_s1->subjects[0].credits = 4; ee_s1->subjects[0].is_passfail = 0;
-    strcpy(ee_s1->subjects[1].name, "Engineering Chemistry"); ee_s1->subjects[1].credits = 4; ee_s1->subjects[1].is_passfail = 0;
-    strcpy(ee_s1->subjects[2].name, "Engineering Graphics"); ee_s1->subjects[2].credits = 3; ee_s1->subjects[2].is_passfail = 0;
-    strcpy(ee_s1->subjects[3].name, "Problem Solving and Programming in C"); ee_s1->subjects[3].credits = 4; ee_s1->subjects[3].is_passfail = 0;
-    strcpy(ee_s1->subjects[4].name, "Environmental Science (P/F)"); ee_s1->subjects[4].credits = 0; ee_s1->subjects[4].is_passfail = 1;
-    strcpy(ee_s1->subjects[5].name, "Engineering Chemistry Lab"); ee_s1->subjects[5].credits = 1; ee_s1->subjects[5].is_passfail = 0;
-    strcpy(ee_s1->subjects[6].name, "Manufacturing and Construction Practices B"); ee_s1->subjects[6].credits = 2; ee_s1->subjects[6].is_passfail = 0;
-
-    // S2 (Total Credits: 21)
-    Semester *ee_s2 = &all_branches[b_eee].semesters[1];
-    ee_s2->num_subjects = 9;
-    strcpy(ee_s2->subjects[0].name, "Vector Calculus, Differential Equations and Transforms"); ee_s2->subjects[0].credits = 4; ee_s2->subjects[0].is_passfail = 0;
-    strcpy(ee_s2->subjects[1].name, "Engineering Physics"); ee_s2->subjects[1].credits = 4; ee_s2->subjects[1].is_passfail = 0;
-    strcpy(ee_s2->subjects[2].name, "Engineering Mechanics"); ee_s2->subjects[2].credits = 3; ee_s2->subjects[2].is_passfail = 0;
-    strcpy(ee_s2->subjects[3].name, "Python Programming"); ee_s2->subjects[3].credits = 3; ee_s2->subjects[3].is_passfail = 0;
-    strcpy(ee_s2->subjects[4].name, "Basics of Electrical Engineering A"); ee_s2->subjects[4].credits = 2; ee_s2->subjects[4].is_passfail = 0;
-    strcpy(ee_s2->subjects[5].name, "Basics of Electronics Engineering"); ee_s2->subjects[5].credits = 2; ee_s2->subjects[5].is_passfail = 0;
-    strcpy(ee_s2->subjects[6].name, "Professional Communication (P/F)"); ee_s2->subjects[6].credits = 0; ee_s2->subjects[6].is_passfail = 1;
-    strcpy(ee_s2->subjects[7].name, "Engineering Physics Lab"); ee_s2->subjects[7].credits = 1; ee_s2->subjects[7].is_passfail = 0;
-    strcpy(ee_s2->subjects[8].name, "Electrical and Electronics Workshop"); ee_s2->subjects[8].credits = 1; ee_s2->subjects[8].is_passfail = 0;
-
-    // S3 (Total Credits: 23)
-    Semester *ee_s3 = &all_branches[b_eee].semesters[2];
-    ee_s3->num_subjects = 9;
-    strcpy(ee_s3->subjects[0].name, "Discrete Mathematical Structures"); ee_s3->subjects[0].credits = 4; ee_s3->subjects[0].is_passfail = 0;
-    strcpy(ee_s3->subjects[1].name, "Instrumentation Systems"); ee_s3->subjects[1].credits = 4; ee_s3->subjects[1].is_passfail = 0;
-    strcpy(ee_s3->subjects[2].name, "Data Structures"); ee_s3->subjects[2].credits = 4; ee_s3->subjects[2].is_passfail = 0;
-    strcpy(ee_s3->subjects[3].name, "Electric Circuit Analysis"); ee_s3->subjects[3].credits = 4; ee_s3->subjects[3].is_passfail = 0;
-    strcpy(ee_s3->subjects[4].name, "Design Engineering"); ee_s3->subjects[4].credits = 2; ee_s3->subjects[4].is_passfail = 0;
-    strcpy(ee_s3->subjects[5].name, "Professional Ethics (P/F)"); ee_s3->subjects[5].credits = 0; ee_s3->subjects[5].is_passfail = 1;
-    strcpy(ee_s3->subjects[6].name, "Data Structures Lab"); ee_s3->subjects[6].credits = 2; ee_s3->subjects[6].is_passfail = 0;
-    strcpy(ee_s3->subjects[7].name, "Instrumentation Lab"); ee_s3->subjects[7].credits = 2; ee_s3->subjects[7].is_passfail = 0;
-    strcpy(ee_s3->subjects[8].name, "Minor Course"); ee_s3->subjects[8].credits = 3; ee_s3->subjects[8].is_passfail = 0;
-
-    // S4 (Total Credits: 21)
-    Semester *ee_s4 = &all_branches[b_eee].semesters[3];
-    ee_s4->num_subjects = 8;
-    strcpy(ee_s4->subjects[0].name, "Probability, Statistics and Numerical Methods"); ee_s4->subjects[0].credits = 4; ee_s4->subjects[0].is_passfail = 0;
-    strcpy(ee_s4->subjects[1].name, "Computer Organization and Architecture"); ee_s4->subjects[1].credits = 4; ee_s4->subjects[1].is_passfail = 0;
-    strcpy(ee_s4->subjects[2].name, "Object Oriented Programming using Java"); ee_s4->subjects[2].credits = 5; ee_s4->subjects[2].is_passfail = 0;
-    strcpy(ee_s4->subjects[3].name, "Digital Electronics and Logic Design"); ee_s4->subjects[3].credits = 4; ee_s4->subjects[3].is_passfail = 0;
-    strcpy(ee_s4->subjects[4].name, "Universal Human Values II (P/F)"); ee_s4->subjects[4].credits = 0; ee_s4->subjects[4].is_passfail = 1;
-    strcpy(ee_s4->subjects[5].name, "Industrial Safety Engineering (P/F)"); ee_s4->subjects[5].credits = 0; ee_s4->subjects[5].is_passfail = 1;
-    strcpy(ee_s4->subjects[6].name, "Digital Electronics and Logic Design Lab"); ee_s4->subjects[6].credits = 2; ee_s4->subjects[6].is_passfail = 0;
-    strcpy(ee_s4->subjects[7].name, "Minor/Honours Course"); ee_s4->subjects[7].credits = 3; ee_s4->subjects[7].is_passfail = 0;
-
-    // S5 (Total Credits: 21)
-    Semester *ee_s5 = &all_branches[b_eee].semesters[4];
-    ee_s5->num_subjects = 8;
-    strcpy(ee_s5->subjects[0].name, "Database Management Systems"); ee_s5->subjects[0].credits = 4; ee_s5->subjects[0].is_passfail = 0;
-    strcpy(ee_s5->subjects[1].name, "Microprocessors and Embedded Systems"); ee_s5->subjects[1].credits = 5; ee_s5->subjects[1].is_passfail = 0;
-    strcpy(ee_s5->subjects[2].name, "Electrical Machines"); ee_s5->subjects[2].credits = 4; ee_s5->subjects[2].is_passfail = 0;
-    strcpy(ee_s5->subjects[3].name, "Business Economics and Accountancy"); ee_s5->subjects[3].credits = 3; ee_s5->subjects[3].is_passfail = 0;
-    strcpy(ee_s5->subjects[4].name, "Program Elective I"); ee_s5->subjects[4].credits = 3; ee_s5->subjects[4].is_passfail = 0;
-    strcpy(ee_s5->subjects[5].name, "Electrical Machines Lab"); ee_s5->subjects[5].credits = 1; ee_s5->subjects[5].is_passfail = 0;
-    strcpy(ee_s5->subjects[6].name, "Database Management Systems Lab"); ee_s5->subjects[6].credits = 1; ee_s5->subjects[6].is_passfail = 0;
-    strcpy(ee_s5->subjects[7].name, "Minor/Honours Course"); ee_s5->subjects[7].credits = 3; ee_s5->subjects[7].is_passfail = 0;
-
-    // S6 (Total Credits: 22)
-    Semester *ee_s6 = &all_branches[b_eee].semesters[5];
-    ee_s6->num_subjects = 9;
-    strcpy(ee_s6->subjects[0].name, "Power Electronics"); ee_s6->subjects[0].credits = 4; ee_s6->subjects[0].is_passfail = 0;
-    strcpy(ee_s6->subjects[1].name, "Algorithm Analysis and Design"); ee_s6->subjects[1].credits = 4; ee_s6->subjects[1].is_passfail = 0;
-    strcpy(ee_s6->subjects[2].name, "Computer Communication and Network Security"); ee_s6->subjects[2].credits = 3; ee_s6->subjects[2].is_passfail = 0;
-    strcpy(ee_s6->subjects[3].name, "Program Elective II"); ee_s6->subjects[3].credits = 3; ee_s6->subjects[3].is_passfail = 0;
-    strcpy(ee_s6->subjects[4].name, "Institute Elective I"); ee_s6->subjects[4].credits = 3; ee_s6->subjects[4].is_passfail = 0;
-    strcpy(ee_s6->subjects[5].name, "Networking Lab"); ee_s6->subjects[5].credits = 1; ee_s6->subjects[5].is_passfail = 0;
-    strcpy(ee_s6->subjects[6].name, "Seminar"); ee_s6->subjects[6].credits = 2; ee_s6->subjects[6].is_passfail = 0;
-    strcpy(ee_s6->subjects[7].name, "Mini Project"); ee_s6->subjects[7].credits = 2; ee_s6->subjects[7].is_passfail = 0;
-    strcpy(ee_s6->subjects[8].name, "Minor/Honours Course"); ee_s6->subjects[8].credits = 3; ee_s6->subjects[8].is_passfail = 0;
-
-    // S7 (Total Credits: 23)
-    Semester *ee_s7 = &all_branches[b_eee].semesters[6];
-    ee_s7->num_subjects = 8;
-    strcpy(ee_s7->subjects[0].name, "Control Systems"); ee_s7->subjects[0].credits = 4; ee_s7->subjects[0].is_passfail = 0;
-    strcpy(ee_s7->subjects[1].name, "Power System Engineering"); ee_s7->subjects[1].credits = 4; ee_s7->subjects[1].is_passfail = 0;
-    strcpy(ee_s7->subjects[2].name, "Internet of Things"); ee_s7->subjects[2].credits = 3; ee_s7->subjects[2].is_passfail = 0;
-    strcpy(ee_s7->subjects[3].name, "Program Elective III"); ee_s7->subjects[3].credits = 3; ee_s7->subjects[3].is_passfail = 0;
-    strcpy(ee_s7->subjects[4].name, "Institute Elective II"); ee_s7->subjects[4].credits = 3; ee_s7->subjects[4].is_passfail = 0;
-    strcpy(ee_s7->subjects[5].name, "Comprehensive Course Viva"); ee_s7->subjects[5].credits = 1; ee_s7->subjects[5].is_passfail = 0;
-    strcpy(ee_s7->subjects[6].name, "Project"); ee_s7->subjects[6].credits = 5; ee_s7->subjects[6].is_passfail = 0;
-    strcpy(ee_s7->subjects[7].name, "Minor/Honours Course"); ee_s7->subjects[7].credits = 3; ee_s7->subjects[7].is_passfail = 0;
-
-    // S8 (Total Credits: 17)
-    Semester *ee_s8 = &all_branches[b_eee].semesters[7];
-    ee_s8->num_subjects = 5;
-    strcpy(ee_s8->subjects[0].name, "Program Elective IV"); ee_s8->subjects[0].credits = 3; ee_s8->subjects[0].is_passfail = 0;
-    strcpy(ee_s8->subjects[1].name, "Program Elective V"); ee_s8->subjects[1].credits = 3; ee_s8->subjects[1].is_passfail = 0;
-    strcpy(ee_s8->subjects[2].name, "Program Elective VI"); ee_s8->subjects[2].credits = 3; ee_s8->subjects[2].is_passfail = 0;
-    strcpy(ee_s8->subjects[3].name, "Management for Engineers"); ee_s8->subjects[3].credits = 3; ee_s8->subjects[3].is_passfail = 0;
-    strcpy(ee_s8->subjects[4].name, "Project"); ee_s8->subjects[4].credits = 5; ee_s8->subjects[4].is_passfail = 0;
-
-
-    /* ===========================
-       ECE: exact syllabus per user input (index 3)
-       (Retained from earlier; P/F flagged)
-       =========================== */
-    int b_ece = 3;
-    // S1 (Total Credits: 19). P/F: Environmental Science (1 credit)
-    Semester *e_s1 = &all_branches[b_ece].semesters[0];
-    e_s1->num_subjects = 8;
-    strcpy(e_s1->subjects[0].name, "Linear Algebra and Calculus"); e_s1->subjects[0].credits = 4; e_s1->subjects[0].is_passfail = 0;
-    strcpy(e_s1->subjects[1].name, "Engineering Physics"); e_s1->subjects[1].credits = 4; e_s1->subjects[1].is_passfail = 0;
-    strcpy(e_s1->subjects[2].name, "Problem Solving and Programming in C"); e_s1->subjects[2].credits = 4; e_s1->subjects[2].is_passfail = 0;
-    strcpy(e_s1->subjects[3].name, "Basics of Electrical Engineering A"); e_s1->subjects[3].credits = 2; e_s1->subjects[3].is_passfail = 0;
-    strcpy(e_s1->subjects[4].name, "Basics of Electronics Engineering"); e_s1->subjects[4].credits = 2; e_s1->subjects[4].is_passfail = 0;
-    strcpy(e_s1->subjects[5].name, "Environmental Science (P/F)"); e_s1->subjects[5].credits = 0; e_s1->subjects[5].is_passfail = 1;
-    strcpy(e_s1->subjects[6].name, "Engineering Physics Lab"); e_s1->subjects[6].credits = 1; e_s1->subjects[6].is_passfail = 0;
-    strcpy(e_s1->subjects[7].name, "Electrical and Electronics Workshop"); e_s1->subjects[7].credits = 1; e_s1->subjects[7].is_passfail = 0;
-
-    // S2 (Total Credits: 22). P/F: Professional Communication (1)
-    Semester *e_s2 = &all_branches[b_ece].semesters[1];
-    e_s2->num_subjects = 8;
-    strcpy(e_s2->subjects[0].name, "Vector Calculus, Differential Equations and Transforms"); e_s2->subjects[0].credits = 4; e_s2->subjects[0].is_passfail = 0;
-    strcpy(e_s2->subjects[1].name, "Engineering Chemistry"); e_s2->subjects[1].credits = 4; e_s2->subjects[1].is_passfail = 0;
-    strcpy(e_s2->subjects[2].name, "Engineering Graphics"); e_s2->subjects[2].credits = 3; e_s2->subjects[2].is_passfail = 0;
-    strcpy(e_s2->subjects[3].name, "Python Programming"); e_s2->subjects[3].credits = 3; e_s2->subjects[3].is_passfail = 0;
-    strcpy(e_s2->subjects[4].name, "Network Theory"); e_s2->subjects[4].credits = 4; e_s2->subjects[4].is_passfail = 0;
-    strcpy(e_s2->subjects[5].name, "Engineering Chemistry Lab"); e_s2->subjects[5].credits = 1; e_s2->subjects[5].is_passfail = 0;
-    strcpy(e_s2->subjects[6].name, "Manufacturing and Construction Practices B"); e_s2->subjects[6].credits = 2; e_s2->subjects[6].is_passfail = 0;
-    strcpy(e_s2->subjects[7].name, "Professional Communication (P/F)"); e_s2->subjects[7].credits = 0; e_s2->subjects[7].is_passfail = 1;
-
-    // S3 (Total Credits: 23). P/F: Professional Ethics (1)
-    Semester *e_s3 = &all_branches[b_ece].semesters[2];
-    e_s3->num_subjects = 8;
-    strcpy(e_s3->subjects[0].name, "Partial Differential Equation and Complex Analysis"); e_s3->subjects[0].credits = 4; e_s3->subjects[0].is_passfail = 0;
-    strcpy(e_s3->subjects[1].name, "Analog Circuits"); e_s3->subjects[1].credits = 4; e_s3->subjects[1].is_passfail = 0;
-    strcpy(e_s3->subjects[2].name, "Solid State Devices"); e_s3->subjects[2].credits = 4; e_s3->subjects[2].is_passfail = 0;
-    strcpy(e_s3->subjects[3].name, "Logic Circuit Design"); e_s3->subjects[3].credits = 4; e_s3->subjects[3].is_passfail = 0;
-    strcpy(e_s3->subjects[4].name, "Design Engineering"); e_s3->subjects[4].credits = 2; e_s3->subjects[4].is_passfail = 0;
-    strcpy(e_s3->subjects[5].name, "Professional Ethics (P/F)"); e_s3->subjects[5].credits = 0; e_s3->subjects[5].is_passfail = 1;
-    strcpy(e_s3->subjects[6].name, "Analog Circuits Lab"); e_s3->subjects[6].credits = 2; e_s3->subjects[6].is_passfail = 0;
-    strcpy(e_s3->subjects[7].name, "Logic Circuit Design Lab"); e_s3->subjects[7].credits = 2; e_s3->subjects[7].is_passfail = 0;
-
-    // S4 (Total Credits: 21). P/F: Universal Human Values II (1), Industrial Safety Engineering (1)
-    Semester *e_s4 = &all_branches[b_ece].semesters[3];
-    e_s4->num_subjects = 7;
-    strcpy(e_s4->subjects[0].name, "Probability, Random Processes and Numerical Methods"); e_s4->subjects[0].credits = 4; e_s4->subjects[0].is_passfail = 0;
-    strcpy(e_s4->subjects[1].name, "Linear Integrated Circuits"); e_s4->subjects[1].credits = 4; e_s4->subjects[1].is_passfail = 0;
-    strcpy(e_s4->subjects[2].name, "Signals and Systems"); e_s4->subjects[2].credits = 4; e_s4->subjects[2].is_passfail = 0;
-    strcpy(e_s4->subjects[3].name, "Microcontroller Based System Design"); e_s4->subjects[3].credits = 5; e_s4->subjects[3].is_passfail = 0;
-    strcpy(e_s4->subjects[4].name, "Linear Integrated Circuits Lab"); e_s4->subjects[4].credits = 2; e_s4->subjects[4].is_passfail = 0;
-    strcpy(e_s4->subjects[5].name, "Universal Human Values II (P/F)"); e_s4->subjects[5].credits = 0; e_s4->subjects[5].is_passfail = 1;
-    strcpy(e_s4->subjects[6].name, "Industrial Safety Engineering (P/F)"); e_s4->subjects[6].credits = 0; e_s4->subjects[6].is_passfail = 1;
-
-    // S5 (Total Credits: 22)
-    Semester *e_s5 = &all_branches[b_ece].semesters[4];
-    e_s5->num_subjects = 7;
-    strcpy(e_s5->subjects[0].name, "Analog and Digital Communication"); e_s5->subjects[0].credits = 4; e_s5->subjects[0].is_passfail = 0;
-    strcpy(e_s5->subjects[1].name, "Digital Signal Processing"); e_s5->subjects[1].credits = 4; e_s5->subjects[1].is_passfail = 0;
-    strcpy(e_s5->subjects[2].name, "Electromagnetic Field Theory"); e_s5->subjects[2].credits = 4; e_s5->subjects[2].is_passfail = 0;
-    strcpy(e_s5->subjects[3].name, "Program Elective I"); e_s5->subjects[3].credits = 3; e_s5->subjects[3].is_passfail = 0;
-    strcpy(e_s5->subjects[4].name, "Management for Engineers"); e_s5->subjects[4].credits = 3; e_s5->subjects[4].is_passfail = 0;
-    strcpy(e_s5->subjects[5].name, "Communication Lab"); e_s5->subjects[5].credits = 2; e_s5->subjects[5].is_passfail = 0;
-    strcpy(e_s5->subjects[6].name, "Digital Signal Processing Lab"); e_s5->subjects[6].credits = 2; e_s5->subjects[6].is_passfail = 0;
-
-    // S6 (Total Credits: 22)
-    Semester *e_s6 = &all_branches[b_ece].semesters[5];
-    e_s6->num_subjects = 7;
-    strcpy(e_s6->subjects[0].name, "Control Systems"); e_s6->subjects[0].credits = 4; e_s6->subjects[0].is_passfail = 0;
-    strcpy(e_s6->subjects[1].name, "VLSI Circuit Design"); e_s6->subjects[1].credits = 5; e_s6->subjects[1].is_passfail = 0;
-    strcpy(e_s6->subjects[2].name, "Program Elective II"); e_s6->subjects[2].credits = 3; e_s6->subjects[2].is_passfail = 0;
-    strcpy(e_s6->subjects[3].name, "Institute Elective I"); e_s6->subjects[3].credits = 3; e_s6->subjects[3].is_passfail = 0;
-    strcpy(e_s6->subjects[4].name, "Business Economics and Accountancy"); e_s6->subjects[4].credits = 3; e_s6->subjects[4].is_passfail = 0;
-    strcpy(e_s6->subjects[5].name, "Seminar"); e_s6->subjects[5].credits = 2; e_s6->subjects[5].is_passfail = 0;
-    strcpy(e_s6->subjects[6].name, "Mini Project"); e_s6->subjects[6].credits = 2; e_s6->subjects[6].is_passfail = 0;
-
-    // S7 (Total Credits: 24)
-    Semester *e_s7 = &all_branches[b_ece].semesters[6];
-    e_s7->num_subjects = 8;
-    strcpy(e_s7->subjects[0].name, "Information Theory and Coding"); e_s7->subjects[0].credits = 4; e_s7->subjects[0].is_passfail = 0;
-    strcpy(e_s7->subjects[1].name, "Wireless Communication"); e_s7->subjects[1].credits = 3; e_s7->subjects[1].is_passfail = 0;
-    strcpy(e_s7->subjects[2].name, "Computer Networks"); e_s7->subjects[2].credits = 3; e_s7->subjects[2].is_passfail = 0;
-    strcpy(e_s7->subjects[3].name, "Program Elective III"); e_s7->subjects[3].credits = 3; e_s7->subjects[3].is_passfail = 0;
-    strcpy(e_s7->subjects[4].name, "Institute Elective II"); e_s7->subjects[4].credits = 3; e_s7->subjects[4].is_passfail = 0;
-    strcpy(e_s7->subjects[5].name, "Comprehensive Course Viva"); e_s7->subjects[5].credits = 1; e_s7->subjects[5].is_passfail = 0;
-    strcpy(e_s7->subjects[6].name, "Project"); e_s7->subjects[6].credits = 5; e_s7->subjects[6].is_passfail = 0;
-    strcpy(e_s7->subjects[7].name, "Advanced Communication Lab"); e_s7->subjects[7].credits = 2; e_s7->subjects[7].is_passfail = 0;
-
-    // S8 (Total Credits: 14)
-    Semester *e_s8 = &all_branches[b_ece].semesters[7];
-    e_s8->num_subjects = 4;
-    strcpy(e_s8->subjects[0].name, "Program Elective IV"); e_s8->subjects[0].credits = 3; e_s8->subjects[0].is_passfail = 0;
-    strcpy(e_s8->subjects[1].name, "Program Elective V"); e_s8->subjects[1].credits = 3; e_s8->subjects[1].is_passfail = 0;
-    strcpy(e_s8->subjects[2].name, "Program Elective VI"); e_s8->subjects[2].credits = 3; e_s8->subjects[2].is_passfail = 0;
-    strcpy(e_s8->subjects[3].name, "Project"); e_s8->subjects[3].credits = 5; e_s8->subjects[3].is_passfail = 0;
-
-
-    /* ===========================
-       CS: exact syllabus per user input (index 4), minors/honours removed
-       =========================== */
-    int b_cs = 4;
-    // S1 (Total Credits: 19)
-    Semester *c_s1 = &all_branches[b_cs].semesters[0];
-    c_s1->num_subjects = 8;
-    strcpy(c_s1->subjects[0].name, "Linear Algebra and Calculus"); c_s1->subjects[0].credits = 4; c_s1->subjects[0].is_passfail = 0;
-    strcpy(c_s1->subjects[1].name, "Engineering Physics"); c_s1->subjects[1].credits = 4; c_s1->subjects[1].is_passfail = 0;
-    strcpy(c_s1->subjects[2].name, "Programming in C"); c_s1->subjects[2].credits = 4; c_s1->subjects[2].is_passfail = 0;
-    strcpy(c_s1->subjects[3].name, "Basics of Electrical Engineering A"); c_s1->subjects[3].credits = 2; c_s1->subjects[3].is_passfail = 0;
-    strcpy(c_s1->subjects[4].name, "Basics of Electronics Engineering"); c_s1->subjects[4].credits = 2; c_s1->subjects[4].is_passfail = 0;
-    strcpy(c_s1->subjects[5].name, "Environmental Science (P/F)"); c_s1->subjects[5].credits = 0; c_s1->subjects[5].is_passfail = 1;
-    strcpy(c_s1->subjects[6].name, "Engineering Physics Lab"); c_s1->subjects[6].credits = 1; c_s1->subjects[6].is_passfail = 0;
-    strcpy(c_s1->subjects[7].name, "Electrical and Electronics Workshop"); c_s1->subjects[7].credits = 1; c_s1->subjects[7].is_passfail = 0;
-
-    // S2 (Total Credits: 21)
-    Semester *c_s2 = &all_branches[b_cs].semesters[1];
-    c_s2->num_subjects = 8;
-    strcpy(c_s2->subjects[0].name, "Vector Calculus, Differential Equations and Transforms"); c_s2->subjects[0].credits = 4; c_s2->subjects[0].is_passfail = 0;
-    strcpy(c_s2->subjects[1].name, "Engineering Chemistry"); c_s2->subjects[1].credits = 4; c_s2->subjects[1].is_passfail = 0;
-    strcpy(c_s2->subjects[2].name, "Engineering Graphics"); c_s2->subjects[2].credits = 3; c_s2->subjects[2].is_passfail = 0;
-    strcpy(c_s2->subjects[3].name, "Programming using Python"); c_s2->subjects[3].credits = 3; c_s2->subjects[3].is_passfail = 0;
-    strcpy(c_s2->subjects[4].name, "Digital Electronics"); c_s2->subjects[4].credits = 3; c_s2->subjects[4].is_passfail = 0;
-    strcpy(c_s2->subjects[5].name, "Engineering Chemistry Lab"); c_s2->subjects[5].credits = 1; c_s2->subjects[5].is_passfail = 0;
-    strcpy(c_s2->subjects[6].name, "Manufacturing and Construction Practices B"); c_s2->subjects[6].credits = 2; c_s2->subjects[6].is_passfail = 0;
-    strcpy(c_s2->subjects[7].name, "Professional Communication (P/F)"); c_s2->subjects[7].credits = 0; c_s2->subjects[7].is_passfail = 1;
-
-    // S3 (Total Credits: 23)  MINOR removed
-    Semester *c_s3 = &all_branches[b_cs].semesters[2];
-    c_s3->num_subjects = 8;
-    strcpy(c_s3->subjects[0].name, "Discrete Mathematical Structures"); c_s3->subjects[0].credits = 4; c_s3->subjects[0].is_passfail = 0;
-    strcpy(c_s3->subjects[1].name, "Data Structures"); c_s3->subjects[1].credits = 4; c_s3->subjects[1].is_passfail = 0;
-    strcpy(c_s3->subjects[2].name, "Computer Organization and Architecture"); c_s3->subjects[2].credits = 4; c_s3->subjects[2].is_passfail = 0;
-    strcpy(c_s3->subjects[3].name, "Object Oriented Programming Concepts"); c_s3->subjects[3].credits = 4; c_s3->subjects[3].is_passfail = 0;
-    strcpy(c_s3->subjects[4].name, "Design Engineering"); c_s3->subjects[4].credits = 2; c_s3->subjects[4].is_passfail = 0;
-    strcpy(c_s3->subjects[5].name, "Professional Ethics (P/F)"); c_s3->subjects[5].credits = 0; c_s3->subjects[5].is_passfail = 1;
-    strcpy(c_s3->subjects[6].name, "Hardware Lab"); c_s3->subjects[6].credits = 2; c_s3->subjects[6].is_passfail = 0;
-    strcpy(c_s3->subjects[7].name, "Data Structures Lab"); c_s3->subjects[7].credits = 2; c_s3->subjects[7].is_passfail = 0;
-
-    // S4 (Total Credits: 22)  remove Minor/Honours
-    Semester *c_s4 = &all_branches[b_cs].semesters[3];
-    c_s4->num_subjects = 8;
-    strcpy(c_s4->subjects[0].name, "Probability, Statistics and Numerical Methods"); c_s4->subjects[0].credits = 4; c_s4->subjects[0].is_passfail = 0;
-    strcpy(c_s4->subjects[1].name, "Operating Systems"); c_s4->subjects[1].credits = 4; c_s4->subjects[1].is_passfail = 0;
-    strcpy(c_s4->subjects[2].name, "Database Management Systems"); c_s4->subjects[2].credits = 4; c_s4->subjects[2].is_passfail = 0;
-    strcpy(c_s4->subjects[3].name, "Formal Languages and Automata Theory"); c_s4->subjects[3].credits = 4; c_s4->subjects[3].is_passfail = 0;
-    strcpy(c_s4->subjects[4].name, "Universal Human Values II (P/F)"); c_s4->subjects[4].credits = 0; c_s4->subjects[4].is_passfail = 1;
-    strcpy(c_s4->subjects[5].name, "Industrial Safety Engineering (P/F)"); c_s4->subjects[5].credits = 0; c_s4->subjects[5].is_passfail = 1;
-    strcpy(c_s4->subjects[6].name, "Operating Systems Lab"); c_s4->subjects[6].credits = 2; c_s4->subjects[6].is_passfail = 0;
-    strcpy(c_s4->subjects[7].name, "Database Lab"); c_s4->subjects[7].credits = 2; c_s4->subjects[7].is_passfail = 0;
-
-    // S5 (Total Credits: 21)  Minor/Honours removed
-    Semester *c_s5 = &all_branches[b_cs].semesters[4];
-    c_s5->num_subjects = 7;
-    strcpy(c_s5->subjects[0].name, "Computer Networks"); c_s5->subjects[0].credits = 4; c_s5->subjects[0].is_passfail = 0;
-    strcpy(c_s5->subjects[1].name, "Microprocessors and Microcontrollers"); c_s5->subjects[1].credits = 4; c_s5->subjects[1].is_passfail = 0;
-    strcpy(c_s5->subjects[2].name, "Artificial Intelligence"); c_s5->subjects[2].credits = 3; c_s5->subjects[2].is_passfail = 0;
-    strcpy(c_s5->subjects[3].name, "Programme Elective I"); c_s5->subjects[3].credits = 3; c_s5->subjects[3].is_passfail = 0;
-    strcpy(c_s5->subjects[4].name, "Business Economics and Accountancy"); c_s5->subjects[4].credits = 3; c_s5->subjects[4].is_passfail = 0;
-    strcpy(c_s5->subjects[5].name, "Microprocessor Lab"); c_s5->subjects[5].credits = 2; c_s5->subjects[5].is_passfail = 0;
-    strcpy(c_s5->subjects[6].name, "Networking Lab"); c_s5->subjects[6].credits = 2; c_s5->subjects[6].is_passfail = 0;
-
-    // S6 (Total Credits: 26)  Minor/Honours removed
-    Semester *c_s6 = &all_branches[b_cs].semesters[5];
-    c_s6->num_subjects = 9;
-    strcpy(c_s6->subjects[0].name, "Algorithm Analysis and Design"); c_s6->subjects[0].credits = 4; c_s6->subjects[0].is_passfail = 0;
-    strcpy(c_s6->subjects[1].name, "Cyber Security"); c_s6->subjects[1].credits = 4; c_s6->subjects[1].is_passfail = 0;
-    strcpy(c_s6->subjects[2].name, "Machine Learning"); c_s6->subjects[2].credits = 4; c_s6->subjects[2].is_passfail = 0;
-    strcpy(c_s6->subjects[3].name, "Software Engineering Theory and Practices"); c_s6->subjects[3].credits = 4; c_s6->subjects[3].is_passfail = 0;
-    strcpy(c_s6->subjects[4].name, "Programme Elective II"); c_s6->subjects[4].credits = 3; c_s6->subjects[4].is_passfail = 0;
-    strcpy(c_s6->subjects[5].name, "Institute Elective I"); c_s6->subjects[5].credits = 3; c_s6->subjects[5].is_passfail = 0;
-    strcpy(c_s6->subjects[6].name, "Seminar"); c_s6->subjects[6].credits = 2; c_s6->subjects[6].is_passfail = 0;
-    strcpy(c_s6->subjects[7].name, "Mini Project"); c_s6->subjects[7].credits = 2; c_s6->subjects[7].is_passfail = 0;
-    strcpy(c_s6->subjects[8].name, ""); c_s6->subjects[8].credits = 0; c_s6->subjects[8].is_passfail = 0;
-
-    // S7 (Total Credits: 21)  Minor/Honours removed
-    Semester *c_s7 = &all_branches[b_cs].semesters[6];
-    c_s7->num_subjects = 7;
-    strcpy(c_s7->subjects[0].name, "Compiler Design"); c_s7->subjects[0].credits = 5; c_s7->subjects[0].is_passfail = 0;
-    strcpy(c_s7->subjects[1].name, "Web Technology"); c_s7->subjects[1].credits = 4; c_s7->subjects[1].is_passfail = 0;
-    strcpy(c_s7->subjects[2].name, "Programme Elective III"); c_s7->subjects[2].credits = 3; c_s7->subjects[2].is_passfail = 0;
-    strcpy(c_s7->subjects[3].name, "Institute Elective II"); c_s7->subjects[3].credits = 3; c_s7->subjects[3].is_passfail = 0;
-    strcpy(c_s7->subjects[4].name, "Comprehensive Course Viva"); c_s7->subjects[4].credits = 1; c_s7->subjects[4].is_passfail = 0;
-    strcpy(c_s7->subjects[5].name, "Project"); c_s7->subjects[5].credits = 5; c_s7->subjects[5].is_passfail = 0;
-    strcpy(c_s7->subjects[6].name, ""); c_s7->subjects[6].credits = 0; c_s7->subjects[6].is_passfail = 0;
-
-    // S8 (Total Credits: 14)
-    Semester *c_s8 = &all_branches[b_cs].semesters[7];
-    c_s8->num_subjects = 4;
-    strcpy(c_s8->subjects[0].name, "Programme Elective IV"); c_s8->subjects[0].credits = 3; c_s8->subjects[0].is_passfail = 0;
-    strcpy(c_s8->subjects[1].name, "Programme Elective V"); c_s8->subjects[1].credits = 3; c_s8->subjects[1].is_passfail = 0;
-    strcpy(c_s8->subjects[2].name, "Programme Elective VI"); c_s8->subjects[2].credits = 3; c_s8->subjects[2].is_passfail = 0;
-    strcpy(c_s8->subjects[3].name, "Project"); c_s8->subjects[3].credits = 5; c_s8->subjects[3].is_passfail = 0;
-}
-
-/* marks -> grade point mapping */
-int get_grade_point(int marks) {
-    if (marks >= 90) return 10;
-    if (marks >= 85) return 9;
-    if (marks >= 75) return 8;
-    if (marks >= 65) return 7;
-    if (marks >= 55) return 6;
-    if (marks >= 50) return 5;
-    return 0; // FAIL
+    console_students = arena_alloc(&console_arena, (size_t)num_branches * sizeof *console_students);
+    console_store_index = arena_alloc(&console_arena, (size_t)num_branches * sizeof *console_store_index);
+    if (!console_students || !console_store_index) { fprintf(stderr, "Out of memory.\n"); exit(1); }
+    for (int i = 0; i < num_branches; i++) {
+        if (!student_attach(&console_students[i], &console_arena, "", i)) { fprintf(stderr, "Out of memory.\n"); exit(1); }
+        console_store_index[i] = -1;
+    }
 }
 
-/* Calculate SGPA and update CGPA */
-void calculate_sgpa_and_cgpa(int branch_index, int sem_index) {
-    Branch *br = &all_branches[branch_index];
-    Semester *cur = &br->semesters[sem_index];
+/* Record shown and edited by the console menus of one branch */
+StudentRecord *console_student(int branch_index) {
+    int idx = console_store_index[branch_index];
+    return idx >= 0 ? &student_store.cohort.students[idx] : &console_students[branch_index];
+}
 
-    float total_credit_points_sem = 0.0f;
-    int total_credits_sem = 0;
+#define ARENA_HEADER ((sizeof(ArenaBlock) + 15) & ~(size_t)15)
 
-    for (int i = 0; i < cur->num_subjects; i++) {
-        Subject *s = &cur->subjects[i];
-        if (s->credits > 0) {
-            total_credit_points_sem += (float)s->grade_points * s->credits;
-            total_credits_sem += s->credits;
+/* Zeroed, 16-byte aligned memory that lives until arena_free() */
+void *arena_alloc(Arena *a, size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    ArenaBlock *b = a->head;
+    if (!b || b->used + size > b->size) {
+        size_t cap = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        b = malloc(ARENA_HEADER + cap);
+        if (!b) return NULL;
+        b->next = a->head;
+        b->used = 0;
+        b->size = cap;
+        a->head = b;
+    }
+    char *p = (char *)b + ARENA_HEADER + b->used;
+    b->used += size;
+    memset(p, 0, size);
+    return p;
+}
+
+void arena_free(Arena *a) {
+    while (a->head) {
+        ArenaBlock *next = a->head->next;
+        free(a->head);
+        a->head = next;
+    }
+}
+
+/* Carve a student's arrays for one branch out of an arena, then clear the record */
+int student_attach(StudentRecord *st, Arena *a, const char *reg_no, int branch_index) {
+    const Branch *br = &all_branches[branch_index];
+    st->sems = arena_alloc(a, (size_t)br->num_semesters * sizeof *st->sems);
+    st->marks = arena_alloc(a, (size_t)br->num_subjects);
+    st->grade_points = arena_alloc(a, (size_t)br->num_subjects);
+    if (!st->sems || !st->marks || !st->grade_points) return 0;
+    student_init(st, reg_no, branch_index);
+    return 1;
+}
+
+/* Clear a student record: no marks entered, nothing completed. Arrays must fit branch_index. */
+void student_init(StudentRecord *st, const char *reg_no, int branch_index) {
+    const Branch *br = &all_branches[branch_index];
+    memset(st->reg_no, 0, sizeof st->reg_no);
+    strncpy(st->reg_no, reg_no, sizeof st->reg_no - 1);
+    st->branch = branch_index;
+    st->cgpa = 0.0f;
+    st->total_credit_points = 0;
+    st->total_credits = 0;
+    st->name = NULL;
+    memset(st->sems, 0, (size_t)br->num_semesters * sizeof *st->sems);
+    memset(st->marks, MARKS_NOT_ENTERED, (size_t)br->num_subjects);
+    memset(st->grade_points, 0, (size_t)br->num_subjects);
+}
+
+void cohort_init(Cohort *c) {
+    c->students = NULL;
+    c->count = 0;
+    c->capacity = 0;
+    c->arena.head = NULL;
+}
+
+/* Append a fresh student; returns NULL if out of memory. Pointers are invalidated by the next add. */
+StudentRecord *cohort_add(Cohort *c, const char *reg_no, int branch_index) {
+    if (c->count == c->capacity) {
+        int cap = c->capacity ? c->capacity * 2 : 1024;
+        StudentRecord *grown = realloc(c->students, (size_t)cap * sizeof *grown);
+        if (!grown) return NULL;
+        c->students = grown;
+        c->capacity = cap;
+    }
+    StudentRecord *st = &c->students[c->count];
+    if (!student_attach(st, &c->arena, reg_no, branch_index)) return NULL;
+    c->count++;
+    return st;
+}
+
+void cohort_free(Cohort *c) {
+    free(c->students);
+    arena_free(&c->arena);
+    cohort_init(c);
+}
+
+/* ===========================
+   Metrics (--metrics FILE, and /metrics of the result service).
+   Counters and latency histograms on the hot paths: row ingestion, grade point lookups and
+   SGPA, CGPA updates, revaluation, report rendering and store writes. Each thread adds to its
+   own shard through a thread-local pointer, so probes share no cache line and take no lock;
+   readers merge the shards. Histogram bucket k counts latencies below 2^k ns.
+   Probes cost one predictable branch until metrics are switched on, and are compiled out
+   entirely with -DCGPA_NO_METRICS.
+   =========================== */
+#if !defined(CGPA_NO_METRICS) && defined(HAVE_THREADS) && defined(__GNUC__)
+#define HAVE_METRICS 1
+#endif
+
+#define METRIC_ROWS_GRADED 0
+#define METRIC_ROWS_REJECTED 1
+#define METRIC_GRADE_LOOKUPS 2
+#define METRIC_SEMESTERS_GRADED 3
+#define METRIC_CGPA_UPDATES 4
+#define METRIC_STORE_RECORDS 5
+#define NUM_COUNTERS 6
+
+#define TIMER_INGEST_ROW 0
+#define TIMER_GRADE_SEMESTER 1
+#define TIMER_REVALUATION 2
+#define TIMER_RENDER_REPORT 3
+#define TIMER_STORE_APPEND 4
+#define TIMER_STORE_SYNC 5
+#define TIMER_STORE_COMPACT 6
+#define TIMER_HTTP_REQUEST 7
+#define NUM_TIMERS 8
+#define METRIC_BUCKETS 32                   /* the last bucket also takes everything slower */
+
+int metrics_enabled;                        // probes record only while set (--metrics, --serve, --entry)
+const char *metrics_path;                   // --metrics FILE, written by finish_run
+
+#ifdef HAVE_METRICS
+typedef struct MetricsShard {
+    unsigned long long counter[NUM_COUNTERS];
+    unsigned long long count[NUM_TIMERS];
+    unsigned long long sum_ns[NUM_TIMERS];
+    unsigned long long bucket[NUM_TIMERS][METRIC_BUCKETS];
+    struct MetricsShard *next;
+} MetricsShard;
+
+static __thread MetricsShard *metrics_local;
+static MetricsShard *metrics_shards;        // every thread's shard, kept after the thread ends
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* This thread's shard, registered on its first probe */
+static MetricsShard *metrics_shard(void) {
+    static MetricsShard fallback;           /* shared by threads whose shard could not be allocated */
+    if (metrics_local) return metrics_local;
+    MetricsShard *s = calloc(1, sizeof *s);
+    if (!s) return metrics_local = &fallback;
+    pthread_mutex_lock(&metrics_lock);
+    s->next = metrics_shards;
+    metrics_shards = s;
+    pthread_mutex_unlock(&metrics_lock);
+    return metrics_local = s;
+}
+
+static unsigned long long metrics_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+static void metrics_observe(int timer, unsigned long long ns) {
+    MetricsShard *s = metrics_shard();
+    int k = ns ? 64 - __builtin_clzll(ns) : 0;
+    s->count[timer]++;
+    s->sum_ns[timer] += ns;
+    s->bucket[timer][k < METRIC_BUCKETS ? k : METRIC_BUCKETS - 1]++;
+}
+
+#define METRIC_COUNT(c, n) do { if (metrics_enabled) metrics_shard()->counter[c] += (unsigned long long)(n); } while (0)
+#define METRIC_START(t) unsigned long long t = metrics_enabled ? metrics_clock_ns() : 0
+#define METRIC_STOP(timer, t) do { if (t) metrics_observe(timer, metrics_clock_ns() - (t)); } while (0)
+#else
+#define METRIC_COUNT(c, n) ((void)0)
+#define METRIC_START(t) ((void)0)
+#define METRIC_STOP(timer, t) ((void)0)
+#endif
+
+/* ===========================
+   Syllabus loading.
+   The curriculum comes from an external file instead of being compiled in:
+     - text:   BRANCH|<code>|<name>  and  SUBJECT|<code>|<sem>|<credits>|<P/F 0/1>|<name>
+     - binary: a snapshot written by --compile-syllabus, mapped into memory as-is.
+   Both are turned into the same image (header, branch table, subject table, one
+   interned string arena), validated once and installed into all_branches.
+   =========================== */
+#define SYLLABUS_MAGIC "MBSYL02"
+#define SYLLABUS_LINE_MAX 512
+
+typedef struct {
+    char magic[8];
+    unsigned int num_branches;
+    unsigned int num_subjects;
+    unsigned int strings_size;
+    unsigned int reserved;
+} SyllabusHeader;
+
+typedef struct {
+    unsigned int code_offset;       // offsets into the string arena
+    unsigned int name_offset;
+    unsigned int num_semesters;     // highest semester number that has subjects
+    unsigned int num_subjects;
+} SyllabusBranchEntry;
+
+typedef struct {
+    unsigned int name_offset;
+    unsigned short branch;
+    unsigned char sem_index;
+    unsigned char credits;
+    unsigned char is_passfail;
+    unsigned char reserved[3];
+} SyllabusSubjectEntry;
+
+/* Growable image under construction plus a hash set used to intern strings */
+typedef struct {
+    SyllabusBranchEntry *branches;
+    int num_branches, cap_branches;
+    SyllabusSubjectEntry *subjects;
+    int num_subjects, cap_subjects;
+    char *strings;
+    unsigned int strings_size, strings_cap;
+    unsigned int *slots;            // string offset + 1, 0 = empty
+    unsigned int num_slots, used_slots;
+} SyllabusBuilder;
+
+static const void *syllabus_image;          /* installed image; all_branches points into it */
+
+static unsigned int hash_string(const char *s) {
+    unsigned int h = 2166136261u;
+    while (*s) h = (h ^ (unsigned char)*s++) * 16777619u;
+    return h;
+}
+
+/* Return the arena offset of `s`, adding it once if not already present; UINT_MAX on OOM */
+static unsigned int intern_string(SyllabusBuilder *sb, const char *s) {
+    if ((sb->used_slots + 1) * 2 > sb->num_slots) {
+        unsigned int n = sb->num_slots ? sb->num_slots * 2 : 256;
+        unsigned int *slots = calloc(n, sizeof *slots);
+        if (!slots) return UINT_MAX;
+        for (unsigned int i = 0; i < sb->num_slots; i++) {
+            if (!sb->slots[i]) continue;
+            unsigned int j = hash_string(sb->strings + sb->slots[i] - 1) & (n - 1);
+            while (slots[j]) j = (j + 1) & (n - 1);
+            slots[j] = sb->slots[i];
+        }
+        free(sb->slots);
+        sb->slots = slots;
+        sb->num_slots = n;
+    }
+    unsigned int j = hash_string(s) & (sb->num_slots - 1);
+    while (sb->slots[j]) {
+        if (strcmp(sb->strings + sb->slots[j] - 1, s) == 0) return sb->slots[j] - 1;
+        j = (j + 1) & (sb->num_slots - 1);
+    }
+    size_t len = strlen(s) + 1;
+    if (sb->strings_size + len > sb->strings_cap) {
+        unsigned int cap = sb->strings_cap ? sb->strings_cap * 2 : 4096;
+        while (cap < sb->strings_size + len) cap *= 2;
+        char *grown = realloc(sb->strings, cap);
+        if (!grown) return UINT_MAX;
+        sb->strings = grown;
+        sb->strings_cap = cap;
+    }
+    unsigned int off = sb->strings_size;
+    memcpy(sb->strings + off, s, len);
+    sb->strings_size += (unsigned int)len;
+    sb->slots[j] = off + 1;
+    sb->used_slots++;
+    return off;
+}
+
+static void syllabus_builder_free(SyllabusBuilder *sb) {
+    free(sb->branches);
+    free(sb->subjects);
+    free(sb->strings);
+    free(sb->slots);
+    memset(sb, 0, sizeof *sb);
+}
+
+/* Parse and validate a text syllabus; subjects may appear in any order after their BRANCH line */
+static int parse_syllabus_text(FILE *in, const char *path, SyllabusBuilder *sb) {
+    char line[SYLLABUS_LINE_MAX];
+    char *f[6];
+    int line_no = 0;
+
+    while (fgets(line, sizeof line, in)) {
+        line_no++;
+        size_t len = strcspn(line, "\r\n");
+        if (line[len] == '\0' && !feof(in)) {
+            fprintf(stderr, "%s:%d: line too long\n", path, line_no);
+            return 0;
+        }
+        line[len] = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
+
+        int nf = 0;
+        char *p = line;
+        f[nf++] = p;
+        while (nf < 6 && (p = strchr(p, '|')) != NULL) { *p++ = '\0'; f[nf++] = p; }
+
+        if (strcmp(f[0], "BRANCH") == 0 && nf == 3) {
+            size_t code_len = strlen(f[1]);
+            if (code_len == 0 || code_len > 5 || f[2][0] == '\0') {
+                fprintf(stderr, "%s:%d: branch code must be 1-5 characters and name non-empty\n", path, line_no);
+                return 0;
+            }
+            for (int b = 0; b < sb->num_branches; b++) {
+                if (strcmp(sb->strings + sb->branches[b].code_offset, f[1]) == 0) {
+                    fprintf(stderr, "%s:%d: duplicate branch %s\n", path, line_no, f[1]);
+                    return 0;
+                }
+            }
+            if (sb->num_branches == sb->cap_branches) {
+                int cap = sb->cap_branches ? sb->cap_branches * 2 : 16;
+                if (cap > USHRT_MAX) { fprintf(stderr, "%s:%d: too many branches\n", path, line_no); return 0; }
+                SyllabusBranchEntry *grown = realloc(sb->branches, (size_t)cap * sizeof *grown);
+                if (!grown) return 0;
+                sb->branches = grown;
+                sb->cap_branches = cap;
+            }
+            SyllabusBranchEntry *be = &sb->branches[sb->num_branches];
+            memset(be, 0, sizeof *be);
+            be->code_offset = intern_string(sb, f[1]);
+            be->name_offset = intern_string(sb, f[2]);
+            if (be->code_offset == UINT_MAX || be->name_offset == UINT_MAX) return 0;
+            sb->num_branches++;
+        } else if (strcmp(f[0], "SUBJECT") == 0 && nf == 6) {
+            int b = -1, sem = 0, credits = -1, pf = -1;
+            char *end;
+            for (int i = 0; i < sb->num_branches; i++) {
+                if (strcmp(sb->strings + sb->branches[i].code_offset, f[1]) == 0) b = i;
+            }
+            sem = (int)strtol(f[2], &end, 10);
+            if (*end) sem = 0;
+            credits = (int)strtol(f[3], &end, 10);
+            if (*end) credits = -1;
+            pf = (strcmp(f[4], "0") == 0) ? 0 : (strcmp(f[4], "1") == 0) ? 1 : -1;
+
+            if (b < 0) { fprintf(stderr, "%s:%d: subject for undeclared branch '%s'\n", path, line_no, f[1]); return 0; }
+            if (sem < 1 || sem > SEMESTER_NUMBER_LIMIT) {
+                fprintf(stderr, "%s:%d: semester must be 1-%d\n", path, line_no, SEMESTER_NUMBER_LIMIT);
+                return 0;
+            }
+            if (credits < 0 || credits > 20 || pf < 0 || (pf && credits != 0)) {
+                fprintf(stderr, "%s:%d: credits must be 0-20, P/F flag 0 or 1, and P/F subjects have 0 credits\n", path, line_no);
+                return 0;
+            }
+            if (f[5][0] == '\0') { fprintf(stderr, "%s:%d: empty subject name\n", path, line_no); return 0; }
+
+            if (sb->num_subjects == sb->cap_subjects) {
+                int cap = sb->cap_subjects ? sb->cap_subjects * 2 : 256;
+                SyllabusSubjectEntry *grown = realloc(sb->subjects, (size_t)cap * sizeof *grown);
+                if (!grown) return 0;
+                sb->subjects = grown;
+                sb->cap_subjects = cap;
+            }
+            SyllabusSubjectEntry *se = &sb->subjects[sb->num_subjects++];
+            se->name_offset = intern_string(sb, f[5]);
+            if (se->name_offset == UINT_MAX) return 0;
+            se->branch = (unsigned short)b;
+            se->sem_index = (unsigned char)(sem - 1);
+            se->credits = (unsigned char)credits;
+            se->is_passfail = (unsigned char)pf;
+            memset(se->reserved, 0, sizeof se->reserved);
+            if ((unsigned int)sem > sb->branches[b].num_semesters) sb->branches[b].num_semesters = (unsigned int)sem;
+            sb->branches[b].num_subjects++;
+        } else {
+            fprintf(stderr, "%s:%d: expected BRANCH|code|name or SUBJECT|code|sem|credits|pf|name\n", path, line_no);
+            return 0;
+        }
+    }
+    if (sb->num_branches == 0) {
+        fprintf(stderr, "%s: no branches defined\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+/* Flatten a builder into one contiguous image: header, branches, subjects grouped by branch/semester, strings */
+static void *build_syllabus_image(const SyllabusBuilder *sb, size_t *size) {
+    size_t total = sizeof(SyllabusHeader) + (size_t)sb->num_branches * sizeof(SyllabusBranchEntry)
+                 + (size_t)sb->num_subjects * sizeof(SyllabusSubjectEntry) + sb->strings_size;
+    char *img = calloc(1, total);
+    if (!img) return NULL;
+
+    SyllabusHeader *h = (SyllabusHeader *)img;
+    memcpy(h->magic, SYLLABUS_MAGIC, sizeof h->magic);
+    h->num_branches = (unsigned int)sb->num_branches;
+    h->num_subjects = (unsigned int)sb->num_subjects;
+    h->strings_size = sb->strings_size;
+
+    SyllabusBranchEntry *be = (SyllabusBranchEntry *)(h + 1);
+    memcpy(be, sb->branches, (size_t)sb->num_branches * sizeof *be);
+
+    /* stable counting placement keeps each semester's subjects in file order */
+    SyllabusSubjectEntry *se = (SyllabusSubjectEntry *)(be + sb->num_branches);
+    int n = 0;
+    for (int b = 0; b < sb->num_branches; b++) {
+        for (int s = 0; s < (int)sb->branches[b].num_semesters; s++) {
+            for (int i = 0; i < sb->num_subjects; i++) {
+                if (sb->subjects[i].branch == b && sb->subjects[i].sem_index == s) se[n++] = sb->subjects[i];
+            }
+        }
+    }
+    memcpy(se + sb->num_subjects, sb->strings, sb->strings_size);
+    *size = total;
+    return img;
+}
+
+/* Validate an image and rebuild all_branches from it in the syllabus arena.
+   Subject names point into the image, so it must outlive the syllabus. */
+static int install_syllabus_image(const void *image, size_t size, const char *path) {
+    const SyllabusHeader *h = image;
+    if (size < sizeof *h || memcmp(h->magic, SYLLABUS_MAGIC, sizeof h->magic) != 0) {
+        fprintf(stderr, "%s: not a compiled syllabus (or built by another version)\n", path);
+        return 0;
+    }
+    size_t need = sizeof *h + (size_t)h->num_branches * sizeof(SyllabusBranchEntry)
+                + (size_t)h->num_subjects * sizeof(SyllabusSubjectEntry) + h->strings_size;
+    if (h->num_branches == 0 || h->num_branches > USHRT_MAX || need != size) {
+        fprintf(stderr, "%s: corrupt syllabus (bad counts or size)\n", path);
+        return 0;
+    }
+    const SyllabusBranchEntry *be = (const SyllabusBranchEntry *)(h + 1);
+    const SyllabusSubjectEntry *se = (const SyllabusSubjectEntry *)(be + h->num_branches);
+    const char *strings = (const char *)(se + h->num_subjects);
+    if (h->strings_size == 0 || strings[h->strings_size - 1] != '\0') {
+        fprintf(stderr, "%s: corrupt syllabus string table\n", path);
+        return 0;
+    }
+
+    /* subjects must be grouped by branch, then semester, and match the branch counts */
+    unsigned int next = 0;
+    for (unsigned int b = 0; b < h->num_branches; b++) {
+        if (be[b].code_offset >= h->strings_size || be[b].name_offset >= h->strings_size ||
+            be[b].num_semesters == 0 || be[b].num_semesters > SEMESTER_NUMBER_LIMIT) goto corrupt;
+        unsigned int prev_sem = 0, gpa_credits = 0;
+        for (unsigned int i = 0; i < be[b].num_subjects; i++, next++) {
+            if (next >= h->num_subjects || se[next].branch != b || se[next].sem_index < prev_sem ||
+                se[next].sem_index >= be[b].num_semesters || se[next].name_offset >= h->strings_size ||
+                (se[next].is_passfail && se[next].credits != 0)) goto corrupt;
+            if (se[next].sem_index != prev_sem) gpa_credits = 0;
+            prev_sem = se[next].sem_index;
+            gpa_credits += se[next].credits;
+            if (gpa_credits > UCHAR_MAX) goto corrupt;      /* SemesterResult stores it in a byte */
+        }
+    }
+    if (next != h->num_subjects) goto corrupt;
+
+    arena_free(&syllabus_arena);
+    num_branches = 0;
+    all_branches = arena_alloc(&syllabus_arena, h->num_branches * sizeof *all_branches);
+    if (!all_branches) goto oom;
+
+    next = 0;
+    for (unsigned int b = 0; b < h->num_branches; b++) {
+        Branch *br = &all_branches[b];
+        br->code = strings + be[b].code_offset;
+        br->name = strings + be[b].name_offset;
+        br->num_semesters = (int)be[b].num_semesters;
+        br->num_subjects = (int)be[b].num_subjects;
+        br->semesters = arena_alloc(&syllabus_arena, (size_t)br->num_semesters * sizeof *br->semesters);
+        Subject *subjects = arena_alloc(&syllabus_arena, (size_t)br->num_subjects * sizeof *subjects + 1);
+        unsigned char *weight = arena_alloc(&syllabus_arena, (size_t)br->num_subjects + 1);
+        if (!br->semesters || !subjects || !weight) goto oom;
+
+        int k = 0;
+        for (int s = 0; s < br->num_semesters; s++) {
+            Semester *sem = &br->semesters[s];
+            sem->sem_number = s + 1;
+            sem->first_subject = k;
+            sem->subjects = subjects + k;
+            sem->weight = weight + k;
+            sem->gpa_credits = 0;
+            sem->num_pf = 0;
+            for (; k < br->num_subjects && se[next].sem_index == s; k++, next++) {
+                subjects[k].name = strings + se[next].name_offset;
+                subjects[k].credits = se[next].credits;
+                subjects[k].is_passfail = se[next].is_passfail;
+                weight[k] = se[next].credits;
+                sem->gpa_credits += se[next].credits;
+                sem->num_pf += se[next].is_passfail;
+            }
+            sem->num_subjects = k - sem->first_subject;
+            unsigned long long *mask = arena_alloc(&syllabus_arena, ((size_t)sem->num_subjects + 63) / 64 * sizeof *mask + 1);
+            if (!mask) goto oom;
+            memset(mask, 0, ((size_t)sem->num_subjects + 63) / 64 * sizeof *mask);
+            for (int i = 0; i < sem->num_subjects; i++) {
+                if (sem->subjects[i].is_passfail) mask[i / 64] |= 1ull << (i % 64);
+            }
+            sem->pf_mask = mask;
+        }
+    }
+    num_branches = (int)h->num_branches;
+    return 1;
+
+corrupt:
+    fprintf(stderr, "%s: corrupt syllabus tables\n", path);
+    return 0;
+oom:
+    fprintf(stderr, "%s: out of memory\n", path);
+    return 0;
+}
+
+/* Read a whole file: memory-mapped where available, otherwise into a heap buffer */
+const char *map_file(const char *path, size_t *size, int *mapped) {
+    *mapped = 0;
+#ifdef HAVE_POSIX
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat sb;
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        void *p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return NULL;
+        *size = (size_t)sb.st_size;
+        *mapped = 1;
+        return p;
+    }
+    close(fd);
+#endif
+    FILE *in = fopen(path, "rb");
+    if (!in) return NULL;
+    size_t cap = 1 << 16, len = 0, got;
+    char *buf = malloc(cap);
+    while (buf && (got = fread(buf + len, 1, cap - len, in)) > 0) {
+        len += got;
+        if (len == cap) {
+            char *grown = realloc(buf, cap * 2);
+            if (!grown) { free(buf); buf = NULL; break; }
+            buf = grown;
+            cap *= 2;
+        }
+    }
+    fclose(in);
+    *size = len;
+    return buf;
+}
+
+void unmap_file(const char *data, size_t size, int mapped) {
+#ifdef HAVE_POSIX
+    if (mapped) { munmap((void *)data, size); return; }
+#endif
+    (void)size;
+    (void)mapped;
+    free((void *)data);
+}
+
+static void *read_syllabus_text(const char *path, size_t *size) {
+    FILE *in = fopen(path, "r");
+    if (!in) { perror(path); return NULL; }
+    SyllabusBuilder sb;
+    memset(&sb, 0, sizeof sb);
+    void *img = parse_syllabus_text(in, path, &sb) ? build_syllabus_image(&sb, size) : NULL;
+    syllabus_builder_free(&sb);
+    fclose(in);
+    return img;
+}
+
+/* Load the syllabus from a text file or a compiled snapshot (detected by its magic) */
+int load_syllabus(const char *path) {
+    size_t size = 0;
+    int mapped = 0;
+    const char *data = map_file(path, &size, &mapped);
+    if (!data) { perror(path); return 0; }
+
+    if (size >= sizeof(SyllabusHeader) && memcmp(data, SYLLABUS_MAGIC, sizeof(SYLLABUS_MAGIC)) == 0) {
+        if (!install_syllabus_image(data, size, path)) { unmap_file(data, size, mapped); return 0; }
+        syllabus_image = data;
+        return 1;
+    }
+    unmap_file(data, size, mapped);
+
+    void *img = read_syllabus_text(path, &size);
+    if (!img) return 0;
+    if (!install_syllabus_image(img, size, path)) { free(img); return 0; }
+    syllabus_image = img;
+    return 1;
+}
+
+/* Validate a text syllabus and write its binary snapshot */
+int compile_syllabus(const char *text_path, const char *bin_path) {
+    size_t size = 0;
+    void *img = read_syllabus_text(text_path, &size);
+    if (!img) return 1;
+    FILE *out = fopen(bin_path, "wb");
+    if (!out) { perror(bin_path); free(img); return 1; }
+    int ok = fwrite(img, 1, size, out) == size;
+    if (fclose(out) != 0) ok = 0;
+    free(img);
+    if (!ok) { fprintf(stderr, "%s: write failed\n", bin_path); return 1; }
+    printf("Compiled %s -> %s (%zu bytes)\n", text_path, bin_path, size);
+    return 0;
+}
+
+/* ===========================
+   Grading schemes.
+   A scheme maps marks to grade points through thresholds (regular, relative-grading cut-offs,
+   supplementary caps, other universities) and sets the P/F pass mark. Each is precomputed into
+   a 101-entry table, so grading a subject is one indexed load, and into the equivalent list of
+   step thresholds for the SIMD kernel. Every semester references one scheme (default: the first).
+   File format (DEFAULT_SCHEMES; missing file = built-in regular scheme only):
+     SCHEME|name|pf_pass_mark|max_grade_point|marks=grade_point,...
+     APPLY|branch_code or *|semester or *|scheme name       (later lines override earlier ones)
+   =========================== */
+static const int regular_thresholds[][2] = { {90, 10}, {85, 9}, {75, 8}, {65, 7}, {55, 6}, {50, 5} };
+
+/* Fill the lookup table from (min marks, grade point) pairs; 0 if the result is not monotone */
+static int build_scheme(GradingScheme *g, const char *name, const int (*thr)[2], int n, int pf_pass, int cap) {
+    memset(g, 0, sizeof *g);
+    snprintf(g->name, sizeof g->name, "%s", name);
+    g->pf_pass = (unsigned char)pf_pass;
+    for (int m = 0; m <= 100; m++) {
+        int best = -1, gp = 0;
+        for (int k = 0; k < n; k++) {
+            if (thr[k][0] <= m && thr[k][0] > best) { best = thr[k][0]; gp = thr[k][1]; }
+        }
+        g->grade_point[m] = (signed char)(gp < cap ? gp : cap);
+        int prev = m ? g->grade_point[m - 1] : 0;
+        if (g->grade_point[m] < prev) return 0;
+        if (g->grade_point[m] > prev) {
+            g->step_marks[g->num_steps] = (unsigned char)m;
+            g->step_gp[g->num_steps++] = (unsigned char)(g->grade_point[m] - prev);
         }
     }
+    return 1;
+}
+
+static int scheme_index(const char *name) {
+    for (int i = 0; i < num_schemes; i++) {
+        if (strcmp(grading_schemes[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static int add_scheme(const GradingScheme *g) {
+    GradingScheme *grown = realloc(grading_schemes, (size_t)(num_schemes + 1) * sizeof *grown);
+    if (!grown) return 0;
+    grading_schemes = grown;
+    grading_schemes[num_schemes++] = *g;
+    return 1;
+}
+
+/* Load grading schemes and their branch/semester assignments (call after load_syllabus) */
+int load_grading_schemes(const char *path, int required) {
+    GradingScheme g;
+    free(grading_schemes);
+    grading_schemes = NULL;
+    num_schemes = 0;
+
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        if (required) { perror(path); return 0; }
+        build_scheme(&g, "regular", regular_thresholds, 6, 50, 10);
+        return add_scheme(&g);
+    }
+
+    char line[SYLLABUS_LINE_MAX];
+    char *f[5];
+    int line_no = 0, ok = 1;
+    while (ok && fgets(line, sizeof line, in)) {
+        line_no++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
 
-    if (total_credits_sem > 0) cur->sgpa = total_credit_points_sem / total_credits_sem;
-    else cur->sgpa = 0.0f;
+        int nf = 0;
+        char *p = line;
+        f[nf++] = p;
+        while (nf < 5 && (p = strchr(p, '|')) != NULL) { *p++ = '\0'; f[nf++] = p; }
 
-    float cumulative_cp = 0.0f;
-    int cumulative_credits = 0;
-    for (int s = 0; s < SEM_COUNT; s++) {
-        Semester *sem = &br->semesters[s];
-        if (sem->is_completed || s == sem_index) {
-            int sem_credits = 0;
-            for (int j = 0; j < sem->num_subjects; j++) {
-                if (sem->subjects[j].credits > 0) sem_credits += sem->subjects[j].credits;
+        if (strcmp(f[0], "SCHEME") == 0 && nf == 5) {
+            int thr[101][2], n = 0, pf_pass = 0, cap = 0;
+            char *end;
+            pf_pass = (int)strtol(f[2], &end, 10);
+            if (*end || f[2][0] == '\0') pf_pass = -1;
+            cap = (int)strtol(f[3], &end, 10);
+            if (*end || f[3][0] == '\0') cap = -1;
+            for (char *t = strtok(f[4], ","); t && ok; t = strtok(NULL, ",")) {
+                char *eq = strchr(t, '=');
+                long m = eq ? strtol(t, &end, 10) : -1;
+                if (!eq || end != eq || n == 101) { ok = 0; break; }
+                long gp = strtol(eq + 1, &end, 10);
+                if (*end || m < 0 || m > 100 || gp < 0 || gp > 10) { ok = 0; break; }
+                thr[n][0] = (int)m;
+                thr[n++][1] = (int)gp;
+            }
+            if (!ok || n == 0 || pf_pass < 0 || pf_pass > 100 || cap < 0 || cap > 10) {
+                fprintf(stderr, "%s:%d: expected SCHEME|name|pf_pass 0-100|max grade point 0-10|marks=gp,...\n", path, line_no);
+                ok = 0;
+            } else if (f[1][0] == '\0' || strlen(f[1]) >= sizeof g.name || scheme_index(f[1]) >= 0) {
+                fprintf(stderr, "%s:%d: scheme name empty, too long or duplicate\n", path, line_no);
+                ok = 0;
+            } else if (!build_scheme(&g, f[1], (const int (*)[2])thr, n, pf_pass, cap)) {
+                fprintf(stderr, "%s:%d: grade points must not fall as marks rise\n", path, line_no);
+                ok = 0;
+            } else if (!add_scheme(&g)) {
+                fprintf(stderr, "%s: out of memory\n", path);
+                ok = 0;
+            }
+        } else if (strcmp(f[0], "APPLY") == 0 && nf == 4) {
+            int all_branches_match = strcmp(f[1], "*") == 0;
+            int b = all_branches_match ? -1 : find_branch_by_code(f[1]);
+            int sem = 0, s = scheme_index(f[3]);
+            char *end;
+            if (strcmp(f[2], "*") != 0) {
+                sem = (int)strtol(f[2], &end, 10);
+                if (*end || sem < 1) sem = -1;
             }
-            cumulative_cp += sem->sgpa * sem_credits;
-            cumulative_credits += sem_credits;
+            if ((!all_branches_match && b < 0) || sem < 0 || s < 0) {
+                fprintf(stderr, "%s:%d: unknown branch, semester or scheme in APPLY\n", path, line_no);
+                ok = 0;
+                break;
+            }
+            for (int i = 0; i < num_branches; i++) {
+                if (!all_branches_match && i != b) continue;
+                for (int k = 0; k < all_branches[i].num_semesters; k++) {
+                    if (sem == 0 || k == sem - 1) all_branches[i].semesters[k].scheme = s;
+                }
+            }
+        } else {
+            fprintf(stderr, "%s:%d: expected SCHEME|... or APPLY|branch|sem|scheme\n", path, line_no);
+            ok = 0;
         }
     }
+    fclose(in);
+    if (ok && num_schemes == 0) {
+        fprintf(stderr, "%s: no schemes defined\n", path);
+        ok = 0;
+    }
+    return ok;
+}
+
+/* marks -> grade point mapping of the default scheme */
+int get_grade_point(int marks) {
+    METRIC_COUNT(METRIC_GRADE_LOOKUPS, 1);
+    return grading_schemes[0].grade_point[marks < 0 ? 0 : marks > 100 ? 100 : marks];
+}
+
+/* Calculate SGPA and update CGPA */
+void calculate_sgpa_and_cgpa(int branch_index, int sem_index) {
+    grade_semester(console_student(branch_index), sem_index);
+}
+
+/* Store marks for one subject and map them to grade points (P/F: pass / fail codes) */
+void set_subject_marks(StudentRecord *st, int sem_index, int subject_index, int marks) {
+    const Semester *syl = &all_branches[st->branch].semesters[sem_index];
+    const GradingScheme *g = SEMESTER_SCHEME(syl);
+    STUDENT_MARKS(st, sem_index)[subject_index] = (unsigned char)marks;
+    METRIC_COUNT(METRIC_GRADE_LOOKUPS, 1);
+    if (syl->subjects[subject_index].is_passfail) {
+        STUDENT_GP(st, sem_index)[subject_index] = (marks >= g->pf_pass) ? GP_PF_PASS : GP_PF_FAIL;
+    } else {
+        STUDENT_GP(st, sem_index)[subject_index] = g->grade_point[marks];
+    }
+}
+
+static int lowest_bit(unsigned long long w) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+    while (!(w & 1)) { w >>= 1; n++; }
+    return n;
+#endif
+}
+
+/* Failed P/F subjects of one semester's grade points, visiting only the P/F ones */
+static int semester_pf_failures(const Semester *syl, const signed char *gp) {
+    int fails = 0;
+    if (syl->num_pf == 0) return 0;
+    for (int w = 0; w * 64 < syl->num_subjects; w++) {
+        for (unsigned long long m = syl->pf_mask[w]; m; m &= m - 1) fails += gp[w * 64 + lowest_bit(m)] == GP_PF_FAIL;
+    }
+    return fails;
+}
+
+/* Recompute the pf_failed flag of a semester from its P/F subjects */
+void update_pf_failed(StudentRecord *st, int sem_index) {
+    const Semester *syl = &all_branches[st->branch].semesters[sem_index];
+    st->sems[sem_index].pf_failed = semester_pf_failures(syl, STUDENT_GP(st, sem_index)) > 0;
+}
+
+/* SGPA of one semester; CGPA follows from the running totals in O(subjects in that semester) */
+void grade_semester(StudentRecord *st, int sem_index) {
+    const Semester *syl = &all_branches[st->branch].semesters[sem_index];
+    METRIC_START(t0);
+
+    /* P/F grade points are negative codes but weigh 0, so no per-subject branch is needed */
+    const signed char *gp = STUDENT_GP(st, sem_index);
+    int total_credit_points_sem = 0;
+    for (int i = 0; i < syl->num_subjects; i++) total_credit_points_sem += gp[i] * syl->weight[i];
+
+    commit_semester_totals(st, sem_index, total_credit_points_sem, syl->gpa_credits);
+    METRIC_COUNT(METRIC_SEMESTERS_GRADED, 1);
+    METRIC_STOP(TIMER_GRADE_SEMESTER, t0);
+}
 
-    if (cumulative_credits > 0) br->cgpa = cumulative_cp / cumulative_credits;
-    else br->cgpa = cur->sgpa;
+/* Replace one semester's credit-points and shift the student's running totals by the difference.
+   Re-entering a semester first takes its previous contribution back out. */
+void commit_semester_totals(StudentRecord *st, int sem_index, int credit_points, int credits) {
+    SemesterResult *cur = &st->sems[sem_index];
 
+    if (cur->is_completed) {
+        st->total_credit_points -= cur->credit_points;
+        st->total_credits -= cur->gpa_credits;
+    }
+    cur->credit_points = (unsigned short)credit_points;
+    cur->gpa_credits = (unsigned char)credits;
+    cur->sgpa = credits > 0 ? (float)credit_points / (float)credits : 0.0f;
     cur->is_completed = 1;
+
+    st->total_credit_points += credit_points;
+    st->total_credits += credits;
+    update_cgpa(st);
+}
+
+/* CGPA from the integer running totals (a single division, no accumulated float error) */
+void update_cgpa(StudentRecord *st) {
+    METRIC_COUNT(METRIC_CGPA_UPDATES, 1);
+    if (st->total_credits > 0) st->cgpa = (float)st->total_credit_points / (float)st->total_credits;
+    else st->cgpa = 0.0f;
+}
+
+/* Exact GPA x 100 from integer credit-points: one rounding step, half up as results are
+   published. Every printed SGPA/CGPA comes from here rather than from the float fields, whose
+   "%.2f" could land on the other side of a tie (7.125 -> "7.12", 8.345f -> "8.34"). */
+int gpa_x100(int credit_points, int credits) {
+    if (credits <= 0) return 0;
+    return (int)(((long long)credit_points * 200 + credits) / (2LL * credits));
+}
+
+#define SGPA_X100(res) gpa_x100((res)->credit_points, (res)->gpa_credits)
+#define CGPA_X100(st)  gpa_x100((st)->total_credit_points, (st)->total_credits)
+#define GPA_TEXT_MAX 16
+
+/* "d.dd" of a GPA x 100 (non-negative) into buf[GPA_TEXT_MAX]; returns its length */
+int gpa_text(char *buf, int x100) {
+    char tmp[GPA_TEXT_MAX];
+    int n = 0, whole = x100 / 100;
+    do { tmp[n++] = (char)('0' + whole % 10); whole /= 10; } while (whole);
+    for (int k = 0; k < n; k++) buf[k] = tmp[n - 1 - k];
+    buf[n++] = '.';
+    buf[n++] = (char)('0' + x100 / 10 % 10);
+    buf[n++] = (char)('0' + x100 % 10);
+    buf[n] = '\0';
+    return n;
+}
+
+/* Change the marks of one subject in an already graded semester (revaluation / supplementary).
+   Only the grade-point delta of that subject is applied to the semester and running totals. */
+void apply_revaluation(StudentRecord *st, int sem_index, int subject_index, int marks) {
+    const Subject *s = &all_branches[st->branch].semesters[sem_index].subjects[subject_index];
+    SemesterResult *cur = &st->sems[sem_index];
+    int old_gp = STUDENT_GP(st, sem_index)[subject_index];
+    METRIC_START(t0);
+
+    set_subject_marks(st, sem_index, subject_index, marks);
+
+    if (s->is_passfail) {
+        update_pf_failed(st, sem_index);
+        METRIC_STOP(TIMER_REVALUATION, t0);
+        return;
+    }
+    if (!cur->is_completed || s->credits <= 0) {
+        METRIC_STOP(TIMER_REVALUATION, t0);
+        return;
+    }
+
+    int delta = (STUDENT_GP(st, sem_index)[subject_index] - old_gp) * s->credits;
+    cur->credit_points = (unsigned short)(cur->credit_points + delta);
+    cur->sgpa = cur->gpa_credits > 0 ? (float)cur->credit_points / (float)cur->gpa_credits : 0.0f;
+    st->total_credit_points += delta;
+    update_cgpa(st);
+    METRIC_STOP(TIMER_REVALUATION, t0);
 }
 
 /* Input marks for subjects in a semester (including P/F) */
 void input_marks_and_calculate_sgpa(int branch_index, int sem_index) {
     Branch *br = &all_branches[branch_index];
     Semester *cur = &br->semesters[sem_index];
+    StudentRecord *st = console_student(branch_index);
 
     if (cur->num_subjects == 0) {
         printf("\nNo subject data for semester %d in branch %s.\n", sem_index+1, br->code);
@@ -656,12 +1216,7 @@ void input_marks_and_calculate_sgpa(int branch_index, int sem_index) {
             printf("Invalid. Enter marks between 0 and 100: ");
             while (getchar() != '\n');
         }
-        s->marks_obtained = marks;
-        if (s->is_passfail) {
-            s->grade_points = (marks >= 50) ? -1 : -2;
-        } else {
-            s->grade_points = get_grade_point(marks);
-        }
+        set_subject_marks(st, sem_index, i, marks);
     }
 
     int ap = -1;
@@ -670,105 +1225,533 @@ void input_marks_and_calculate_sgpa(int branch_index, int sem_index) {
         printf("Invalid. Enter activity points between 0 and 150: ");
         while (getchar() != '\n');
     }
-    cur->activity_points = ap;
+    st->sems[sem_index].activity_points = (unsigned char)ap;
 
-    cur->pf_failed = 0;
-    for (int i = 0; i < cur->num_subjects; i++) {
-        Subject *s = &cur->subjects[i];
-        if (s->is_passfail && s->grade_points == -2) {
-            cur->pf_failed = 1;
-            break;
-        }
-    }
+    update_pf_failed(st, sem_index);
 
     calculate_sgpa_and_cgpa(branch_index, sem_index);
+    if (student_store.is_open && !store_log_semester(&student_store, st, sem_index)) {
+        printf("WARNING: could not save these marks to the store.\n");
+    }
 
     display_report(branch_index, sem_index);
 }
 
-/* Display semester report */
-void display_report(int branch_index, int sem_index) {
-    Branch *br = &all_branches[branch_index];
-    Semester *cur = &br->semesters[sem_index];
+/* ===========================
+   Report rendering.
+   Reports are rendered into an OutBuf with small fixed-width formatters instead of printf,
+   and leave the process in large write() calls; one buffer is reused for every report.
+   =========================== */
+#define OUTBUF_FLUSH_AT (1u << 20)          /* bulk renderers flush once this much is pending */
+
+/* Make room for n more bytes */
+static int ob_reserve(OutBuf *ob, size_t n) {
+    if (ob->len + n <= ob->cap) return 1;
+    size_t cap = ob->cap ? ob->cap : 4096;
+    while (cap < ob->len + n) cap *= 2;
+    char *grown = realloc(ob->data, cap);
+    if (!grown) { ob->failed = 1; return 0; }
+    ob->data = grown;
+    ob->cap = cap;
+    return 1;
+}
+
+static void ob_put(OutBuf *ob, const char *s, size_t n) {
+    if (!ob_reserve(ob, n)) return;
+    memcpy(ob->data + ob->len, s, n);
+    ob->len += n;
+}
+
+static void ob_str(OutBuf *ob, const char *s) {
+    ob_put(ob, s, strlen(s));
+}
+
+static void ob_fill(OutBuf *ob, char c, int n) {
+    if (n <= 0 || !ob_reserve(ob, (size_t)n)) return;
+    memset(ob->data + ob->len, c, (size_t)n);
+    ob->len += (size_t)n;
+}
+
+/* printf("%-W.Ws") */
+static void ob_field(OutBuf *ob, const char *s, int width) {
+    size_t n = 0;
+    while (n < (size_t)width && s[n]) n++;
+    ob_put(ob, s, n);
+    ob_fill(ob, ' ', width - (int)n);
+}
+
+/* printf("%Wd") */
+static void ob_int(OutBuf *ob, int v, int width) {
+    char tmp[12];
+    int n = 0;
+    unsigned int u = v < 0 ? 0u - (unsigned int)v : (unsigned int)v;
+    do { tmp[sizeof tmp - 1 - n++] = (char)('0' + u % 10); u /= 10; } while (u);
+    if (v < 0) tmp[sizeof tmp - 1 - n++] = '-';
+    ob_fill(ob, ' ', width - n);
+    ob_put(ob, tmp + sizeof tmp - n, (size_t)n);
+}
 
-    printf("\n\n============================================================\n");
-    printf("   ACADEMIC REPORT: %s (%s) - SEMESTER %d\n", br->name, br->code, cur->sem_number);
-    printf("============================================================\n");
-    printf("SUBJECT (truncated)           | CR | MARKS |  GP  | NOTES\n");
-    printf("------------------------------------------------------------\n");
+static void ob_gpa(OutBuf *ob, int x100) {
+    char tmp[GPA_TEXT_MAX];
+    ob_put(ob, tmp, (size_t)gpa_text(tmp, x100));
+}
+
+static int write_all(FILE *f, const char *p, size_t n) {
+#ifdef HAVE_POSIX
+    int fd = fileno(f);
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 1;
+#else
+    return fwrite(p, 1, n, f) == n;
+#endif
+}
+
+/* Hand the buffered bytes to ob->file with write(), after anything stdio still holds for it */
+int ob_flush(OutBuf *ob) {
+    if (ob->len == 0) return !ob->failed;
+    fflush(ob->file);
+    if (!write_all(ob->file, ob->data, ob->len)) ob->failed = 1;
+    ob->len = 0;
+    return !ob->failed;
+}
+
+/* Render one semester report of a student, laid out exactly as the console report */
+void render_report(OutBuf *ob, const StudentRecord *st, int sem_index) {
+    static const char rule_eq[] = "============================================================\n";
+    static const char rule_dash[] = "------------------------------------------------------------\n";
+    const Branch *br = &all_branches[st->branch];
+    const Semester *cur = &br->semesters[sem_index];
+    const SemesterResult *res = &st->sems[sem_index];
+    const unsigned char *row_marks = STUDENT_MARKS(st, sem_index);
+    const signed char *row_gp = STUDENT_GP(st, sem_index);
+    METRIC_START(t0);
 
-    int total_credits = 0;
-    float total_credit_points = 0.0f;
+    ob_str(ob, "\n\n");
+    ob_str(ob, rule_eq);
+    ob_str(ob, "   ACADEMIC REPORT: ");
+    ob_str(ob, br->name);
+    ob_str(ob, " (");
+    ob_str(ob, br->code);
+    ob_str(ob, ") - SEMESTER ");
+    ob_int(ob, cur->sem_number, 0);
+    ob_str(ob, "\n");
+    ob_str(ob, rule_eq);
+    ob_str(ob, "SUBJECT (truncated)           | CR | MARKS |  GP  | NOTES\n");
+    ob_str(ob, rule_dash);
+
+    int total_credits = cur->gpa_credits;
 
     for (int i = 0; i < cur->num_subjects; i++) {
-        Subject *s = &cur->subjects[i];
-        float cpts = 0.0f;
+        const Subject *s = &cur->subjects[i];
+        int marks = row_marks[i];
+        int gp = row_gp[i];
         int display_gp = 0;
-
-        char note[64] = "";
+        const char *note = "";
 
         if (s->is_passfail) {
-            if (s->grade_points == -1) {
-                display_gp = 0;
-                strcpy(note, "P/F: PASS (not in GPA)");
-            }
-            else if (s->grade_points == -2) {
-                display_gp = -2;
-                strcpy(note, "P/F: FAIL (reappear)");
-            } else {
-                strcpy(note, "P/F: pending");
-            }
+            if (gp == GP_PF_PASS) note = "P/F: PASS (not in GPA)";
+            else if (gp == GP_PF_FAIL) { display_gp = -2; note = "P/F: FAIL (reappear)"; }
+            else note = "P/F: pending";
         } else {
-            display_gp = s->grade_points;
-            cpts = (float)s->grade_points * s->credits;
-            total_credits += s->credits;
-            total_credit_points += cpts;
-
-            // *** FAIL display fix ***
-            if (s->marks_obtained < 50) {
-                strcpy(note, "FAIL (needs reappear)");
-            }
+            display_gp = gp;
+            /* failed = grade point 0 under the semester's scheme: below 50 marks for the regular
+               scheme, as before schemes were configurable, and below its own cut-off otherwise */
+            if (marks != MARKS_NOT_ENTERED && gp == 0) note = "FAIL (needs reappear)";
         }
 
-        printf("%-28.28s | %2d | %5d | %4d | %s\n",
-               s->name, s->credits,
-               (s->marks_obtained >= 0 ? s->marks_obtained : 0),
-               display_gp, note);
+        ob_field(ob, s->name, 28);
+        ob_str(ob, " | ");
+        ob_int(ob, s->credits, 2);
+        ob_str(ob, " | ");
+        ob_int(ob, marks != MARKS_NOT_ENTERED ? marks : 0, 5);
+        ob_str(ob, " | ");
+        ob_int(ob, display_gp, 4);
+        ob_str(ob, " | ");
+        ob_str(ob, note);
+        ob_str(ob, "\n");
     }
 
-    printf("------------------------------------------------------------\n");
-    printf("SEMESTER CREDITS (counted for GPA): %d\n", total_credits);
-    printf("SEMESTER CREDIT-POINTS (sum): %.2f\n", total_credit_points);
-    printf(">> SGPA: %.2f\n", cur->sgpa);
-    printf(">> CGPA: %.2f\n", br->cgpa);
-    printf(">> Activity Points (this sem): %d\n", cur->activity_points);
-    printf(">> Total Activity Points (so far): %d / %d required\n", total_activity_points(branch_index), ACTIVITY_REQUIRED);
+    ob_str(ob, rule_dash);
+    ob_str(ob, "SEMESTER CREDITS (counted for GPA): ");
+    ob_int(ob, total_credits, 0);
+    ob_str(ob, "\nSEMESTER CREDIT-POINTS (sum): ");
+    ob_int(ob, res->credit_points, 0);
+    ob_str(ob, "\n>> SGPA: ");
+    ob_gpa(ob, SGPA_X100(res));
+    ob_str(ob, "\n>> CGPA: ");
+    ob_gpa(ob, CGPA_X100(st));
+    ob_str(ob, "\n>> Activity Points (this sem): ");
+    ob_int(ob, res->activity_points, 0);
+    ob_str(ob, "\n>> Total Activity Points (so far): ");
+    ob_int(ob, sum_activity_points(st), 0);
+    ob_str(ob, " / ");
+    ob_int(ob, ACTIVITY_REQUIRED, 0);
+    ob_str(ob, " required\n");
 
-    if (cur->pf_failed) {
-        printf(">> WARNING: This semester has FAILED P/F subject(s). Clear them to be eligible for degree.\n");
+    if (res->pf_failed) {
+        ob_str(ob, ">> WARNING: This semester has FAILED P/F subject(s). Clear them to be eligible for degree.\n");
     } else {
-        printf(">> P/F Subjects: All passed (or none present) in this semester.\n");
+        ob_str(ob, ">> P/F Subjects: All passed (or none present) in this semester.\n");
     }
+    ob_str(ob, rule_eq);
+    METRIC_STOP(TIMER_RENDER_REPORT, t0);
+}
 
-    printf("============================================================\n");
+/* Display semester report */
+void display_report(int branch_index, int sem_index) {
+    static OutBuf ob;
+    ob.file = stdout;
+    render_report(&ob, console_student(branch_index), sem_index);
+    ob_flush(&ob);
 }
 
 int total_activity_points(int branch_index) {
+    return sum_activity_points(console_student(branch_index));
+}
+
+int total_pf_failures(int branch_index) {
+    return count_pf_failures(console_student(branch_index));
+}
+
+int sum_activity_points(const StudentRecord *st) {
     int sum = 0;
-    for (int s = 0; s < SEM_COUNT; s++) sum += all_branches[branch_index].semesters[s].activity_points;
+    for (int s = 0; s < all_branches[st->branch].num_semesters; s++) sum += st->sems[s].activity_points;
     return sum;
 }
 
-int total_pf_failures(int branch_index) {
+int count_pf_failures(const StudentRecord *st) {
     int fails = 0;
-    Branch *br = &all_branches[branch_index];
-    for (int s = 0; s < SEM_COUNT; s++) {
-        for (int i = 0; i < br->semesters[s].num_subjects; i++) {
-            Subject *sub = &br->semesters[s].subjects[i];
-            if (sub->is_passfail && sub->grade_points == -2) fails++;
+    const Branch *br = &all_branches[st->branch];
+    for (int s = 0; s < br->num_semesters; s++) fails += semester_pf_failures(&br->semesters[s], STUDENT_GP(st, s));
+    return fails;
+}
+
+/* ===========================
+   Column-major (structure-of-arrays) grading kernel for bulk runs.
+   A GradeBlock holds up to `capacity` students of one branch/semester with
+   marks[subject * stride + student], one byte each, so one SIMD lane is one student and a
+   register holds 16 (SSE2) or 32 (AVX2) of them.
+   The scalar path maps marks through the scheme's lookup table. The SIMD path compares the
+   marks against the scheme's step thresholds in 8-bit lanes and adds the step of every
+   threshold passed (a regular scheme has 6), then widens to 16 bits for grade point x credits;
+   credit-points are integer sums, so both give bit-identical SGPA values.
+   A block is sized for one semester and can be pointed at any semester with no more subjects
+   (grade_block_select), so a whole cohort is graded through one allocation.
+   =========================== */
+#define GRADE_BLOCK_STUDENTS 1024           /* students graded per kernel pass of cohort_grade */
+#define GRADE_BLOCK_ALIGN 32                /* students per column rounded up to the widest register */
+
+int grade_block_init(GradeBlock *blk, int branch_index, int sem_index, int capacity) {
+    const Semester *syl = &all_branches[branch_index].semesters[sem_index];
+    memset(blk, 0, sizeof *blk);
+    blk->max_subjects = syl->num_subjects;
+    blk->stride = (capacity + GRADE_BLOCK_ALIGN - 1) & ~(GRADE_BLOCK_ALIGN - 1);
+    blk->credits = malloc(((size_t)syl->num_subjects + 1) * sizeof(int));
+    blk->is_passfail = malloc(((size_t)syl->num_subjects + 1) * sizeof(int));
+    size_t cells = (size_t)blk->max_subjects * blk->stride;
+    blk->marks = malloc(cells ? cells : 1);
+    blk->grade_points = malloc(cells ? cells : 1);
+    blk->credit_points = malloc((size_t)blk->stride * sizeof(int));
+    blk->sgpa = malloc((size_t)blk->stride * sizeof(float));
+    blk->pf_failed = malloc((size_t)blk->stride);
+    if (!blk->credits || !blk->is_passfail || !blk->marks || !blk->grade_points || !blk->credit_points || !blk->sgpa ||
+        !blk->pf_failed) {
+        grade_block_free(blk);
+        return 0;
+    }
+    grade_block_select(blk, branch_index, sem_index);
+    return 1;
+}
+
+/* Point an empty block at another semester; it must have at most blk->max_subjects subjects */
+void grade_block_select(GradeBlock *blk, int branch_index, int sem_index) {
+    const Semester *syl = &all_branches[branch_index].semesters[sem_index];
+    blk->branch = branch_index;
+    blk->sem_index = sem_index;
+    blk->num_students = 0;
+    blk->num_subjects = syl->num_subjects;
+    blk->scheme = SEMESTER_SCHEME(syl);
+    for (int i = 0; i < syl->num_subjects; i++) {
+        blk->credits[i] = syl->subjects[i].credits;
+        blk->is_passfail[i] = syl->subjects[i].is_passfail;
+    }
+    blk->gpa_credits = syl->gpa_credits;
+}
+
+void grade_block_free(GradeBlock *blk) {
+    free(blk->credits);
+    free(blk->is_passfail);
+    free(blk->marks);
+    free(blk->grade_points);
+    free(blk->credit_points);
+    free(blk->sgpa);
+    free(blk->pf_failed);
+    blk->credits = blk->is_passfail = blk->credit_points = NULL;
+    blk->marks = NULL;
+    blk->grade_points = NULL;
+    blk->sgpa = NULL;
+    blk->pf_failed = NULL;
+}
+
+static void grade_block_scalar_range(GradeBlock *blk, int from, int to) {
+    for (int j = from; j < to; j++) {
+        blk->credit_points[j] = 0;
+        blk->pf_failed[j] = 0;
+    }
+    const GradingScheme *g = blk->scheme;
+    for (int i = 0; i < blk->num_subjects; i++) {
+        const unsigned char *m = blk->marks + (size_t)i * blk->stride;
+        signed char *gp = blk->grade_points + (size_t)i * blk->stride;
+        int c = blk->credits[i];
+        if (blk->is_passfail[i]) {
+            for (int j = from; j < to; j++) {
+                int pass = m[j] >= g->pf_pass;
+                gp[j] = (signed char)(pass - 2);    /* GP_PF_PASS / GP_PF_FAIL */
+                blk->pf_failed[j] |= (unsigned char)!pass;
+            }
+        } else {
+            for (int j = from; j < to; j++) {
+                gp[j] = g->grade_point[m[j]];
+                blk->credit_points[j] += gp[j] * c;
+            }
         }
     }
-    return fails;
+    for (int j = from; j < to; j++) {
+        blk->sgpa[j] = blk->gpa_credits > 0 ? (float)blk->credit_points[j] / (float)blk->gpa_credits : 0.0f;
+    }
+}
+
+void grade_block_scalar(GradeBlock *blk) {
+    grade_block_scalar_range(blk, 0, blk->num_students);
+}
+
+#if GRADE_LANES > 1
+/* V8_*: GRADE_LANES signed bytes (marks 0-100 and grade points compare as signed);
+   V16_*: the low or high half of them widened to 16 bits, V32_*: a 16-bit half widened again */
+#if GRADE_LANES == 32
+typedef __m256i vint;
+#define V_LOAD(p)       _mm256_loadu_si256((const __m256i *)(p))
+#define V_STORE(p, v)   _mm256_storeu_si256((__m256i *)(p), v)
+#define V_ZERO()        _mm256_setzero_si256()
+#define V_AND(a, b)     _mm256_and_si256(a, b)
+#define V_ANDNOT(a, b)  _mm256_andnot_si256(a, b)
+#define V_OR(a, b)      _mm256_or_si256(a, b)
+#define V8_SET1(x)      _mm256_set1_epi8((char)(x))
+#define V8_CMPGT(a, b)  _mm256_cmpgt_epi8(a, b)
+#define V8_ADD(a, b)    _mm256_add_epi8(a, b)
+#define V8_SUB(a, b)    _mm256_sub_epi8(a, b)
+#define V16_LO(v)       _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v))
+#define V16_HI(v)       _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1))
+#define V16_SET1(x)     _mm256_set1_epi16((short)(x))
+#define V16_ADD(a, b)   _mm256_add_epi16(a, b)
+#define V16_MUL(a, b)   _mm256_mullo_epi16(a, b)
+#define V32_LO(v)       _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v))
+#define V32_HI(v)       _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1))
+#define VF_SGPA(cp, d)  _mm256_div_ps(_mm256_cvtepi32_ps(cp), _mm256_set1_ps(d))
+#define VF_STORE(p, v)  _mm256_storeu_ps(p, v)
+#else
+typedef __m128i vint;
+#define V_LOAD(p)       _mm_loadu_si128((const __m128i *)(p))
+#define V_STORE(p, v)   _mm_storeu_si128((__m128i *)(p), v)
+#define V_ZERO()        _mm_setzero_si128()
+#define V_AND(a, b)     _mm_and_si128(a, b)
+#define V_ANDNOT(a, b)  _mm_andnot_si128(a, b)
+#define V_OR(a, b)      _mm_or_si128(a, b)
+#define V8_SET1(x)      _mm_set1_epi8((char)(x))
+#define V8_CMPGT(a, b)  _mm_cmpgt_epi8(a, b)
+#define V8_ADD(a, b)    _mm_add_epi8(a, b)
+#define V8_SUB(a, b)    _mm_sub_epi8(a, b)
+#define V16_LO(v)       _mm_unpacklo_epi8(v, _mm_setzero_si128())
+#define V16_HI(v)       _mm_unpackhi_epi8(v, _mm_setzero_si128())
+#define V16_SET1(x)     _mm_set1_epi16((short)(x))
+#define V16_ADD(a, b)   _mm_add_epi16(a, b)
+#define V16_MUL(a, b)   _mm_mullo_epi16(a, b)
+#define V32_LO(v)       _mm_unpacklo_epi16(v, _mm_setzero_si128())
+#define V32_HI(v)       _mm_unpackhi_epi16(v, _mm_setzero_si128())
+#define VF_SGPA(cp, d)  _mm_div_ps(_mm_cvtepi32_ps(cp), _mm_set1_ps(d))
+#define VF_STORE(p, v)  _mm_storeu_ps(p, v)
+#endif
+
+/* Credit-points of GRADE_LANES / 4 students, 32-bit, out to the block with their SGPAs */
+static void grade_block_store_cp(GradeBlock *blk, int j, vint cp) {
+    V_STORE(blk->credit_points + j, cp);
+    if (blk->gpa_credits > 0) {
+        VF_STORE(blk->sgpa + j, VF_SGPA(cp, (float)blk->gpa_credits));
+    } else {
+        for (int k = 0; k < GRADE_LANES / 4; k++) blk->sgpa[j + k] = 0.0f;
+    }
+}
+
+static void grade_block_simd(GradeBlock *blk) {
+    int n_vec = blk->num_students / GRADE_LANES * GRADE_LANES;
+    const GradingScheme *g = blk->scheme;
+    /* cmpgt masks are -1 per passed threshold: a step of 1 (the usual one) is subtracting the
+       mask, a larger step is adding it masked in */
+    vint thr[101], inc[101];
+    int unit[101];
+    for (int k = 0; k < g->num_steps; k++) {
+        thr[k] = V8_SET1(g->step_marks[k] - 1);
+        inc[k] = V8_SET1(g->step_gp[k]);
+        unit[k] = g->step_gp[k] == 1;
+    }
+    const vint pf_thr = V8_SET1(g->pf_pass - 1);
+    const vint one = V8_SET1(1), pf_fail = V8_SET1(GP_PF_FAIL);
+
+    for (int j = 0; j < n_vec; j += GRADE_LANES) {
+        /* grade points x credits fit 16 bits: at most 127 x the semester's (byte-sized) credits */
+        vint cp_lo = V_ZERO(), cp_hi = V_ZERO(), pf = V_ZERO();
+        for (int i = 0; i < blk->num_subjects; i++) {
+            size_t col = (size_t)i * blk->stride + j;
+            vint m = V_LOAD(blk->marks + col);
+            vint gp;
+            if (blk->is_passfail[i]) {
+                vint pass = V8_CMPGT(m, pf_thr);
+                gp = V8_SUB(pf_fail, pass);
+                pf = V_OR(pf, V_ANDNOT(pass, one));
+            } else {
+                gp = V_ZERO();
+                for (int k = 0; k < g->num_steps; k++) {
+                    vint passed = V8_CMPGT(m, thr[k]);
+                    gp = unit[k] ? V8_SUB(gp, passed) : V8_ADD(gp, V_AND(passed, inc[k]));
+                }
+                vint c = V16_SET1(blk->credits[i]);
+                cp_lo = V16_ADD(cp_lo, V16_MUL(V16_LO(gp), c));
+                cp_hi = V16_ADD(cp_hi, V16_MUL(V16_HI(gp), c));
+            }
+            V_STORE(blk->grade_points + col, gp);
+        }
+        V_STORE(blk->pf_failed + j, pf);
+        grade_block_store_cp(blk, j, V32_LO(cp_lo));
+        grade_block_store_cp(blk, j + GRADE_LANES / 4, V32_HI(cp_lo));
+        grade_block_store_cp(blk, j + GRADE_LANES / 2, V32_LO(cp_hi));
+        grade_block_store_cp(blk, j + GRADE_LANES / 4 * 3, V32_HI(cp_hi));
+    }
+    grade_block_scalar_range(blk, n_vec, blk->num_students);
+}
+#endif
+/* Grade every loaded student of the block: SIMD when compiled with SSE2/AVX2, scalar otherwise */
+void grade_block_run(GradeBlock *blk) {
+    METRIC_COUNT(METRIC_GRADE_LOOKUPS, (long long)blk->num_students * blk->num_subjects);
+    METRIC_COUNT(METRIC_SEMESTERS_GRADED, blk->num_students);
+#if GRADE_LANES > 1
+    grade_block_simd(blk);
+#else
+    grade_block_scalar(blk);
+#endif
+}
+
+/* Regression check of the SIMD kernel: grade the block with it and with the scalar path and count
+   the students whose grade points, credit-points, SGPA bits or P/F flag differ. Always 0 when no
+   SIMD kernel is compiled in; -1 if out of memory. */
+int grade_block_compare(GradeBlock *blk) {
+#if GRADE_LANES > 1
+    size_t cells = (size_t)blk->num_subjects * blk->stride;
+    signed char *gp = malloc(cells ? cells : 1);
+    int *cp = malloc((size_t)blk->stride * sizeof *cp);
+    float *sgpa = malloc((size_t)blk->stride * sizeof *sgpa);
+    unsigned char *pf = malloc((size_t)blk->stride);
+    int differ = -1;
+    if (gp && cp && sgpa && pf) {
+        grade_block_simd(blk);
+        memcpy(gp, blk->grade_points, cells);
+        memcpy(cp, blk->credit_points, (size_t)blk->num_students * sizeof *cp);
+        memcpy(sgpa, blk->sgpa, (size_t)blk->num_students * sizeof *sgpa);
+        memcpy(pf, blk->pf_failed, (size_t)blk->num_students);
+        grade_block_scalar(blk);
+        differ = 0;
+        for (int j = 0; j < blk->num_students; j++) {
+            int bad = cp[j] != blk->credit_points[j] || pf[j] != blk->pf_failed[j] ||
+                      memcmp(&sgpa[j], &blk->sgpa[j], sizeof sgpa[j]) != 0;
+            for (int i = 0; i < blk->num_subjects && !bad; i++) {
+                bad = gp[(size_t)i * blk->stride + j] != blk->grade_points[(size_t)i * blk->stride + j];
+            }
+            differ += bad;
+        }
+    }
+    free(gp);
+    free(cp);
+    free(sgpa);
+    free(pf);
+    return differ;
+#else
+    (void)blk;
+    return 0;
+#endif
+}
+
+/* Bulk-grade every semester that has marks entered, for every student of the cohort. Students
+   are grouped by branch once, and one block sized for the largest semester is pointed at each
+   semester in turn. Returns the number of student-semesters graded, or -1 if out of memory. */
+long cohort_grade(Cohort *c) {
+    int max_b = -1, max_s = 0;
+    for (int b = 0; b < num_branches; b++) {
+        for (int s = 0; s < all_branches[b].num_semesters; s++) {
+            if (max_b < 0 || all_branches[b].semesters[s].num_subjects > all_branches[max_b].semesters[max_s].num_subjects) {
+                max_b = b;
+                max_s = s;
+            }
+        }
+    }
+    if (max_b < 0 || c->count == 0) return 0;
+
+    /* cohort indices ordered by branch (counting sort): branch b is order[first[b] .. first[b + 1]) */
+    int *order = malloc((size_t)c->count * sizeof *order);
+    int *first = calloc((size_t)num_branches + 1, sizeof *first);
+    GradeBlock blk;
+    if (!order || !first || !grade_block_init(&blk, max_b, max_s, GRADE_BLOCK_STUDENTS)) {
+        free(order);
+        free(first);
+        return -1;
+    }
+    for (int k = 0; k < c->count; k++) first[c->students[k].branch + 1]++;
+    for (int b = 0; b < num_branches; b++) first[b + 1] += first[b];
+    for (int k = 0; k < c->count; k++) order[first[c->students[k].branch]++] = k;
+    for (int b = num_branches; b > 0; b--) first[b] = first[b - 1];
+    first[0] = 0;
+
+    int idx[GRADE_BLOCK_STUDENTS];
+    long graded = 0;
+    for (int b = 0; b < num_branches; b++) {
+        /* every semester of one slice of the branch, while its students are still in cache */
+        for (int lo = first[b]; lo < first[b + 1]; lo += GRADE_BLOCK_STUDENTS) {
+            int hi = first[b + 1] - lo < GRADE_BLOCK_STUDENTS ? first[b + 1] : lo + GRADE_BLOCK_STUDENTS;
+            for (int s = 0; s < all_branches[b].num_semesters; s++) {
+                if (all_branches[b].semesters[s].num_subjects == 0) continue;
+                grade_block_select(&blk, b, s);
+                for (int k = lo; k < hi; k++) {
+                    const unsigned char *marks = STUDENT_MARKS(&c->students[order[k]], s);
+                    if (marks[0] == MARKS_NOT_ENTERED) continue;
+                    int j = blk.num_students++;
+                    idx[j] = order[k];
+                    for (int i = 0; i < blk.num_subjects; i++) blk.marks[(size_t)i * blk.stride + j] = marks[i];
+                }
+                if (blk.num_students == 0) continue;
+
+                grade_block_run(&blk);
+
+                for (int j = 0; j < blk.num_students; j++) {
+                    StudentRecord *st = &c->students[idx[j]];
+                    signed char *gp = STUDENT_GP(st, s);
+                    for (int i = 0; i < blk.num_subjects; i++) gp[i] = blk.grade_points[(size_t)i * blk.stride + j];
+                    st->sems[s].pf_failed = blk.pf_failed[j];
+                    commit_semester_totals(st, s, blk.credit_points[j], blk.gpa_credits);
+                }
+                graded += blk.num_students;
+            }
+        }
+    }
+    grade_block_free(&blk);
+    free(order);
+    free(first);
+    return graded;
 }
 
 void show_branch_pf_summary(int branch_index) {
@@ -779,53 +1762,6415 @@ void show_branch_pf_summary(int branch_index) {
     else printf("There are %d failed pass/fail subject(s). You must clear them to be eligible for the degree.\n", fails);
 }
 
+/* Prompt for one subject of a completed semester and apply its revised marks */
+void revaluate_subject(int branch_index) {
+    StudentRecord *st = console_student(branch_index);
+    int sem = 0, sub = 0, marks = -1;
+
+    int num_semesters = all_branches[branch_index].num_semesters;
+    printf("Semester (1-%d): ", num_semesters);
+    if (scanf("%d", &sem) != 1 || sem < 1 || sem > num_semesters || !st->sems[sem - 1].is_completed) {
+        while (getchar() != '\n');
+        printf("Semester not entered yet.\n");
+        return;
+    }
+    const Semester *syl = &all_branches[branch_index].semesters[sem - 1];
+    for (int i = 0; i < syl->num_subjects; i++) {
+        printf("  %d. %s (current marks: %d)\n", i + 1, syl->subjects[i].name, STUDENT_MARKS(st, sem - 1)[i]);
+    }
+    printf("Subject: ");
+    if (scanf("%d", &sub) != 1 || sub < 1 || sub > syl->num_subjects) {
+        while (getchar() != '\n');
+        printf("Invalid subject.\n");
+        return;
+    }
+    printf("Revised marks (0-100): ");
+    while (scanf("%d", &marks) != 1 || marks < 0 || marks > 100) {
+        printf("Invalid. Enter marks between 0 and 100: ");
+        while (getchar() != '\n');
+    }
+    apply_revaluation(st, sem - 1, sub - 1, marks);
+    if (student_store.is_open && !store_log_revaluation(&student_store, st, sem - 1, sub - 1)) {
+        printf("WARNING: could not save the revaluation to the store.\n");
+    }
+    display_report(branch_index, sem - 1);
+}
+
+/* With a store open, ask whose record the branch menu works on */
+static int select_stored_student(int branch_index) {
+    char reg_no[16];
+    printf("Register number: ");
+    if (scanf("%15s", reg_no) != 1) return 0;
+    int existing = student_index_find(&student_store, reg_no) >= 0;
+    if (!store_student(&student_store, reg_no, branch_index)) {
+        printf("Register number %s is stored under another branch.\n", reg_no);
+        return 0;
+    }
+    console_store_index[branch_index] = student_index_find(&student_store, reg_no);
+    printf(existing ? "Loaded stored record of %s.\n" : "New student %s.\n", reg_no);
+    if (!existing) {
+        char name[STUDENT_NAME_MAX + 1];
+        printf("Name (- to skip): ");
+        if (scanf(" %63[^\n]", name) == 1 && strcmp(name, "-") != 0 &&
+            !store_set_name(&student_store, console_student(branch_index), name)) {
+            printf("WARNING: could not save the name to the store.\n");
+        }
+    }
+    return 1;
+}
+
 void select_semester(int branch_index) {
     Branch *br = &all_branches[branch_index];
     int choice = 0;
+    if (student_store.is_open && !select_stored_student(branch_index)) return;
     while (1) {
         printf("\n--- Branch: %s (%s) ---\n", br->name, br->code);
-        for (int i = 0; i < SEM_COUNT; i++) {
+        for (int i = 0; i < br->num_semesters; i++) {
             printf("  %d. Semester %d %s\n", i+1, br->semesters[i].sem_number,
-                   br->semesters[i].is_completed ? "(Completed)" : "");
+                   console_student(branch_index)->sems[i].is_completed ? "(Completed)" : "");
         }
-        printf("  %d. Show total activity points & P/F summary\n", SEM_COUNT + 1);
-        printf("  %d. Back to Main Menu\n", SEM_COUNT + 2);
+        printf("  %d. Show total activity points & P/F summary\n", br->num_semesters + 1);
+        printf("  %d. Revaluation (change marks of one subject)\n", br->num_semesters + 2);
+        printf("  %d. What-if planner (SGPA needed for a target CGPA)\n", br->num_semesters + 3);
+        printf("  %d. Back to Main Menu\n", br->num_semesters + 4);
         printf("Choice: ");
         if (scanf("%d", &choice) != 1) { while (getchar() != '\n'); printf("Invalid.\n"); continue; }
-        if (choice >= 1 && choice <= SEM_COUNT) input_marks_and_calculate_sgpa(branch_index, choice - 1);
-        else if (choice == SEM_COUNT + 1) {
+        if (choice >= 1 && choice <= br->num_semesters) input_marks_and_calculate_sgpa(branch_index, choice - 1);
+        else if (choice == br->num_semesters + 1) {
             int total_ap = total_activity_points(branch_index);
             printf("\nTotal Activity Points for %s: %d / %d\n", br->code, total_ap, ACTIVITY_REQUIRED);
             if (total_ap >= ACTIVITY_REQUIRED) printf(">> Activity requirement satisfied.\n");
             else printf(">> Not satisfied. Need %d more.\n", ACTIVITY_REQUIRED - total_ap);
             show_branch_pf_summary(branch_index);
         }
-        else if (choice == SEM_COUNT + 2) return;
+        else if (choice == br->num_semesters + 2) revaluate_subject(branch_index);
+        else if (choice == br->num_semesters + 3) what_if_planner(branch_index);
+        else if (choice == br->num_semesters + 4) return;
         else printf("Invalid choice.\n");
     }
 }
 
+/* ===========================
+   Find student (main menu, with --store): lookups answered from the store indexes
+   =========================== */
+#define FIND_MAX_SHOWN 50
+
+static double bench_now(void);
+
+static void print_found_students(const int *idx, int count, double seconds) {
+    const Cohort *c = &student_store.cohort;
+    for (int i = 0; i < count && i < FIND_MAX_SHOWN; i++) {
+        const StudentRecord *st = &c->students[idx[i]];
+        char cgpa[GPA_TEXT_MAX];
+        gpa_text(cgpa, CGPA_X100(st));
+        printf("  %-15s %-6s CGPA %s  %s\n", st->reg_no, all_branches[st->branch].code, cgpa, st->name ? st->name : "");
+    }
+    if (count > FIND_MAX_SHOWN) printf("  ... and %d more\n", count - FIND_MAX_SHOWN);
+    printf("%d student(s) found in %.3f ms.\n", count, seconds * 1e3);
+}
+
+/* Ask for a branch code and semester number; 0 if the input does not name one */
+static int read_branch_semester(int *branch_index, int *sem_index) {
+    char code[16];
+    int sem = 0;
+    printf("Branch code: ");
+    if (scanf("%15s", code) != 1) return 0;
+    *branch_index = find_branch_by_code(code);
+    if (*branch_index < 0) { printf("Unknown branch %s.\n", code); return 0; }
+    printf("Semester (1-%d): ", all_branches[*branch_index].num_semesters);
+    if (scanf("%d", &sem) != 1) { while (getchar() != '\n'); return 0; }
+    if (sem < 1 || sem > all_branches[*branch_index].num_semesters) { printf("Invalid semester.\n"); return 0; }
+    *sem_index = sem - 1;
+    return 1;
+}
+
+void find_student_menu() {
+    StudentStore *ss = &student_store;
+    int *found = malloc(((size_t)ss->cohort.count + 1) * sizeof *found);
+    if (!found) { printf("Out of memory.\n"); return; }
+    int choice = 0;
+    while (1) {
+        printf("\n--- Find student (%d stored) ---\n", ss->cohort.count);
+        printf("  1. By register number\n");
+        printf("  2. By name (prefix)\n");
+        printf("  3. Failed a subject in a semester\n");
+        printf("  4. Failed a P/F subject in a semester\n");
+        printf("  5. Passed every subject in a semester\n");
+        printf("  6. Back to Main Menu\n");
+        printf("Choice: ");
+        if (scanf("%d", &choice) != 1) { while (getchar() != '\n'); printf("Invalid.\n"); continue; }
+        if (choice == 6) break;
+        if (choice < 1 || choice > 5) { printf("Invalid choice.\n"); continue; }
+
+        double t = 0.0;
+        int count = 0;
+        if (choice == 1) {
+            char reg_no[16];
+            printf("Register number: ");
+            if (scanf("%15s", reg_no) != 1) continue;
+            t = bench_now();
+            int k = student_index_find(ss, reg_no);
+            t = bench_now() - t;
+            if (k >= 0) found[count++] = k;
+        } else if (choice == 2) {
+            char prefix[STUDENT_NAME_MAX + 1];
+            printf("Name starts with: ");
+            if (scanf(" %63[^\n]", prefix) != 1) continue;
+            t = bench_now();
+            count = index_find_name_prefix(ss, prefix, found, ss->cohort.count);
+            t = bench_now() - t;
+        } else {
+            int b, s;
+            if (!read_branch_semester(&b, &s)) continue;
+            int filter = choice == 3 ? QUERY_FAILED : choice == 4 ? QUERY_PF_FAILED : QUERY_PASSED;
+            t = bench_now();
+            count = index_query(ss, b, s, filter, found, ss->cohort.count);
+            t = bench_now() - t;
+        }
+        if (!ss->index.ready && choice != 1) printf("Student index unavailable (out of memory).\n");
+        print_found_students(found, count, t);
+    }
+    free(found);
+}
+
 void show_main_menu() {
     int choice = 0;
     while (1) {
         printf("\n===== MBCET SGPA / CGPA Calculator (Final) =====\n");
-        for (int i = 0; i < MAX_BRANCHES; i++) {
+        for (int i = 0; i < num_branches; i++) {
             printf("  %d. %s (%s)\n", i+1, all_branches[i].name, all_branches[i].code);
         }
-        printf("  %d. Exit\n", MAX_BRANCHES + 1);
+        int find = student_store.is_open ? num_branches + 1 : 0;    /* menu entry, 0 = none */
+        if (find) printf("  %d. Find student\n", find);
+        printf("  %d. Exit\n", num_branches + 1 + (find != 0));
         printf("Enter choice: ");
         if (scanf("%d", &choice) != 1) { while (getchar() != '\n'); printf("Invalid.\n"); continue; }
-        if (choice >= 1 && choice <= MAX_BRANCHES) select_semester(choice - 1);
-        else if (choice == MAX_BRANCHES + 1) { printf("Exiting. Goodbye!\n"); exit(0); }
+        if (choice >= 1 && choice <= num_branches) select_semester(choice - 1);
+        else if (find && choice == find) find_student_menu();
+        else if (choice == num_branches + 1 + (find != 0)) { printf("Exiting. Goodbye!\n"); return; }
         else printf("Invalid.\n");
     }
 }
 
-int main() {
-    initialize_branches();
-    preload_subjects_mbcet();
-    printf("MBCET CGPA System initialized. CE, ME, EEE, ECE & CS syllabi loaded (CT removed as requested).\n");
-    printf("Note: P/F subjects are asked by marks and do not affect SGPA/CGPA. Pass threshold for P/F = 50.\n");
-    show_main_menu();
+/* ===========================
+   Persistent student store (--store DIR).
+   Every mark entry is appended to DIR/marks.log as a checksummed event record and
+   fsync'ed in groups; DIR/students.snap holds a compacted image of the whole cohort.
+   Startup maps the snapshot, then replays the log; a torn record at the tail (crash
+   mid-write) is dropped. Compaction writes a new snapshot, renames it into place and
+   truncates the log. Replaying an event twice gives the same state, so a crash at any
+   point of compaction is safe.
+   =========================== */
+#define STORE_LOG_NAME "marks.log"
+#define STORE_SNAPSHOT_NAME "students.snap"
+#define STORE_SNAPSHOT_MAGIC "MBSTO02"
+#define STORE_SNAPSHOT_MAGIC_V1 "MBSTO01"       /* same entries without names */
+#define STORE_RECORD_MAGIC 0x4D424C47u      /* "MBLG" */
+#define STORE_COMPACT_RECORDS 10000         /* compact at startup once the log is this long */
+#define STORE_BATCH_SYNC 4096               /* batch imports fsync once per this many records */
+#define LOG_SEMESTER_MARKS 1
+#define LOG_REVALUATION 2
+#define LOG_STUDENT_NAME 3
+
+typedef struct {
+    unsigned int magic;
+    unsigned int length;            // bytes of LogEntry + marks that follow
+    unsigned int checksum;          // of those bytes
+} LogRecordHeader;
+
+typedef struct {
+    unsigned char type;             // LOG_SEMESTER_MARKS, LOG_REVALUATION or LOG_STUDENT_NAME
+    unsigned char sem_index;
+    unsigned short branch;
+    char reg_no[16];
+    unsigned char activity_points;
+    unsigned char subject_index;    // revaluation only
+    unsigned short num_marks;       // marks bytes that follow (name bytes for LOG_STUDENT_NAME)
+} LogEntry;
+
+typedef struct {
+    char magic[8];
+    unsigned int syllabus_fingerprint;
+    unsigned int count;
+} SnapshotHeader;
+
+typedef struct {
+    char reg_no[16];
+    int branch;
+    float cgpa;
+    int total_credit_points;
+    int total_credits;
+    /* followed by SemesterResult[num_semesters], marks[num_subjects], grade_points[num_subjects],
+       then (MBSTO02) an unsigned char name length and the name bytes */
+} SnapshotEntry;
+
+static unsigned int checksum32(const void *data, size_t len) {
+    const unsigned char *p = data;
+    unsigned int h = 2166136261u;
+    while (len--) h = (h ^ *p++) * 16777619u;
+    return h;
+}
+
+/* Identifies the syllabus layout (and any non-regular grading) a snapshot was written against */
+static unsigned int syllabus_fingerprint(void) {
+    GradingScheme regular;
+    build_scheme(&regular, "regular", regular_thresholds, 6, 50, 10);
+    unsigned int h = checksum32(&num_branches, sizeof num_branches);
+    for (int b = 0; b < num_branches; b++) {
+        const Branch *br = &all_branches[b];
+        h ^= checksum32(br->code, strlen(br->code));
+        for (int s = 0; s < br->num_semesters; s++) {
+            const GradingScheme *g = SEMESTER_SCHEME(&br->semesters[s]);
+            if (g->pf_pass != regular.pf_pass || memcmp(g->grade_point, regular.grade_point, sizeof g->grade_point) != 0) {
+                h = h * 31u + checksum32(g->grade_point, sizeof g->grade_point) + g->pf_pass;
+            }
+            for (int i = 0; i < br->semesters[s].num_subjects; i++) {
+                int v[2] = { br->semesters[s].subjects[i].credits, br->semesters[s].subjects[i].is_passfail };
+                h = h * 31u + checksum32(v, sizeof v) + (unsigned int)(s * 64 + i);
+            }
+        }
+    }
+    return h;
+}
+
+static void store_path(char *buf, size_t size, const char *dir, const char *name) {
+    snprintf(buf, size, "%s/%s", dir, name);
+}
+
+static int sync_file(FILE *f) {
+    if (fflush(f) != 0) return 0;
+#ifdef HAVE_POSIX
+    if (fsync(fileno(f)) != 0) return 0;
+#endif
+    return 1;
+}
+
+/* Register number -> cohort index, open addressing, slots hold index + 1 */
+int student_index_find(const StudentStore *ss, const char *reg_no) {
+    if (!ss->num_slots) return -1;
+    unsigned int j = hash_string(reg_no) & (ss->num_slots - 1);
+    while (ss->slots[j]) {
+        int idx = ss->slots[j] - 1;
+        if (strcmp(ss->cohort.students[idx].reg_no, reg_no) == 0) return idx;
+        j = (j + 1) & (ss->num_slots - 1);
+    }
+    return -1;
+}
+
+static int student_index_insert(StudentStore *ss, int idx) {
+    if ((unsigned int)(ss->cohort.count + 1) * 2 > ss->num_slots) {
+        unsigned int n = ss->num_slots ? ss->num_slots * 2 : 1024;
+        int *slots = calloc(n, sizeof *slots);
+        if (!slots) return 0;
+        for (unsigned int i = 0; i < ss->num_slots; i++) {
+            if (!ss->slots[i]) continue;
+            unsigned int j = hash_string(ss->cohort.students[ss->slots[i] - 1].reg_no) & (n - 1);
+            while (slots[j]) j = (j + 1) & (n - 1);
+            slots[j] = ss->slots[i];
+        }
+        free(ss->slots);
+        ss->slots = slots;
+        ss->num_slots = n;
+    }
+    unsigned int j = hash_string(ss->cohort.students[idx].reg_no) & (ss->num_slots - 1);
+    while (ss->slots[j]) j = (j + 1) & (ss->num_slots - 1);
+    ss->slots[j] = idx + 1;
+    return 1;
+}
+
+/* ===========================
+   Student index over the store (help-desk lookups).
+   Register number: the store's hash (student_index_find). Name: cohort indices sorted by name,
+   case-insensitive, searched by binary search for a prefix; re-sorted lazily after names change.
+   Status: one bitmap per branch and, per semester, bitmaps of completed / failed (a regular
+   subject at grade point 0) / pf_failed students, kept current as records change, so a filter
+   like "ECE, S3, failing P/F" is a word-wise AND of two bitmaps.
+   =========================== */
+static int bitmap_grow(unsigned long long **rows, int num_rows, size_t old_words, size_t words) {
+    for (int r = 0; r < num_rows; r++) {
+        unsigned long long *grown = realloc(rows[r], words * sizeof *grown);
+        if (!grown) return 0;
+        memset(grown + old_words, 0, (words - old_words) * sizeof *grown);
+        rows[r] = grown;
+    }
+    return 1;
+}
+
+static void bitmap_put(unsigned long long *row, int k, int on) {
+    unsigned long long bit = 1ull << (k & 63);
+    if (on) row[k >> 6] |= bit;
+    else row[k >> 6] &= ~bit;
+}
+
+/* Bring the bitmaps up to date for cohort student k */
+static void index_note_student(StudentStore *ss, int k) {
+    StudentIndex *ix = &ss->index;
+    if (!ix->ready) return;
+    size_t need = ((size_t)ss->cohort.count + 63) / 64;
+    if (need > ix->words) {
+        size_t words = ix->words * 2 > need ? ix->words * 2 : need;
+        if (!bitmap_grow(ix->branch_bits, num_branches, ix->words, words) ||
+            !bitmap_grow(ix->completed_bits, ix->max_semesters, ix->words, words) ||
+            !bitmap_grow(ix->failed_bits, ix->max_semesters, ix->words, words) ||
+            !bitmap_grow(ix->pf_failed_bits, ix->max_semesters, ix->words, words)) {
+            ix->ready = 0;          /* out of memory: lookups fall back to "index unavailable" */
+            return;
+        }
+        ix->words = words;
+    }
+    const StudentRecord *st = &ss->cohort.students[k];
+    const Branch *br = &all_branches[st->branch];
+    bitmap_put(ix->branch_bits[st->branch], k, 1);
+    for (int s = 0; s < br->num_semesters; s++) {
+        const Semester *syl = &br->semesters[s];
+        int done = st->sems[s].is_completed, failed = 0;
+        for (int i = 0; done && i < syl->num_subjects && !failed; i++) {
+            failed = !syl->subjects[i].is_passfail && STUDENT_GP(st, s)[i] == 0;
+        }
+        bitmap_put(ix->completed_bits[s], k, done);
+        bitmap_put(ix->failed_bits[s], k, failed);
+        bitmap_put(ix->pf_failed_bits[s], k, done && st->sems[s].pf_failed);
+    }
+    if (st->name) ix->names_dirty = 1;
+}
+
+static void index_free(StudentIndex *ix) {
+    for (int b = 0; ix->branch_bits && b < num_branches; b++) free(ix->branch_bits[b]);
+    for (int s = 0; ix->completed_bits && s < ix->max_semesters; s++) {
+        free(ix->completed_bits[s]);
+        free(ix->failed_bits[s]);
+        free(ix->pf_failed_bits[s]);
+    }
+    free(ix->branch_bits);
+    free(ix->completed_bits);
+    free(ix->failed_bits);
+    free(ix->pf_failed_bits);
+    free(ix->by_name);
+    memset(ix, 0, sizeof *ix);
+}
+
+/* Build the index over everything loaded so far; later changes are folded in as they happen */
+static int index_build(StudentStore *ss) {
+    StudentIndex *ix = &ss->index;
+    memset(ix, 0, sizeof *ix);
+    for (int b = 0; b < num_branches; b++) {
+        if (all_branches[b].num_semesters > ix->max_semesters) ix->max_semesters = all_branches[b].num_semesters;
+    }
+    ix->branch_bits = calloc((size_t)num_branches, sizeof *ix->branch_bits);
+    ix->completed_bits = calloc((size_t)ix->max_semesters + 1, sizeof *ix->completed_bits);
+    ix->failed_bits = calloc((size_t)ix->max_semesters + 1, sizeof *ix->failed_bits);
+    ix->pf_failed_bits = calloc((size_t)ix->max_semesters + 1, sizeof *ix->pf_failed_bits);
+    if (!ix->branch_bits || !ix->completed_bits || !ix->failed_bits || !ix->pf_failed_bits) { index_free(ix); return 0; }
+    ix->ready = 1;
+    for (int k = 0; k < ss->cohort.count && ix->ready; k++) index_note_student(ss, k);
+    ix->names_dirty = 1;
+    return ix->ready;
+}
+
+static int name_prefix_cmp(const char *name, const char *prefix, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int a = tolower((unsigned char)name[i]), b = tolower((unsigned char)prefix[i]);
+        if (a != b || a == 0) return a - b;
+    }
+    return 0;
+}
+
+static const Cohort *name_sort_cohort;     /* qsort has no context argument */
+
+static int by_name_cmp(const void *x, const void *y) {
+    const StudentRecord *a = &name_sort_cohort->students[*(const int *)x];
+    const StudentRecord *b = &name_sort_cohort->students[*(const int *)y];
+    int c = name_prefix_cmp(a->name, b->name, strlen(a->name) + 1);
+    return c ? c : strcmp(a->reg_no, b->reg_no);
+}
+
+/* Students whose name starts with prefix (case-insensitive), in name order. Returns the match count. */
+int index_find_name_prefix(StudentStore *ss, const char *prefix, int *out, int max_out) {
+    StudentIndex *ix = &ss->index;
+    if (ix->names_dirty) {
+        int *by_name = realloc(ix->by_name, ((size_t)ss->cohort.count + 1) * sizeof *by_name);
+        if (!by_name) return 0;
+        ix->by_name = by_name;
+        ix->num_named = 0;
+        for (int k = 0; k < ss->cohort.count; k++) if (ss->cohort.students[k].name) by_name[ix->num_named++] = k;
+        name_sort_cohort = &ss->cohort;
+        qsort(by_name, (size_t)ix->num_named, sizeof *by_name, by_name_cmp);
+        ix->names_dirty = 0;
+    }
+    size_t n = strlen(prefix);
+    int lo = 0, hi = ix->num_named;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (name_prefix_cmp(ss->cohort.students[ix->by_name[mid]].name, prefix, n) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    int count = 0;
+    for (int i = lo; i < ix->num_named && name_prefix_cmp(ss->cohort.students[ix->by_name[i]].name, prefix, n) == 0; i++, count++) {
+        if (count < max_out) out[count] = ix->by_name[i];
+    }
+    return count;
+}
+
+/* Students of a branch whose semester matches filter, via bitmap ANDs. Returns the match count. */
+int index_query(StudentStore *ss, int branch_index, int sem_index, int filter, int *out, int max_out) {
+    StudentIndex *ix = &ss->index;
+    if (!ix->ready || sem_index < 0 || sem_index >= all_branches[branch_index].num_semesters) return 0;
+    const unsigned long long *br = ix->branch_bits[branch_index];
+    const unsigned long long *done = ix->completed_bits[sem_index];
+    const unsigned long long *failed = ix->failed_bits[sem_index];
+    const unsigned long long *pf = ix->pf_failed_bits[sem_index];
+    size_t words = ((size_t)ss->cohort.count + 63) / 64;
+    int count = 0;
+    for (size_t w = 0; w < words; w++) {
+        unsigned long long m = br[w] & done[w];
+        if (filter == QUERY_PF_FAILED) m &= pf[w];
+        else if (filter == QUERY_FAILED) m &= failed[w];
+        else if (filter == QUERY_PASSED) m &= ~(failed[w] | pf[w]);
+        for (; m; m &= m - 1, count++) {
+            if (count < max_out) out[count] = (int)(w * 64) + lowest_bit(m);
+        }
+    }
+    return count;
+}
+
+/* Find a student by register number, creating an empty record if new. NULL if the register
+   number belongs to another branch or memory ran out. Valid until the next call. */
+StudentRecord *store_student(StudentStore *ss, const char *reg_no, int branch_index) {
+    int idx = student_index_find(ss, reg_no);
+    if (idx >= 0) {
+        StudentRecord *st = &ss->cohort.students[idx];
+        return st->branch == branch_index ? st : NULL;
+    }
+    if (!cohort_add(&ss->cohort, reg_no, branch_index)) return NULL;
+    if (!student_index_insert(ss, ss->cohort.count - 1)) { ss->cohort.count--; return NULL; }
+    index_note_student(ss, ss->cohort.count - 1);
+    return &ss->cohort.students[ss->cohort.count - 1];
+}
+
+/* Apply one logged event to the in-memory cohort; 0 if it does not fit the syllabus */
+static int store_apply(StudentStore *ss, const LogEntry *e, const unsigned char *marks) {
+    if (e->branch >= num_branches || memchr(e->reg_no, '\0', sizeof e->reg_no) == NULL) return 0;
+    const Branch *br = &all_branches[e->branch];
+    if (e->sem_index >= br->num_semesters) return 0;
+    const Semester *syl = &br->semesters[e->sem_index];
+
+    StudentRecord *st = store_student(ss, e->reg_no, e->branch);
+    if (!st) return 0;
+    if (e->type == LOG_STUDENT_NAME) {
+        if (e->num_marks == 0 || e->num_marks > STUDENT_NAME_MAX || memchr(marks, '\0', e->num_marks)) return 0;
+        char *name = arena_alloc(&ss->cohort.arena, (size_t)e->num_marks + 1);
+        if (!name) return 0;
+        memcpy(name, marks, e->num_marks);
+        name[e->num_marks] = '\0';
+        st->name = name;
+        return 1;
+    }
+    for (int i = 0; i < e->num_marks; i++) if (marks[i] > 100) return 0;
+    if (e->type == LOG_SEMESTER_MARKS) {
+        if (e->num_marks != syl->num_subjects || e->activity_points > 150) return 0;
+        for (int i = 0; i < e->num_marks; i++) set_subject_marks(st, e->sem_index, i, marks[i]);
+        st->sems[e->sem_index].activity_points = e->activity_points;
+        update_pf_failed(st, e->sem_index);
+        grade_semester(st, e->sem_index);
+        return 1;
+    }
+    if (e->type == LOG_REVALUATION) {
+        if (e->num_marks != 1 || e->subject_index >= syl->num_subjects) return 0;
+        apply_revaluation(st, e->sem_index, e->subject_index, marks[0]);
+        return 1;
+    }
     return 0;
 }
+
+static int store_load_snapshot(StudentStore *ss, const char *path) {
+    size_t size = 0;
+    int mapped = 0;
+    const char *data = map_file(path, &size, &mapped);
+    if (!data) return 1;                            /* no snapshot yet */
+
+    const SnapshotHeader *h = (const SnapshotHeader *)data;
+    int ok = size >= sizeof *h && (memcmp(h->magic, STORE_SNAPSHOT_MAGIC, sizeof h->magic) == 0 ||
+                                   memcmp(h->magic, STORE_SNAPSHOT_MAGIC_V1, sizeof h->magic) == 0);
+    int has_names = ok && memcmp(h->magic, STORE_SNAPSHOT_MAGIC, sizeof h->magic) == 0;
+    if (ok && h->syllabus_fingerprint != syllabus_fingerprint()) {
+        fprintf(stderr, "%s: written for a different syllabus; refusing to load\n", path);
+        unmap_file(data, size, mapped);
+        return 0;
+    }
+    size_t pos = sizeof *h;
+    for (unsigned int n = 0; ok && n < h->count; n++) {
+        SnapshotEntry e;
+        if (pos + sizeof e > size) { ok = 0; break; }
+        memcpy(&e, data + pos, sizeof e);
+        pos += sizeof e;
+        if (e.branch < 0 || e.branch >= num_branches || memchr(e.reg_no, '\0', sizeof e.reg_no) == NULL) { ok = 0; break; }
+        const Branch *br = &all_branches[e.branch];
+        size_t sems = (size_t)br->num_semesters * sizeof(SemesterResult);
+        if (pos + sems + 2 * (size_t)br->num_subjects > size) { ok = 0; break; }
+
+        StudentRecord *st = store_student(ss, e.reg_no, e.branch);
+        if (!st) { ok = 0; break; }
+        st->cgpa = e.cgpa;
+        st->total_credit_points = e.total_credit_points;
+        st->total_credits = e.total_credits;
+        memcpy(st->sems, data + pos, sems);
+        pos += sems;
+        memcpy(st->marks, data + pos, (size_t)br->num_subjects);
+        pos += (size_t)br->num_subjects;
+        memcpy(st->grade_points, data + pos, (size_t)br->num_subjects);
+        pos += (size_t)br->num_subjects;
+        if (!has_names) continue;
+        size_t len = pos < size ? (unsigned char)data[pos] : 0;
+        if (pos + 1 + len > size || len > STUDENT_NAME_MAX) { ok = 0; break; }
+        if (len) {
+            char *name = arena_alloc(&ss->cohort.arena, len + 1);
+            if (!name) { ok = 0; break; }
+            memcpy(name, data + pos + 1, len);
+            name[len] = '\0';
+            st->name = name;
+        }
+        pos += 1 + len;
+    }
+    if (!ok) fprintf(stderr, "%s: corrupt snapshot\n", path);
+    unmap_file(data, size, mapped);
+    return ok;
+}
+
+/* Replay the log; stops at the first torn or corrupt record and reports whether one was found */
+static int store_replay_log(StudentStore *ss, const char *path, int *torn) {
+    size_t size = 0;
+    int mapped = 0;
+    *torn = 0;
+    const char *data = map_file(path, &size, &mapped);
+    if (!data) return 1;
+
+    size_t pos = 0;
+    while (pos + sizeof(LogRecordHeader) <= size) {
+        LogRecordHeader rh;
+        memcpy(&rh, data + pos, sizeof rh);
+        if (rh.magic != STORE_RECORD_MAGIC || rh.length < sizeof(LogEntry) ||
+            rh.length > size - pos - sizeof rh ||
+            checksum32(data + pos + sizeof rh, rh.length) != rh.checksum) break;
+        LogEntry e;
+        memcpy(&e, data + pos + sizeof rh, sizeof e);
+        if (sizeof e + e.num_marks != rh.length) break;
+        if (!store_apply(ss, &e, (const unsigned char *)data + pos + sizeof rh + sizeof e)) {
+            fprintf(stderr, "%s: skipping event for %.16s that does not match the syllabus\n", path, e.reg_no);
+        }
+        pos += sizeof rh + rh.length;
+        ss->log_records++;
+    }
+    if (pos < size) {
+        fprintf(stderr, "%s: dropped %zu byte(s) of incomplete log tail\n", path, size - pos);
+        *torn = 1;
+    }
+    unmap_file(data, size, mapped);
+    return 1;
+}
+
+int store_open(StudentStore *ss, const char *dir, int sync_every) {
+    char path[1024];
+    memset(ss, 0, sizeof *ss);
+    cohort_init(&ss->cohort);
+    snprintf(ss->dir, sizeof ss->dir, "%s", dir);
+    ss->sync_every = sync_every > 0 ? sync_every : 1;
+#ifdef HAVE_POSIX
+    mkdir(dir, 0755);
+#endif
+
+    store_path(path, sizeof path, dir, STORE_SNAPSHOT_NAME);
+    if (!store_load_snapshot(ss, path)) return 0;
+
+    int torn = 0;
+    store_path(path, sizeof path, dir, STORE_LOG_NAME);
+    if (!store_replay_log(ss, path, &torn)) return 0;
+    ss->log = fopen(path, "ab");
+    if (!ss->log) { perror(path); return 0; }
+    ss->is_open = 1;
+    if (!index_build(ss)) fprintf(stderr, "%s: not enough memory for the student index\n", dir);
+
+    /* a torn tail must go before anything is appended after it */
+    if ((torn || ss->log_records >= STORE_COMPACT_RECORDS) && !store_compact(ss)) return 0;
+    return 1;
+}
+
+/* Append one event; fsync once sync_every events are pending */
+static int store_append(StudentStore *ss, const LogEntry *e, const unsigned char *marks) {
+    static unsigned char buf[sizeof(LogRecordHeader) + sizeof(LogEntry) + USHRT_MAX];
+    LogRecordHeader rh;
+    METRIC_START(t0);
+    rh.magic = STORE_RECORD_MAGIC;
+    rh.length = (unsigned int)(sizeof *e + e->num_marks);
+    memcpy(buf + sizeof rh, e, sizeof *e);
+    memcpy(buf + sizeof rh + sizeof *e, marks, e->num_marks);
+    rh.checksum = checksum32(buf + sizeof rh, rh.length);
+    memcpy(buf, &rh, sizeof rh);
+
+    if (fwrite(buf, 1, sizeof rh + rh.length, ss->log) != sizeof rh + rh.length) return 0;
+    ss->log_records++;
+    METRIC_COUNT(METRIC_STORE_RECORDS, 1);
+    int ok = ++ss->pending >= ss->sync_every ? store_sync(ss) : 1;
+    METRIC_STOP(TIMER_STORE_APPEND, t0);
+    return ok;
+}
+
+int store_sync(StudentStore *ss) {
+    if (!ss->is_open || ss->pending == 0) return 1;
+    ss->pending = 0;
+    METRIC_START(t0);
+    int ok = sync_file(ss->log);
+    METRIC_STOP(TIMER_STORE_SYNC, t0);
+    if (!ok) { perror(STORE_LOG_NAME); return 0; }
+    return 1;
+}
+
+/* Log the full marks and activity points of one graded semester */
+int store_log_semester(StudentStore *ss, const StudentRecord *st, int sem_index) {
+    const Semester *syl = &all_branches[st->branch].semesters[sem_index];
+    LogEntry e;
+    memset(&e, 0, sizeof e);
+    e.type = LOG_SEMESTER_MARKS;
+    e.sem_index = (unsigned char)sem_index;
+    e.branch = (unsigned short)st->branch;
+    memcpy(e.reg_no, st->reg_no, sizeof e.reg_no);
+    e.activity_points = st->sems[sem_index].activity_points;
+    e.num_marks = (unsigned short)syl->num_subjects;
+    index_note_student(ss, (int)(st - ss->cohort.students));
+    return store_append(ss, &e, STUDENT_MARKS(st, sem_index));
+}
+
+int store_log_revaluation(StudentStore *ss, const StudentRecord *st, int sem_index, int subject_index) {
+    LogEntry e;
+    memset(&e, 0, sizeof e);
+    e.type = LOG_REVALUATION;
+    e.sem_index = (unsigned char)sem_index;
+    e.branch = (unsigned short)st->branch;
+    memcpy(e.reg_no, st->reg_no, sizeof e.reg_no);
+    e.subject_index = (unsigned char)subject_index;
+    e.num_marks = 1;
+    index_note_student(ss, (int)(st - ss->cohort.students));
+    return store_append(ss, &e, &STUDENT_MARKS(st, sem_index)[subject_index]);
+}
+
+/* Give a stored student a name (logged like marks) */
+int store_set_name(StudentStore *ss, StudentRecord *st, const char *name) {
+    size_t len = strlen(name);
+    if (len == 0 || len > STUDENT_NAME_MAX) return 0;
+    char *copy = arena_alloc(&ss->cohort.arena, len + 1);
+    if (!copy) return 0;
+    memcpy(copy, name, len + 1);
+    st->name = copy;
+    ss->index.names_dirty = 1;
+
+    LogEntry e;
+    memset(&e, 0, sizeof e);
+    e.type = LOG_STUDENT_NAME;
+    e.branch = (unsigned short)st->branch;
+    memcpy(e.reg_no, st->reg_no, sizeof e.reg_no);
+    e.num_marks = (unsigned short)len;
+    return store_append(ss, &e, (const unsigned char *)name);
+}
+
+/* Write the whole cohort to a fresh snapshot, swap it in, then empty the log */
+int store_compact(StudentStore *ss) {
+    char tmp[1024], snap[1024], log[1024];
+    store_path(tmp, sizeof tmp, ss->dir, STORE_SNAPSHOT_NAME ".tmp");
+    store_path(snap, sizeof snap, ss->dir, STORE_SNAPSHOT_NAME);
+    store_path(log, sizeof log, ss->dir, STORE_LOG_NAME);
+    if (!store_sync(ss)) return 0;
+    METRIC_START(t0);
+
+    FILE *out = fopen(tmp, "wb");
+    if (!out) { perror(tmp); return 0; }
+    SnapshotHeader h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, STORE_SNAPSHOT_MAGIC, sizeof h.magic);
+    h.syllabus_fingerprint = syllabus_fingerprint();
+    h.count = (unsigned int)ss->cohort.count;
+    int ok = fwrite(&h, sizeof h, 1, out) == 1;
+    for (int k = 0; ok && k < ss->cohort.count; k++) {
+        const StudentRecord *st = &ss->cohort.students[k];
+        const Branch *br = &all_branches[st->branch];
+        SnapshotEntry e;
+        memset(&e, 0, sizeof e);
+        memcpy(e.reg_no, st->reg_no, sizeof e.reg_no);
+        e.branch = st->branch;
+        e.cgpa = st->cgpa;
+        e.total_credit_points = st->total_credit_points;
+        e.total_credits = st->total_credits;
+        ok = fwrite(&e, sizeof e, 1, out) == 1
+          && fwrite(st->sems, sizeof(SemesterResult), (size_t)br->num_semesters, out) == (size_t)br->num_semesters
+          && fwrite(st->marks, 1, (size_t)br->num_subjects, out) == (size_t)br->num_subjects
+          && fwrite(st->grade_points, 1, (size_t)br->num_subjects, out) == (size_t)br->num_subjects;
+        unsigned char len = (unsigned char)(st->name ? strlen(st->name) : 0);
+        ok = ok && fwrite(&len, 1, 1, out) == 1 && fwrite(st->name ? st->name : "", 1, len, out) == len;
+    }
+    if (!sync_file(out)) ok = 0;
+    if (fclose(out) != 0) ok = 0;
+    if (!ok || rename(tmp, snap) != 0) {
+        perror(snap);
+        remove(tmp);
+        return 0;
+    }
+#ifdef HAVE_POSIX
+    int dfd = open(ss->dir, O_RDONLY);
+    if (dfd >= 0) { fsync(dfd); close(dfd); }
+#endif
+    FILE *fresh = freopen(log, "wb", ss->log);
+    if (!fresh) { perror(log); ss->is_open = 0; return 0; }
+    ss->log = fresh;
+    ss->log_records = 0;
+    METRIC_STOP(TIMER_STORE_COMPACT, t0);
+    return 1;
+}
+
+/* Flush, compact if anything was logged this run, and release the store */
+void store_close(StudentStore *ss) {
+    if (!ss->is_open) return;
+    if (ss->log_records > 0) store_compact(ss);
+    else store_sync(ss);
+    if (ss->log) fclose(ss->log);
+    free(ss->slots);
+    index_free(&ss->index);
+    cohort_free(&ss->cohort);
+    ss->is_open = 0;
+}
+
+/* ===========================
+   Batch mode: grade a whole cohort from a marks file, no prompts.
+   Input (CSV or TSV), one row per student-semester, rows of one student kept together:
+     student_id, branch_code, semester, <marks per subject in syllabus order>, activity_points
+   Output (CSV): student_id,branch,semester,sgpa,cgpa,pf_failed,pf_failures,activity_total
+   Only one scratch StudentRecord per branch is live, so memory is constant for any file size
+   (per worker with --threads, where the output is buffered until the end).
+   A named input file is mapped and every row is split and parsed where it lies: no per-row
+   allocation. Rejected rows never stop the run; with --errors FILE they are collected
+   there, each under a comment giving the line and the reason.
+   --batch grades in bulk: up to BATCH_BLOCK_ROWS parsed rows are queued into one column-major
+   GradeBlock per branch-semester, graded by the SIMD kernel, then committed to the students and
+   written out in input order, so CGPA still accumulates row by row. The report modes grade one
+   row at a time (batch_grade_row) since they look at each student as soon as the row is read.
+   =========================== */
+#define BATCH_LINE_MAX 4096
+#define BATCH_BLOCK_ROWS 1024               /* rows per kernel pass of the bulk path */
+#define BATCH_PENDING_TEXT (128u << 10)     /* queued row text, kept for rejects after grading */
+#define BATCH_OUTPUT_HEADER "student_id,branch,semester,sgpa,cgpa,pf_failed,pf_failures,activity_total"
+
+FILE *batch_errors;                 /* --errors FILE: rejected rows go here instead of stderr */
+
+static FILE *batch_err(void) {
+    return batch_errors ? batch_errors : stderr;
+}
+
+int find_branch_by_code(const char *code) {
+    for (int i = 0; i < num_branches; i++) {
+        if (strcmp(all_branches[i].code, code) == 0) return i;
+    }
+    return -1;
+}
+
+static int find_branch_by_span(const char *code, size_t len) {
+    for (int i = 0; i < num_branches; i++) {
+        if (strlen(all_branches[i].code) == len && memcmp(all_branches[i].code, code, len) == 0) return i;
+    }
+    return -1;
+}
+
+/* Split a row in place on ',' or '\t' without copying: fields[i] points into the row and
+   lens[i] is its trimmed length. Returns the field count, or max_fields + 1 if there are more. */
+static int split_row(const char *p, const char *end, const char **fields, int *lens, int max_fields) {
+    int n = 0;
+    while (1) {
+        while (p < end && *p == ' ') p++;
+        if (n == max_fields) return max_fields + 1;
+        const char *start = p;
+        while (p < end && *p != ',' && *p != '\t' && *p != '\n' && *p != '\r') p++;
+        const char *stop = p;
+        while (stop > start && stop[-1] == ' ') stop--;
+        fields[n] = start;
+        lens[n++] = (int)(stop - start);
+        if (p == end || (*p != ',' && *p != '\t')) return n;
+        p++;
+    }
+}
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HAVE_SWAR_DIGITS 1
+#endif
+
+/* parse_int_field() for a field that is not NUL-terminated. Fields of up to 8 digits are
+   checked and converted as one 64-bit word (SWAR) when 8 bytes from f are readable (limit);
+   signs, longer fields, non-digits and fields at the very end of the input take the scalar path. */
+static int parse_int_span(const char *f, int len, const char *limit, int *out) {
+#ifdef HAVE_SWAR_DIGITS
+    if (len >= 1 && len <= 8 && limit - f >= 8) {
+        unsigned long long w;
+        int pad = 8 * (8 - len);
+        memcpy(&w, f, sizeof w);
+        w = (w << pad) | (0x3030303030303030ull & ~(~0ull << pad));     /* left-pad with '0' */
+        if ((w & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull &&
+            ((w + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull) {
+            w -= 0x3030303030303030ull;
+            w = w * 10 + (w >> 8);                                      /* pairs of digits */
+            w = ((w & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) +
+                 ((w >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >> 32;
+            if (w > 100000) return 0;
+            *out = (int)w;
+            return 1;
+        }
+    }
+#else
+    (void)limit;
+#endif
+    int i = 0, neg = 0;
+    long v = 0;
+    if (i < len && (f[i] == '+' || f[i] == '-')) neg = f[i++] == '-';
+    if (i == len) return 0;
+    for (; i < len; i++) {
+        if (f[i] < '0' || f[i] > '9') return 0;
+        v = v * 10 + (f[i] - '0');
+        if (v > 100000) return 0;
+    }
+    *out = (int)(neg ? -v : v);
+    return 1;
+}
+
+static int parse_int_field(const char *f, int *out) {
+    char *end;
+    if (*f == '\0') return 0;
+    long v = strtol(f, &end, 10);
+    if (*end != '\0' || v < -100000 || v > 100000) return 0;
+    *out = (int)v;
+    return 1;
+}
+
+/* A row queued for bulk grading: its marks sit in column `slot` of its branch-semester block */
+typedef struct {
+    long line_no;
+    int branch;
+    int sem;                        // 0-based
+    int activity_points;
+    int slot;
+    int student;                    // stored student index with --store, else -1 (scratch record)
+    int starts;                     // first row of a student: the scratch record is cleared
+    size_t text;                    // offset of the row in pending_text
+    size_t len;
+    char id[16];
+} BatchPending;
+
+/* Per-run batch state: one scratch StudentRecord per branch plus the current student */
+typedef struct {
+    Arena arena;
+    StudentRecord *scratch;         // [num_branches]
+    const char **fields;            // [max_fields] pointers into the current row
+    int *field_len;                 // [max_fields]
+    int *marks;                     // [max_fields]
+    const char *limit;              // end of the buffer rows are read from (bounds 8-byte loads)
+    int reject_rows;                // --errors: rejected rows are copied to the error stream
+    int max_fields;
+    StudentRecord *student;         // record of the student currently being graded
+    int to_store;                   // with --store: rows grade the stored students and are logged;
+                                    // cleared by the report modes, which only read (scratch records)
+    char current_id[32];
+    int current_branch;
+    char first_id[32];              // first student started (parallel chunks only look at it)
+    int first_branch;
+    long graded;
+    long rejected;
+    GradeBlock *blocks;             // [semesters of all branches] bulk path, set up on first use
+    int *first_block;               // [num_branches] block of each branch's first semester
+    BatchPending *pending;          // [BATCH_BLOCK_ROWS] rows waiting for the next kernel pass
+    int num_pending;
+    char *pending_text;             // [BATCH_PENDING_TEXT]
+    size_t text_used;
+} BatchContext;
+
+static int batch_context_init(BatchContext *bc) {
+    memset(bc, 0, sizeof *bc);
+    /* row buffers sized for the widest semester of the loaded syllabus */
+    bc->max_fields = 4;
+    for (int b = 0; b < num_branches; b++) {
+        for (int s = 0; s < all_branches[b].num_semesters; s++) {
+            if (all_branches[b].semesters[s].num_subjects + 4 > bc->max_fields) bc->max_fields = all_branches[b].semesters[s].num_subjects + 4;
+        }
+    }
+    bc->scratch = arena_alloc(&bc->arena, (size_t)num_branches * sizeof *bc->scratch);
+    bc->fields = arena_alloc(&bc->arena, (size_t)bc->max_fields * sizeof *bc->fields);
+    bc->field_len = arena_alloc(&bc->arena, (size_t)bc->max_fields * sizeof *bc->field_len);
+    bc->marks = arena_alloc(&bc->arena, (size_t)bc->max_fields * sizeof *bc->marks);
+    bc->reject_rows = batch_errors != NULL;
+    bc->to_store = student_store.is_open;
+    int num_blocks = 0;
+    bc->first_block = arena_alloc(&bc->arena, (size_t)num_branches * sizeof *bc->first_block);
+    for (int b = 0; bc->first_block && b < num_branches; b++) {
+        bc->first_block[b] = num_blocks;
+        num_blocks += all_branches[b].num_semesters;
+    }
+    bc->blocks = arena_alloc(&bc->arena, ((size_t)num_blocks + 1) * sizeof *bc->blocks);
+    bc->pending = arena_alloc(&bc->arena, BATCH_BLOCK_ROWS * sizeof *bc->pending);
+    bc->pending_text = arena_alloc(&bc->arena, BATCH_PENDING_TEXT);
+    for (int b = 0; bc->scratch && b < num_branches; b++) {
+        if (!student_attach(&bc->scratch[b], &bc->arena, "", b)) bc->scratch = NULL;
+    }
+    bc->current_branch = -1;
+    bc->first_branch = -1;
+    if (!bc->scratch || !bc->fields || !bc->field_len || !bc->marks || !bc->first_block || !bc->blocks ||
+        !bc->pending || !bc->pending_text) {
+        arena_free(&bc->arena);
+        return 0;
+    }
+    return 1;
+}
+
+/* Batch context of a report mode: rows are graded into scratch records even with --store, so a
+   report never changes or re-logs the stored results */
+static int report_context_init(BatchContext *bc) {
+    if (!batch_context_init(bc)) return 0;
+    bc->to_store = 0;
+    return 1;
+}
+
+static void batch_context_free(BatchContext *bc) {
+    for (int b = 0; b < num_branches; b++) {
+        for (int s = 0; s < all_branches[b].num_semesters; s++) grade_block_free(&bc->blocks[bc->first_block[b] + s]);
+    }
+    arena_free(&bc->arena);
+}
+
+/* Report a rejected row: "line N: reason" on err, or with --errors a "# line N: reason" comment
+   followed by the row itself, so the error file can be corrected and fed back to --batch */
+static void batch_reject(BatchContext *bc, FILE *err, long line_no, const char *row, size_t len, const char *fmt, ...) {
+    va_list ap;
+    bc->rejected++;
+    METRIC_COUNT(METRIC_ROWS_REJECTED, 1);
+    fprintf(err, bc->reject_rows ? "# line %ld: " : "line %ld: ", line_no);
+    va_start(ap, fmt);
+    vfprintf(err, fmt, ap);
+    va_end(ap);
+    fputc('\n', err);
+    if (!bc->reject_rows) return;
+    while (len > 0 && (row[len - 1] == '\n' || row[len - 1] == '\r')) len--;
+    fwrite(row, 1, len, err);
+    fputc('\n', err);
+}
+
+/* Split and check one marks row: fields and marks land in bc. Returns 0 with the reason in why
+   if it cannot be graded; why is empty for a malformed row, which a header line also is. */
+static int batch_parse_row(BatchContext *bc, const char *row, size_t len, int *branch, int *sem_out, int *ap_out, char *why, size_t why_size) {
+    const char **fields = bc->fields;
+    const int *lens = bc->field_len;
+    const char *end = row + len, *limit = bc->limit && bc->limit >= end ? bc->limit : end;
+    int *marks = bc->marks;
+    int nf = split_row(row, end, fields, bc->field_len, bc->max_fields);
+    int sem = 0;
+    why[0] = '\0';
+    if (nf < 3 || !parse_int_span(fields[2], lens[2], limit, &sem)) return 0;
+    int b = find_branch_by_span(fields[1], (size_t)lens[1]);
+    if (b < 0 || sem < 1 || sem > all_branches[b].num_semesters) {
+        snprintf(why, why_size, "unknown branch '%.*s' or semester %d, skipped", lens[1], fields[1], sem);
+        return 0;
+    }
+    int nsub = all_branches[b].semesters[sem - 1].num_subjects;
+    if (nsub == 0 || nf != nsub + 4) {
+        snprintf(why, why_size, "expected %d fields for %.*s S%d, got %d, skipped", nsub + 4, lens[1], fields[1], sem, nf);
+        return 0;
+    }
+    if (lens[0] == 0) {
+        snprintf(why, why_size, "missing student id, skipped");
+        return 0;
+    }
+    if ((size_t)lens[0] >= sizeof bc->scratch[0].reg_no) {
+        snprintf(why, why_size, "student id '%.*s' is longer than %d characters, skipped", lens[0], fields[0], (int)sizeof bc->scratch[0].reg_no - 1);
+        return 0;
+    }
+
+    int ok = 1, ap = -1;
+    for (int i = 0; i < nsub && ok; i++) {
+        ok = parse_int_span(fields[3 + i], lens[3 + i], limit, &marks[i]) && marks[i] >= 0 && marks[i] <= 100;
+    }
+    if (ok) ok = parse_int_span(fields[3 + nsub], lens[3 + nsub], limit, &ap) && ap >= 0 && ap <= 150;
+    if (!ok) {
+        snprintf(why, why_size, "marks must be 0-100 and activity points 0-150, skipped");
+        return 0;
+    }
+    *branch = b;
+    *sem_out = sem;
+    *ap_out = ap;
+    return 1;
+}
+
+/* Follow the student id of a parsed row (fields in bc) of branch b. A new student starts from the
+   branch's scratch record, which the caller clears, or from the stored one (bc->to_store); the id is
+   the only thing copied out of the row, once per student. Returns 1 when the row starts a student,
+   0 when it continues the current one, -1 when the row was rejected. */
+static int batch_switch_student(BatchContext *bc, const char *row, size_t len, long line_no, FILE *err, int b) {
+    const char **fields = bc->fields;
+    const int *lens = bc->field_len;
+    if (b == bc->current_branch && strlen(bc->current_id) == (size_t)lens[0] && memcmp(fields[0], bc->current_id, (size_t)lens[0]) == 0) return 0;
+    char id[sizeof bc->current_id];
+    memcpy(id, fields[0], (size_t)lens[0]);
+    id[lens[0]] = '\0';
+    if (bc->to_store) {
+        bc->student = store_student(&student_store, id, b);
+        if (!bc->student) {
+            bc->current_branch = -1;
+            batch_reject(bc, err, line_no, row, len, "student '%s' cannot be stored under %.*s, skipped", id, lens[1], fields[1]);
+            return -1;
+        }
+    } else {
+        bc->student = &bc->scratch[b];
+    }
+    strcpy(bc->current_id, id);
+    bc->current_branch = b;
+    if (bc->first_branch < 0) {
+        strcpy(bc->first_id, id);
+        bc->first_branch = b;
+    }
+    return 1;
+}
+
+/* Grade one input row, read in place (len bytes, with or without its newline). Returns the
+   graded student and sets *sem_out, or NULL for skipped and rejected rows; diagnostics go to err. */
+static StudentRecord *batch_grade_row(BatchContext *bc, const char *row, size_t len, long line_no, FILE *err, int *sem_out) {
+    if (len == 0 || row[0] == '#' || row[0] == '\n' || row[0] == '\r') return NULL;
+    METRIC_START(t0);
+
+    const int *marks = bc->marks;
+    int b, sem, ap;
+    char why[160];
+    if (!batch_parse_row(bc, row, len, &b, &sem, &ap, why, sizeof why)) {
+        if (why[0]) batch_reject(bc, err, line_no, row, len, "%s", why);
+        else if (line_no > 1) batch_reject(bc, err, line_no, row, len, "malformed row, skipped");   /* line 1: a header */
+        return NULL;
+    }
+    int nsub = all_branches[b].semesters[sem - 1].num_subjects;
+
+    int starts = batch_switch_student(bc, row, len, line_no, err, b);
+    if (starts < 0) return NULL;
+    if (starts && !bc->to_store) student_init(bc->student, bc->current_id, b);
+
+    StudentRecord *student = bc->student;
+    for (int i = 0; i < nsub; i++) set_subject_marks(student, sem - 1, i, marks[i]);
+    student->sems[sem - 1].activity_points = (unsigned char)ap;
+    update_pf_failed(student, sem - 1);
+    grade_semester(student, sem - 1);
+    if (bc->to_store && !store_log_semester(&student_store, student, sem - 1)) {
+        batch_reject(bc, err, line_no, row, len, "could not append to the store");
+    }
+    bc->graded++;
+    *sem_out = sem - 1;
+    METRIC_COUNT(METRIC_ROWS_GRADED, 1);
+    METRIC_STOP(TIMER_INGEST_ROW, t0);
+    return student;
+}
+
+/* Grade every queued row with the bulk kernel, then commit the results to the students and write
+   the result lines in input order */
+static void batch_flush(BatchContext *bc, FILE *out, FILE *err) {
+    if (bc->num_pending == 0) return;
+    for (int b = 0; b < num_branches; b++) {
+        for (int s = 0; s < all_branches[b].num_semesters; s++) {
+            GradeBlock *blk = &bc->blocks[bc->first_block[b] + s];
+            if (blk->num_students > 0) grade_block_run(blk);
+        }
+    }
+    for (int k = 0; k < bc->num_pending; k++) {
+        const BatchPending *r = &bc->pending[k];
+        GradeBlock *blk = &bc->blocks[bc->first_block[r->branch] + r->sem];
+        StudentRecord *st = r->student >= 0 ? &student_store.cohort.students[r->student] : &bc->scratch[r->branch];
+        if (r->starts && r->student < 0) student_init(st, r->id, r->branch);
+        unsigned char *marks = STUDENT_MARKS(st, r->sem);
+        signed char *gp = STUDENT_GP(st, r->sem);
+        for (int i = 0; i < blk->num_subjects; i++) {
+            marks[i] = blk->marks[(size_t)i * blk->stride + r->slot];
+            gp[i] = blk->grade_points[(size_t)i * blk->stride + r->slot];
+        }
+        st->sems[r->sem].activity_points = (unsigned char)r->activity_points;
+        st->sems[r->sem].pf_failed = blk->pf_failed[r->slot];
+        commit_semester_totals(st, r->sem, blk->credit_points[r->slot], blk->gpa_credits);
+        if (bc->to_store && !store_log_semester(&student_store, st, r->sem)) {
+            batch_reject(bc, err, r->line_no, bc->pending_text + r->text, r->len, "could not append to the store");
+        }
+        bc->graded++;
+        METRIC_COUNT(METRIC_ROWS_GRADED, 1);
+
+        char sgpa[GPA_TEXT_MAX], cgpa[GPA_TEXT_MAX];
+        gpa_text(sgpa, SGPA_X100(&st->sems[r->sem]));
+        gpa_text(cgpa, CGPA_X100(st));
+        fprintf(out, "%s,%s,%d,%s,%s,%d,%d,%d\n", r->id, all_branches[r->branch].code, r->sem + 1,
+                sgpa, cgpa, st->sems[r->sem].pf_failed, count_pf_failures(st), sum_activity_points(st));
+    }
+    for (int b = 0; b < num_branches; b++) {
+        for (int s = 0; s < all_branches[b].num_semesters; s++) bc->blocks[bc->first_block[b] + s].num_students = 0;
+    }
+    bc->num_pending = 0;
+    bc->text_used = 0;
+}
+
+/* Queue one input row for bulk grading; its result line is written by the batch_flush() that
+   grades it (when the queue is full, and at the end of the input) */
+static void batch_row(BatchContext *bc, const char *row, size_t len, long line_no, FILE *out, FILE *err) {
+    if (len == 0 || row[0] == '#' || row[0] == '\n' || row[0] == '\r') return;
+    METRIC_START(t0);
+    int b, sem, ap;
+    char why[160];
+    if (!batch_parse_row(bc, row, len, &b, &sem, &ap, why, sizeof why)) {
+        if (why[0]) batch_reject(bc, err, line_no, row, len, "%s", why);
+        else if (line_no > 1) batch_reject(bc, err, line_no, row, len, "malformed row, skipped");   /* line 1: a header */
+        return;
+    }
+    GradeBlock *blk = &bc->blocks[bc->first_block[b] + sem - 1];
+    if (!blk->marks && !grade_block_init(blk, b, sem - 1, BATCH_BLOCK_ROWS)) {
+        batch_reject(bc, err, line_no, row, len, "out of memory, skipped");
+        return;
+    }
+    int starts = batch_switch_student(bc, row, len, line_no, err, b);
+    if (starts < 0) return;
+    if (bc->text_used + len > BATCH_PENDING_TEXT) batch_flush(bc, out, err);
+
+    BatchPending *r = &bc->pending[bc->num_pending++];
+    r->line_no = line_no;
+    r->branch = b;
+    r->sem = sem - 1;
+    r->activity_points = ap;
+    r->slot = blk->num_students++;
+    r->student = bc->to_store ? (int)(bc->student - student_store.cohort.students) : -1;
+    r->starts = starts;
+    r->text = bc->text_used;
+    r->len = len;
+    strcpy(r->id, bc->current_id);
+    memcpy(bc->pending_text + bc->text_used, row, len);
+    bc->text_used += len;
+    for (int i = 0; i < blk->num_subjects; i++) blk->marks[(size_t)i * blk->stride + r->slot] = (unsigned char)bc->marks[i];
+    METRIC_STOP(TIMER_INGEST_ROW, t0);
+    if (bc->num_pending == BATCH_BLOCK_ROWS) batch_flush(bc, out, err);
+}
+
+/* Rows of a marks file: a named file is mapped and its rows are graded where they lie;
+   stdin ("-") is read with fgets() into one line buffer */
+typedef struct {
+    const char *data;               // mapped input, NULL when reading stdin
+    size_t size;
+    size_t pos;
+    int mapped;
+    FILE *file;                     // stdin
+    char *line;                     // [BATCH_LINE_MAX] for stdin
+} BatchInput;
+
+static int batch_input_open(BatchInput *bi, const char *path) {
+    memset(bi, 0, sizeof bi[0]);
+    if (strcmp(path, "-") == 0) {
+        static char line[BATCH_LINE_MAX];
+        bi->file = stdin;
+        bi->line = line;
+        return 1;
+    }
+    bi->data = map_file(path, &bi->size, &bi->mapped);
+    if (!bi->data) { perror(path); return 0; }
+    return 1;
+}
+
+static void batch_input_close(BatchInput *bi) {
+    if (bi->data) unmap_file(bi->data, bi->size, bi->mapped);
+    bi->data = NULL;
+}
+
+/* Rows longer than an fgets() into a BATCH_LINE_MAX buffer are refused on every path */
+static int batch_row_too_long(const char *row, size_t n) {
+    return n > BATCH_LINE_MAX - 1 || (n == BATCH_LINE_MAX - 1 && row[n - 1] != '\n');
+}
+
+/* Next row; 1 = row read into row and len, -1 = overlong row skipped, 0 = end of input */
+static int batch_input_next(BatchInput *bi, const char **row, size_t *len, long line_no, BatchContext *bc, FILE *err) {
+    if (bi->file) {
+        if (!fgets(bi->line, BATCH_LINE_MAX, bi->file)) return 0;
+        size_t n = strlen(bi->line);
+        if (n == BATCH_LINE_MAX - 1 && bi->line[n - 1] != '\n') {
+            int c;
+            while ((c = fgetc(bi->file)) != EOF && c != '\n');
+            batch_reject(bc, err, line_no, bi->line, n, "row too long, skipped");
+            return -1;
+        }
+        *row = bi->line;
+        *len = n;
+        bc->limit = bi->line + BATCH_LINE_MAX;
+        return 1;
+    }
+    if (bi->pos >= bi->size) return 0;
+    const char *p = bi->data + bi->pos;
+    const char *nl = memchr(p, '\n', bi->size - bi->pos);
+    size_t n = nl ? (size_t)(nl - p) + 1 : bi->size - bi->pos;
+    bi->pos += n;
+    bc->limit = bi->data + bi->size;
+    if (batch_row_too_long(p, n)) {
+        batch_reject(bc, err, line_no, p, n, "row too long, skipped");
+        return -1;
+    }
+    *row = p;
+    *len = n;
+    return 1;
+}
+
+int run_batch(const char *in_path, const char *out_path, int threads) {
+#ifdef HAVE_THREADS
+    if (threads > 1 && !student_store.is_open && strcmp(in_path, "-") != 0) return run_batch_parallel(in_path, out_path, threads);
+#else
+    (void)threads;
+#endif
+    BatchInput in;
+    if (!batch_input_open(&in, in_path)) return 1;
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); batch_input_close(&in); return 1; }
+
+    BatchContext bc;
+    if (!batch_context_init(&bc)) {
+        fprintf(stderr, "Out of memory.\n");
+        batch_input_close(&in);
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+    long line_no = 0;
+    const char *row;
+    size_t len;
+    int got;
+
+    fprintf(out, "%s\n", BATCH_OUTPUT_HEADER);
+
+    while ((got = batch_input_next(&in, &row, &len, ++line_no, &bc, batch_err())) != 0) {
+        if (got > 0) batch_row(&bc, row, len, line_no, out, batch_err());
+    }
+    batch_flush(&bc, out, batch_err());
+
+    if (student_store.is_open && !store_sync(&student_store)) bc.rejected++;
+    fprintf(stderr, "Batch complete: %ld row(s) graded, %ld rejected.\n", bc.graded, bc.rejected);
+    batch_context_free(&bc);
+    batch_input_close(&in);
+    if (out != stdout) fclose(out);
+    return bc.rejected > 0 ? 2 : 0;
+}
+
+#ifdef HAVE_THREADS
+/* ===========================
+   Parallel batch grading (--threads N).
+   The mapped input is cut into chunks at lines where the student id changes, so every chunk
+   starts a fresh student exactly as the sequential loop would. Each worker owns a deque of
+   chunks, pops from its own bottom and steals from the top of others when it runs dry, so a
+   run of large CS sections does not leave the CE worker idle. Results and diagnostics of each
+   chunk go to its own memory stream and are written out in chunk order, which makes the output
+   byte-identical to the single-threaded path. A cut can only be wrong when a rejected row with
+   another id sits among one student's rows; such a chunk opens with the student the previous
+   rows left off on, and is regraded on the main thread from where that student began.
+   =========================== */
+#define BATCH_CHUNK_BYTES (256u << 10)      /* target chunk size; a student is never split */
+
+typedef struct {
+    const char *begin;
+    const char *end;
+    long first_line;
+    char *out;                      // open_memstream buffers, filled by the worker
+    size_t out_len;
+    char *err;
+    size_t err_len;
+    long graded;
+    long rejected;
+    int failed;
+    char first_id[32];              // first and last student graded in the chunk (branch -1: none)
+    int first_branch;
+    char last_id[32];
+    int last_branch;
+    int run_start;                  // first chunk of the sequential run this chunk was graded in
+} BatchChunk;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int *tasks;                     // chunk indices; owner pops at bottom, thieves take from top
+    int top;
+    int bottom;
+} WorkDeque;
+
+typedef struct {
+    BatchChunk *chunks;
+    WorkDeque *deques;
+    int num_workers;
+} BatchPool;
+
+typedef struct {
+    BatchPool *pool;
+    int id;
+} BatchWorker;
+
+static int deque_pop(WorkDeque *q) {
+    int t = -1;
+    pthread_mutex_lock(&q->lock);
+    if (q->bottom > q->top) t = q->tasks[--q->bottom];
+    pthread_mutex_unlock(&q->lock);
+    return t;
+}
+
+static int deque_steal(WorkDeque *q) {
+    int t = -1;
+    pthread_mutex_lock(&q->lock);
+    if (q->bottom > q->top) t = q->tasks[q->top++];
+    pthread_mutex_unlock(&q->lock);
+    return t;
+}
+
+/* Start of the trimmed first field of a line, and its length */
+static const char *row_key(const char *p, const char *end, size_t *len) {
+    while (p < end && *p == ' ') p++;
+    const char *k = p;
+    while (p < end && *p != ',' && *p != '\t' && *p != '\n' && *p != '\r') p++;
+    while (p > k && p[-1] == ' ') p--;
+    *len = (size_t)(p - k);
+    return k;
+}
+
+static void grade_chunk(BatchContext *bc, BatchChunk *ch) {
+    FILE *out = open_memstream(&ch->out, &ch->out_len);
+    FILE *err = open_memstream(&ch->err, &ch->err_len);
+    if (!out || !err) {
+        if (out) fclose(out);
+        if (err) fclose(err);
+        ch->failed = 1;
+        return;
+    }
+    bc->student = NULL;
+    bc->current_id[0] = '\0';
+    bc->current_branch = -1;
+    bc->first_branch = -1;
+    bc->graded = bc->rejected = 0;
+    bc->limit = ch->end;
+
+    long line_no = ch->first_line;
+    for (const char *p = ch->begin; p < ch->end; line_no++) {
+        const char *nl = memchr(p, '\n', (size_t)(ch->end - p));
+        size_t n = nl ? (size_t)(nl - p) + 1 : (size_t)(ch->end - p);
+        if (batch_row_too_long(p, n)) batch_reject(bc, err, line_no, p, n, "row too long, skipped");
+        else batch_row(bc, p, n, line_no, out, err);
+        p += n;
+    }
+    batch_flush(bc, out, err);
+    ch->graded = bc->graded;
+    ch->rejected = bc->rejected;
+    strcpy(ch->first_id, bc->first_id);
+    ch->first_branch = bc->first_branch;
+    strcpy(ch->last_id, bc->current_id);
+    ch->last_branch = bc->current_branch;
+    if (fclose(out) != 0 || fclose(err) != 0) ch->failed = 1;
+}
+
+static void *batch_worker(void *arg) {
+    BatchWorker *w = arg;
+    BatchPool *pool = w->pool;
+    BatchContext bc;
+    if (!batch_context_init(&bc)) return (void *)1;
+    while (1) {
+        int t = deque_pop(&pool->deques[w->id]);
+        for (int k = 1; t < 0 && k < pool->num_workers; k++) {
+            t = deque_steal(&pool->deques[(w->id + k) % pool->num_workers]);
+        }
+        if (t < 0) break;           /* every deque is empty and no new work appears */
+        grade_chunk(&bc, &pool->chunks[t]);
+    }
+    batch_context_free(&bc);
+    return NULL;
+}
+
+/* Cut the input into chunks of about BATCH_CHUNK_BYTES, only before a row whose student id
+   differs from the previous row's (comment and blank lines never start a chunk) */
+static int split_batch_input(const char *data, size_t size, BatchChunk **chunks_out) {
+    int count = 0, cap = 64;
+    BatchChunk *chunks = malloc((size_t)cap * sizeof *chunks);
+    if (!chunks) return -1;
+    const char *end = data + size, *p = data, *chunk_start = data;
+    const char *prev_key = NULL;
+    size_t prev_len = 0;
+    long line_no = 1, chunk_line = 1;
+
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *next = nl ? nl + 1 : end;
+        if (*p != '#' && *p != '\n' && *p != '\r') {
+            size_t len;
+            const char *key = row_key(p, next, &len);
+            int new_student = prev_key && (len != prev_len || memcmp(key, prev_key, len) != 0);
+            if (new_student && (size_t)(p - chunk_start) >= BATCH_CHUNK_BYTES) {
+                if (count == cap) {
+                    BatchChunk *grown = realloc(chunks, (size_t)cap * 2 * sizeof *chunks);
+                    if (!grown) { free(chunks); return -1; }
+                    chunks = grown;
+                    cap *= 2;
+                }
+                memset(&chunks[count], 0, sizeof chunks[count]);
+                chunks[count].begin = chunk_start;
+                chunks[count].end = p;
+                chunks[count].first_line = chunk_line;
+                count++;
+                chunk_start = p;
+                chunk_line = line_no;
+            }
+            prev_key = key;
+            prev_len = len;
+        }
+        p = next;
+        line_no++;
+    }
+    if (count == cap) {
+        BatchChunk *grown = realloc(chunks, (size_t)(cap + 1) * sizeof *chunks);
+        if (!grown) { free(chunks); return -1; }
+        chunks = grown;
+    }
+    memset(&chunks[count], 0, sizeof chunks[count]);
+    chunks[count].begin = chunk_start;
+    chunks[count].end = end;
+    chunks[count].first_line = chunk_line;
+    *chunks_out = chunks;
+    return count + 1;
+}
+
+int run_batch_parallel(const char *in_path, const char *out_path, int threads) {
+    size_t size = 0;
+    int mapped = 0;
+    const char *data = map_file(in_path, &size, &mapped);
+    if (!data) { perror(in_path); return 1; }
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); unmap_file(data, size, mapped); return 1; }
+
+    BatchChunk *chunks = NULL;
+    int num_chunks = split_batch_input(data, size, &chunks);
+    if (num_chunks < 1) {
+        fprintf(stderr, "Out of memory.\n");
+        unmap_file(data, size, mapped);
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+    if (threads > num_chunks) threads = num_chunks;
+    BatchPool pool = { chunks, calloc((size_t)threads, sizeof(WorkDeque)), threads };
+    BatchWorker *workers = calloc((size_t)threads, sizeof *workers);
+    pthread_t *tids = calloc((size_t)threads, sizeof *tids);
+    int *tasks = malloc((size_t)num_chunks * sizeof *tasks);
+    if (!pool.deques || !workers || !tids || !tasks) {
+        fprintf(stderr, "Out of memory.\n");
+        free(chunks); free(pool.deques); free(workers); free(tids); free(tasks);
+        unmap_file(data, size, mapped);
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+
+    /* each worker starts with a contiguous run of chunks, popped front to back */
+    for (int w = 0; w < threads; w++) {
+        int lo = (int)((long)num_chunks * w / threads), hi = (int)((long)num_chunks * (w + 1) / threads);
+        for (int i = lo; i < hi; i++) tasks[i] = hi - 1 - (i - lo);
+        pthread_mutex_init(&pool.deques[w].lock, NULL);
+        pool.deques[w].tasks = tasks + lo;
+        pool.deques[w].top = 0;
+        pool.deques[w].bottom = hi - lo;
+    }
+    int started = 0, failed = 0;
+    for (int w = 0; w < threads; w++) {
+        workers[w].pool = &pool;
+        workers[w].id = w;
+        if (pthread_create(&tids[w], NULL, batch_worker, &workers[w]) != 0) break;
+        started++;
+    }
+    if (started == 0) batch_worker(&workers[0]);   /* no threads available: drain everything here */
+    for (int w = 0; w < started; w++) {
+        void *rc = NULL;
+        pthread_join(tids[w], &rc);
+        if (rc) failed = 1;
+    }
+
+    BatchContext bc;
+    int have_bc = 0, last = -1;     /* last: chunk holding the student rows left off on */
+    for (int i = 0; i < num_chunks && !failed; i++) {
+        BatchChunk *ch = &chunks[i];
+        ch->run_start = i;
+        if (last >= 0 && ch->first_branch >= 0 && ch->first_branch == chunks[last].last_branch &&
+            strcmp(ch->first_id, chunks[last].last_id) == 0) {
+            if (!have_bc && !(have_bc = batch_context_init(&bc))) { failed = 1; break; }
+            int s = chunks[last].run_start;
+            BatchChunk run;
+            memset(&run, 0, sizeof run);
+            run.begin = chunks[s].begin;
+            run.end = ch->end;
+            run.first_line = chunks[s].first_line;
+            grade_chunk(&bc, &run);
+            for (int k = s; k <= i; k++) {
+                free(chunks[k].out);
+                free(chunks[k].err);
+                chunks[k].out = chunks[k].err = NULL;
+                chunks[k].out_len = chunks[k].err_len = 0;
+                chunks[k].graded = chunks[k].rejected = 0;
+                chunks[k].run_start = s;
+            }
+            chunks[s].out = run.out;
+            chunks[s].out_len = run.out_len;
+            chunks[s].err = run.err;
+            chunks[s].err_len = run.err_len;
+            chunks[s].graded = run.graded;
+            chunks[s].rejected = run.rejected;
+            if (run.failed || !run.out) failed = 1;
+            strcpy(ch->last_id, run.last_id);
+            ch->last_branch = run.last_branch;
+        }
+        if (ch->last_branch >= 0) last = i;
+    }
+    if (have_bc) batch_context_free(&bc);
+
+    long graded = 0, rejected = 0;
+    fprintf(out, "%s\n", BATCH_OUTPUT_HEADER);
+    for (int i = 0; i < num_chunks; i++) {
+        BatchChunk *ch = &chunks[i];
+        if (ch->failed || (!ch->out && ch->run_start == i)) failed = 1;
+        if (ch->out) fwrite(ch->out, 1, ch->out_len, out);
+        if (ch->err) fwrite(ch->err, 1, ch->err_len, batch_err());
+        graded += ch->graded;
+        rejected += ch->rejected;
+        free(ch->out);
+        free(ch->err);
+    }
+    if (failed) fprintf(stderr, "Out of memory.\n");
+    else fprintf(stderr, "Batch complete: %ld row(s) graded, %ld rejected.\n", graded, rejected);
+
+    for (int w = 0; w < threads; w++) pthread_mutex_destroy(&pool.deques[w].lock);
+    free(chunks); free(pool.deques); free(workers); free(tids); free(tasks);
+    unmap_file(data, size, mapped);
+    if (out != stdout) fclose(out);
+    return failed ? 1 : rejected > 0 ? 2 : 0;
+}
+#endif
+
+/* ===========================
+   Bulk reports (--reports FILE): the semester report of every row of a marks file (same
+   format as --batch), rendered exactly like the console report. Output is one stream
+   (-o OUT, default stdout), or with --report-dir DIR one DIR/<student_id>.txt per student
+   holding all of that student's reports, in input order even when the student's rows are not
+   kept together. An id whose file name another id already took is reported and skipped.
+   =========================== */
+
+/* A student id as a file name: anything but letters, digits, '-' and '_' becomes '_' */
+static void safe_file_name(const char *id, char *name, size_t size) {
+    size_t n = 0;
+    for (; id[n] && n < size - 1; n++) {
+        char c = id[n];
+        int safe = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '-' || c == '_';
+        name[n] = safe ? c : '_';
+    }
+    name[n] = '\0';
+}
+
+/* File names handed out in one run (--report-dir, --transcripts), so that ids which sanitize to
+   the same name are caught instead of overwriting each other's files */
+typedef struct {
+    char name[64];
+    char id[32];
+    int used;
+} FileNameSlot;
+
+typedef struct {
+    FileNameSlot *slots;
+    size_t num_slots;               // power of two, at most half full
+    size_t count;
+} FileNames;
+
+/* Claim a file name for id: 1 = first use, 0 = already claimed by the same id, -1 = claimed by
+   another id (*owner set to it), -2 = out of memory */
+static int file_names_claim(FileNames *fn, const char *name, const char *id, const char **owner) {
+    if (2 * (fn->count + 1) > fn->num_slots) {
+        size_t n = fn->num_slots ? fn->num_slots * 2 : 1024;
+        FileNameSlot *slots = calloc(n, sizeof *slots);
+        if (!slots) return -2;
+        for (size_t i = 0; i < fn->num_slots; i++) {
+            if (!fn->slots[i].used) continue;
+            size_t j = hash_string(fn->slots[i].name) & (n - 1);
+            while (slots[j].used) j = (j + 1) & (n - 1);
+            slots[j] = fn->slots[i];
+        }
+        free(fn->slots);
+        fn->slots = slots;
+        fn->num_slots = n;
+    }
+    size_t j = hash_string(name) & (fn->num_slots - 1);
+    for (; fn->slots[j].used; j = (j + 1) & (fn->num_slots - 1)) {
+        if (strcmp(fn->slots[j].name, name) != 0) continue;
+        if (strcmp(fn->slots[j].id, id) == 0) return 0;
+        *owner = fn->slots[j].id;
+        return -1;
+    }
+    snprintf(fn->slots[j].name, sizeof fn->slots[j].name, "%s", name);
+    snprintf(fn->slots[j].id, sizeof fn->slots[j].id, "%s", id);
+    fn->slots[j].used = 1;
+    fn->count++;
+    return 1;
+}
+
+static void file_names_free(FileNames *fn) {
+    free(fn->slots);
+    memset(fn, 0, sizeof *fn);
+}
+
+/* Write the buffered reports of one student to DIR/<name>.txt, appending to the file when the
+   student's earlier rows already went there */
+static int write_student_reports(OutBuf *ob, const char *dir, const char *name, int append) {
+    char path[1024];
+    snprintf(path, sizeof path, "%s/%s.txt", dir, name);
+    ob->file = fopen(path, append ? "ab" : "wb");
+    if (!ob->file) { perror(path); ob->len = 0; return 0; }
+    int ok = ob_flush(ob);
+    if (fclose(ob->file) != 0) ok = 0;
+    ob->file = NULL;
+    if (!ok) fprintf(stderr, "%s: write failed\n", path);
+    return ok;
+}
+
+int run_reports(const char *in_path, const char *out_path, const char *dir) {
+    BatchInput in;
+    if (!batch_input_open(&in, in_path)) return 1;
+    FILE *out = dir ? NULL : out_path ? fopen(out_path, "wb") : stdout;
+    if (!dir && !out) { perror(out_path); batch_input_close(&in); return 1; }
+#ifdef HAVE_POSIX
+    if (dir) mkdir(dir, 0755);
+#endif
+
+    BatchContext bc;
+    OutBuf ob;
+    memset(&ob, 0, sizeof ob);
+    ob.file = out;
+    if (!report_context_init(&bc) || !ob_reserve(&ob, OUTBUF_FLUSH_AT + (OUTBUF_FLUSH_AT >> 2))) {
+        fprintf(stderr, "Out of memory.\n");
+        free(ob.data);
+        batch_input_close(&in);
+        if (out && out != stdout) fclose(out);
+        return 1;
+    }
+    /* --report-dir: the student whose reports are in ob, and its file (name, appended or not) */
+    FileNames names;
+    memset(&names, 0, sizeof names);
+    char owner[32] = "", name[64] = "", holder[32] = "";
+    int owner_state = 0;            /* claim result for owner: 1 new file, 0 append, -1 skipped */
+    long line_no = 0, files = 0, reports = 0;
+    const char *row;
+    size_t len;
+    int got, ok = 1;
+
+    while ((got = batch_input_next(&in, &row, &len, ++line_no, &bc, batch_err())) != 0) {
+        int sem;
+        StudentRecord *st = got > 0 ? batch_grade_row(&bc, row, len, line_no, batch_err(), &sem) : NULL;
+        if (!st) continue;
+        if (dir && (owner[0] == '\0' || strcmp(owner, bc.current_id) != 0)) {
+            if (owner[0] && owner_state >= 0) ok &= write_student_reports(&ob, dir, name, owner_state == 0);
+            const char *taken_by = NULL;
+            strcpy(owner, bc.current_id);
+            safe_file_name(owner, name, sizeof name);
+            owner_state = file_names_claim(&names, name, owner, &taken_by);
+            if (owner_state == -2) { fprintf(stderr, "Out of memory.\n"); ok = 0; break; }
+            if (taken_by) strcpy(holder, taken_by);
+            files += owner_state == 1;
+        }
+        if (dir && owner_state < 0) {
+            batch_reject(&bc, batch_err(), line_no, row, len, "report file %s/%s.txt already holds student '%s', skipped",
+                         dir, name, holder);
+            continue;
+        }
+        render_report(&ob, st, sem);
+        reports++;
+        if (!dir && ob.len >= OUTBUF_FLUSH_AT) ok &= ob_flush(&ob);
+    }
+    if (dir && owner[0] && owner_state >= 0) ok &= write_student_reports(&ob, dir, name, owner_state == 0);
+    if (!dir) ok &= ob_flush(&ob);
+    if (ob.failed) ok = 0;
+
+    if (dir) fprintf(stderr, "Reports complete: %ld report(s) in %ld file(s), %ld row(s) rejected.\n", reports, files, bc.rejected);
+    else fprintf(stderr, "Reports complete: %ld report(s), %ld row(s) rejected.\n", reports, bc.rejected);
+    file_names_free(&names);
+    free(ob.data);
+    batch_context_free(&bc);
+    batch_input_close(&in);
+    if (out && out != stdout && fclose(out) != 0) ok = 0;
+    if (!ok) return 1;
+    return bc.rejected > 0 ? 2 : 0;
+}
+
+/* ===========================
+   Cohort analytics (--analytics FILE): one streaming pass over a marks file (same format as
+   --batch) that grades every row and accumulates
+     - per-subject grade distributions (grade point counts, P/F pass/fail),
+     - SGPA mean/stddev per branch and semester (Welford),
+     - the top K students per branch by final CGPA (bounded min-heap),
+     - CGPA percentiles: exact by quickselect while the cohort fits ANALYTICS_EXACT_MAX, then
+       from a 1001-bin histogram of CGPA to 0.01 (the precision reports print anyway).
+   =========================== */
+#define ANALYTICS_TOP_K 10
+#define ANALYTICS_EXACT_MAX 4000000         /* CGPA values kept for exact percentiles */
+#define ANALYTICS_BINS 1001                 /* CGPA 0.00-10.00 in steps of 0.01 */
+#define GRADE_SLOTS 13                      /* grade point 0-10, P/F pass, P/F fail */
+
+typedef struct {
+    long n;
+    double mean;
+    double m2;
+} RunningStats;
+
+typedef struct {
+    int cgpa_x100;                  // as printed, so equal CGPAs tie and fall back to the register number
+    char reg_no[32];
+} RankEntry;
+
+typedef struct {
+    RunningStats cgpa;
+    RunningStats *sgpa;             // [num_semesters]
+    RankEntry *top;                 // min-heap of the best top_k, worst at top[0]
+    int top_count;
+    float *values;                  // final CGPAs while exact, NULL once switched to the histogram
+    long num_values;
+    long cap_values;
+    long *histogram;                // [ANALYTICS_BINS]
+    long *grade_counts;             // [num_subjects * GRADE_SLOTS]
+} BranchAnalytics;
+
+static void stats_add(RunningStats *rs, double x) {
+    double d = x - rs->mean;
+    rs->n++;
+    rs->mean += d / (double)rs->n;
+    rs->m2 += d * (x - rs->mean);
+}
+
+/* Fold in n more values with the given mean and sum of squared deviations (Chan et al.) */
+static void stats_merge(RunningStats *rs, long n, double mean, double m2) {
+    if (n == 0) return;
+    long total = rs->n + n;
+    double d = mean - rs->mean;
+    rs->mean += d * (double)n / (double)total;
+    rs->m2 += m2 + d * d * (double)rs->n * (double)n / (double)total;
+    rs->n = total;
+}
+
+static double stats_stddev(const RunningStats *rs) {
+    if (rs->n < 2) return 0.0;
+    double v = rs->m2 / (double)(rs->n - 1), r = v > 1.0 ? v : 1.0;
+    if (v <= 0.0) return 0.0;
+    for (int k = 0; k < 60; k++) r = 0.5 * (r + v / r);     /* Newton's method; no libm needed */
+    return r;
+}
+
+/* a ranks below b: lower CGPA, or equal CGPA and later register number */
+static int rank_below(const RankEntry *a, const RankEntry *b) {
+    if (a->cgpa_x100 != b->cgpa_x100) return a->cgpa_x100 < b->cgpa_x100;
+    return strcmp(a->reg_no, b->reg_no) > 0;
+}
+
+static void heap_sift_down(RankEntry *h, int n, int i) {
+    while (1) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < n && rank_below(&h[l], &h[m])) m = l;
+        if (r < n && rank_below(&h[r], &h[m])) m = r;
+        if (m == i) return;
+        RankEntry t = h[i]; h[i] = h[m]; h[m] = t;
+        i = m;
+    }
+}
+
+static void topk_offer(BranchAnalytics *ba, int k, const RankEntry *e) {
+    if (ba->top_count < k) {
+        int i = ba->top_count++;
+        ba->top[i] = *e;
+        while (i > 0 && rank_below(&ba->top[i], &ba->top[(i - 1) / 2])) {
+            RankEntry t = ba->top[i]; ba->top[i] = ba->top[(i - 1) / 2]; ba->top[(i - 1) / 2] = t;
+            i = (i - 1) / 2;
+        }
+    } else if (k > 0 && rank_below(&ba->top[0], e)) {
+        ba->top[0] = *e;
+        heap_sift_down(ba->top, k, 0);
+    }
+}
+
+/* Partial selection: afterwards v[k] holds the k-th smallest and everything before it is <= it */
+static void select_nth(float *v, long lo, long hi, long k) {
+    while (hi > lo) {
+        long mid = lo + (hi - lo) / 2;
+        float a = v[lo], b = v[mid], c = v[hi];
+        float pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+        long i = lo, j = hi;
+        while (i <= j) {
+            while (v[i] < pivot) i++;
+            while (v[j] > pivot) j--;
+            if (i <= j) { float t = v[i]; v[i] = v[j]; v[j] = t; i++; j--; }
+        }
+        if (k <= j) hi = j;
+        else if (k >= i) lo = i;
+        else return;
+    }
+}
+
+static const int analytics_percentiles[] = { 10, 25, 50, 75, 90, 99 };
+#define NUM_PERCENTILES ((int)(sizeof analytics_percentiles / sizeof analytics_percentiles[0]))
+
+/* Nearest-rank percentiles of the branch's final CGPAs (exact or from the histogram) */
+static void branch_percentiles(BranchAnalytics *ba, double *out) {
+    long n = ba->cgpa.n, from = 0;
+    for (int p = 0; p < NUM_PERCENTILES; p++) {
+        long rank = (analytics_percentiles[p] * n + 99) / 100;   /* 1-based */
+        if (rank < 1) rank = 1;
+        if (ba->values) {
+            select_nth(ba->values, from, n - 1, rank - 1);   /* percentiles ascend, so earlier picks stay valid */
+            out[p] = ba->values[rank - 1];
+            from = rank - 1;
+        } else {
+            long seen = 0;
+            int bin = 0;
+            while (bin < ANALYTICS_BINS - 1 && seen + ba->histogram[bin] < rank) seen += ba->histogram[bin++];
+            out[p] = bin / 100.0;
+        }
+    }
+}
+
+typedef struct {
+    BranchAnalytics *branches;      // [num_branches]
+    int top_k;
+    long students;
+    long total_values;
+    int exact;
+} Analytics;
+
+static int analytics_init(Analytics *an, int top_k) {
+    memset(an, 0, sizeof *an);
+    an->top_k = top_k;
+    an->exact = 1;
+    an->branches = calloc((size_t)num_branches, sizeof *an->branches);
+    if (!an->branches) return 0;
+    for (int b = 0; b < num_branches; b++) {
+        BranchAnalytics *ba = &an->branches[b];
+        ba->sgpa = calloc((size_t)all_branches[b].num_semesters, sizeof *ba->sgpa);
+        ba->top = calloc((size_t)(top_k > 0 ? top_k : 1), sizeof *ba->top);
+        ba->histogram = calloc(ANALYTICS_BINS, sizeof *ba->histogram);
+        ba->grade_counts = calloc((size_t)all_branches[b].num_subjects * GRADE_SLOTS + 1, sizeof *ba->grade_counts);
+        if (!ba->sgpa || !ba->top || !ba->histogram || !ba->grade_counts) return 0;
+    }
+    return 1;
+}
+
+static void analytics_free(Analytics *an) {
+    for (int b = 0; an->branches && b < num_branches; b++) {
+        BranchAnalytics *ba = &an->branches[b];
+        free(ba->sgpa);
+        free(ba->top);
+        free(ba->values);
+        free(ba->histogram);
+        free(ba->grade_counts);
+    }
+    free(an->branches);
+    an->branches = NULL;
+}
+
+/* Fold one graded semester row into the distributions and SGPA statistics */
+static void analytics_add_row(Analytics *an, const StudentRecord *st, int sem_index) {
+    BranchAnalytics *ba = &an->branches[st->branch];
+    const Semester *syl = &all_branches[st->branch].semesters[sem_index];
+    const signed char *gp = STUDENT_GP(st, sem_index);
+    long *counts = ba->grade_counts + (size_t)syl->first_subject * GRADE_SLOTS;
+    for (int i = 0; i < syl->num_subjects; i++) {
+        int slot = gp[i] == GP_PF_PASS ? 11 : gp[i] == GP_PF_FAIL ? 12 : gp[i];
+        counts[(size_t)i * GRADE_SLOTS + slot]++;
+    }
+    stats_add(&ba->sgpa[sem_index], st->sems[sem_index].sgpa);
+}
+
+/* A student's rows are complete: rank their final CGPA */
+static void analytics_add_student(Analytics *an, int branch, const char *reg_no, double cgpa, int cgpa_x100) {
+    BranchAnalytics *ba = &an->branches[branch];
+    RankEntry e;
+    e.cgpa_x100 = cgpa_x100;
+    snprintf(e.reg_no, sizeof e.reg_no, "%s", reg_no);
+    an->students++;
+    stats_add(&ba->cgpa, cgpa);
+    topk_offer(ba, an->top_k, &e);
+    int bin = cgpa_x100;
+    ba->histogram[bin < 0 ? 0 : bin >= ANALYTICS_BINS ? ANALYTICS_BINS - 1 : bin]++;
+
+    if (!an->exact) return;
+    if (an->total_values == ANALYTICS_EXACT_MAX) {
+        for (int b = 0; b < num_branches; b++) { free(an->branches[b].values); an->branches[b].values = NULL; }
+        an->exact = 0;
+        return;
+    }
+    if (ba->num_values == ba->cap_values) {
+        long cap = ba->cap_values ? ba->cap_values * 2 : 1024;
+        float *grown = realloc(ba->values, (size_t)cap * sizeof *grown);
+        if (!grown) {
+            for (int b = 0; b < num_branches; b++) { free(an->branches[b].values); an->branches[b].values = NULL; }
+            an->exact = 0;
+            return;
+        }
+        ba->values = grown;
+        ba->cap_values = cap;
+    }
+    ba->values[ba->num_values++] = (float)cgpa_x100 / 100.0f;     /* percentiles of the printed CGPAs */
+    an->total_values++;
+}
+
+static void analytics_print(Analytics *an, FILE *out, long rows, long rejected) {
+    fprintf(out, "============================================================\n");
+    fprintf(out, "   COHORT ANALYTICS\n");
+    fprintf(out, "============================================================\n");
+    fprintf(out, "Students: %ld   Rows graded: %ld   Rows rejected: %ld\n", an->students, rows, rejected);
+    fprintf(out, "CGPA percentiles: %s\n", an->exact ? "exact" : "from 0.01 histogram");
+
+    for (int b = 0; b < num_branches; b++) {
+        BranchAnalytics *ba = &an->branches[b];
+        const Branch *br = &all_branches[b];
+        if (ba->cgpa.n == 0) continue;
+        double pct[NUM_PERCENTILES];
+        branch_percentiles(ba, pct);
+
+        fprintf(out, "\n--- %s (%s): %ld student(s) ---\n", br->name, br->code, ba->cgpa.n);
+        fprintf(out, "CGPA mean %.2f  stddev %.2f\n", ba->cgpa.mean, stats_stddev(&ba->cgpa));
+        fprintf(out, "CGPA percentiles:");
+        for (int p = 0; p < NUM_PERCENTILES; p++) fprintf(out, "  P%d %.2f", analytics_percentiles[p], pct[p]);
+        fprintf(out, "\n");
+
+        /* the heap holds the best K in heap order; pop it into rank order */
+        int n = ba->top_count;
+        RankEntry *ranked = malloc((size_t)(n ? n : 1) * sizeof *ranked);
+        if (ranked) {
+            for (int k = n - 1; k >= 0; k--) {
+                ranked[k] = ba->top[0];
+                ba->top[0] = ba->top[k];
+                heap_sift_down(ba->top, k, 0);
+            }
+            fprintf(out, "Top %d by CGPA:\n", n);
+            for (int k = 0; k < n; k++) {
+                char cgpa[GPA_TEXT_MAX];
+                gpa_text(cgpa, ranked[k].cgpa_x100);
+                fprintf(out, "  %2d. %-16s %s\n", k + 1, ranked[k].reg_no, cgpa);
+            }
+            free(ranked);
+        }
+        ba->top_count = 0;
+
+        fprintf(out, "SGPA by semester:\n");
+        for (int s = 0; s < br->num_semesters; s++) {
+            if (ba->sgpa[s].n == 0) continue;
+            fprintf(out, "  S%-2d n=%-8ld mean %.2f  stddev %.2f\n", br->semesters[s].sem_number,
+                    ba->sgpa[s].n, ba->sgpa[s].mean, stats_stddev(&ba->sgpa[s]));
+        }
+
+        fprintf(out, "Grade distribution (grade point:count, P/F pass/fail):\n");
+        for (int s = 0; s < br->num_semesters; s++) {
+            const Semester *syl = &br->semesters[s];
+            if (ba->sgpa[s].n == 0) continue;
+            for (int i = 0; i < syl->num_subjects; i++) {
+                const long *c = ba->grade_counts + (size_t)(syl->first_subject + i) * GRADE_SLOTS;
+                fprintf(out, "  S%-2d %-28.28s |", syl->sem_number, syl->subjects[i].name);
+                if (syl->subjects[i].is_passfail) {
+                    fprintf(out, " pass:%ld fail:%ld\n", c[11], c[12]);
+                    continue;
+                }
+                for (int g = 10; g >= 0; g--) if (c[g]) fprintf(out, " %d:%ld", g, c[g]);
+                fprintf(out, "\n");
+            }
+        }
+    }
+}
+
+int run_analytics(const char *in_path, const char *out_path, int top_k) {
+    BatchInput in;
+    if (!batch_input_open(&in, in_path)) return 1;
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); batch_input_close(&in); return 1; }
+
+    BatchContext bc;
+    Analytics an;
+    memset(&an, 0, sizeof an);
+    int ctx_ok = report_context_init(&bc);
+    if (!ctx_ok || !analytics_init(&an, top_k)) {
+        fprintf(stderr, "Out of memory.\n");
+        if (ctx_ok) batch_context_free(&bc);
+        analytics_free(&an);
+        batch_input_close(&in);
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+    /* the student whose rows are being read, ranked once the next student starts */
+    char last_id[32] = "";
+    int last_branch = -1;
+    double last_cgpa = 0.0;
+    int last_cgpa_x100 = 0;
+    long line_no = 0;
+    const char *row;
+    size_t len;
+    int got;
+
+    while ((got = batch_input_next(&in, &row, &len, ++line_no, &bc, batch_err())) != 0) {
+        int sem;
+        StudentRecord *st = got > 0 ? batch_grade_row(&bc, row, len, line_no, batch_err(), &sem) : NULL;
+        if (!st) continue;
+        if (last_branch >= 0 && (last_branch != bc.current_branch || strcmp(last_id, bc.current_id) != 0)) {
+            analytics_add_student(&an, last_branch, last_id, last_cgpa, last_cgpa_x100);
+        }
+        analytics_add_row(&an, st, sem);
+        strcpy(last_id, bc.current_id);
+        last_branch = bc.current_branch;
+        last_cgpa = st->total_credits ? (double)st->total_credit_points / st->total_credits : 0.0;
+        last_cgpa_x100 = CGPA_X100(st);
+    }
+    if (last_branch >= 0) analytics_add_student(&an, last_branch, last_id, last_cgpa, last_cgpa_x100);
+
+    analytics_print(&an, out, bc.graded, bc.rejected);
+    fprintf(stderr, "Analytics complete: %ld student(s), %ld row(s) graded, %ld rejected.\n", an.students, bc.graded, bc.rejected);
+    analytics_free(&an);
+    batch_context_free(&bc);
+    batch_input_close(&in);
+    if (out != stdout) fclose(out);
+    return bc.rejected > 0 ? 2 : 0;
+}
+
+/* ===========================
+   What-if planner (branch menu, --plan FILE --target CGPA): what the remaining semesters need.
+   The required SGPA is the credit-points still missing over the GPA credits still to come.
+   The cheapest way to get them -- every remaining subject passed, fewest total marks -- is a
+   knapsack over credit-weighted grade points: least marks for exactly v points, one table per
+   branch and set of remaining semesters. Tables are built on first use and shared by every
+   student with the same semesters left, so a cohort costs one lookup per student.
+   =========================== */
+#define PLAN_DEFAULT_TARGET 800             /* CGPA x 100 */
+#define PLAN_MET 0                          /* passing everything left reaches the target */
+#define PLAN_POSSIBLE 1
+#define PLAN_UNREACHABLE 2
+
+typedef struct PlanTable {
+    struct PlanTable *next;         // other tables of the branch
+    int branch;
+    unsigned int remaining;         // bit s set: semester s still to take
+    int num_subjects;               // GPA subjects of those semesters, in syllabus order
+    int credits;
+    int min_points;                 // every subject at its lowest passing grade
+    int max_points;                 // highest v any plan reaches (schemes may cap grade points below 10)
+    int width;                      // entries of cost, best and each choice row: credits x top grade point + 1
+    int *sem;                       // [num_subjects] semester index
+    int *subject;                   // [num_subjects] index within the semester
+    int *cost;                      // [width] least marks giving exactly v points, INT_MAX if none
+    int *best;                      // [width] v' in v..max_points with the least cost (v <= max_points)
+    unsigned char *choice;          // [num_subjects * width] grade point of subject k in that optimum
+} PlanTable;
+
+typedef struct {
+    int status;                     // PLAN_*
+    int remaining_credits;
+    int points_needed;              // credit-points still needed; <= 0 once the target is safe
+    int points;                     // of the cheapest plan
+    int marks;                      // total marks of the cheapest plan
+    const PlanTable *table;         // NULL if nothing is left to take
+} Plan;
+
+Arena plan_arena;
+PlanTable **plan_tables;            // [num_branches] lists, built on first use
+
+/* Least marks giving each passing grade point of a scheme; -1 where a grade point is not used */
+static void plan_levels(const GradingScheme *g, int *min_marks) {
+    for (int gp = 0; gp <= 10; gp++) min_marks[gp] = -1;
+    for (int m = 100; m >= 0; m--) {
+        if (g->grade_point[m] > 0) min_marks[g->grade_point[m]] = m;
+    }
+}
+
+static PlanTable *plan_build(int branch_index, unsigned int remaining) {
+    const Branch *br = &all_branches[branch_index];
+    int n = 0, credits = 0, max_gp = 0;
+    for (int s = 0; s < br->num_semesters; s++) {
+        if (!(remaining >> s & 1u)) continue;
+        n += br->semesters[s].num_subjects - br->semesters[s].num_pf;
+        credits += br->semesters[s].gpa_credits;
+        for (int m = 0; m <= 100; m++) {
+            if (SEMESTER_SCHEME(&br->semesters[s])->grade_point[m] > max_gp) max_gp = SEMESTER_SCHEME(&br->semesters[s])->grade_point[m];
+        }
+    }
+    int width = credits * max_gp + 1;
+    PlanTable *t = arena_alloc(&plan_arena, sizeof *t);
+    int *prev = malloc((size_t)width * sizeof *prev);
+    if (!t || !prev ||
+        !(t->sem = arena_alloc(&plan_arena, (size_t)(n + 1) * sizeof *t->sem)) ||
+        !(t->subject = arena_alloc(&plan_arena, (size_t)(n + 1) * sizeof *t->subject)) ||
+        !(t->cost = arena_alloc(&plan_arena, (size_t)width * sizeof *t->cost)) ||
+        !(t->best = arena_alloc(&plan_arena, (size_t)width * sizeof *t->best)) ||
+        !(t->choice = arena_alloc(&plan_arena, (size_t)n * (size_t)width + 1))) {
+        free(prev);
+        return NULL;
+    }
+    t->branch = branch_index;
+    t->remaining = remaining;
+    t->num_subjects = n;
+    t->credits = credits;
+    t->width = width;
+
+    /* cost[v] over the first k subjects; prev holds the table before subject k */
+    int *cost = t->cost;
+    for (int v = 0; v < width; v++) cost[v] = INT_MAX;
+    cost[0] = 0;
+    int k = 0, reach = 0;
+    for (int s = 0; s < br->num_semesters; s++) {
+        if (!(remaining >> s & 1u)) continue;
+        const Semester *syl = &br->semesters[s];
+        int min_marks[11];
+        plan_levels(SEMESTER_SCHEME(syl), min_marks);
+        for (int i = 0; i < syl->num_subjects; i++) {
+            int c = syl->subjects[i].credits;
+            if (syl->subjects[i].is_passfail) continue;
+            unsigned char *choice = t->choice + (size_t)k * (size_t)width;
+            memcpy(prev, cost, (size_t)(reach + 1) * sizeof *prev);
+            int next_reach = reach;
+            for (int v = 0; v < width; v++) cost[v] = INT_MAX;
+            for (int g = 1; g <= 10; g++) {
+                if (min_marks[g] < 0) continue;
+                int add = c * g, m = min_marks[g];
+                for (int v = 0; v <= reach; v++) {
+                    if (prev[v] == INT_MAX || prev[v] + m >= cost[v + add]) continue;
+                    cost[v + add] = prev[v] + m;
+                    choice[v + add] = (unsigned char)g;
+                }
+                if (reach + add > next_reach) next_reach = reach + add;
+            }
+            reach = next_reach;
+            t->sem[k] = s;
+            t->subject[k++] = i;
+        }
+    }
+    free(prev);
+
+    /* width only bounds the table: with a capped scheme in one semester and not another, the top
+       of it cannot be reached, so best[] starts from the highest reachable v */
+    t->min_points = width;
+    for (int v = 0; v < width; v++) {
+        if (cost[v] != INT_MAX) { t->min_points = v; break; }
+    }
+    t->max_points = -1;
+    for (int v = reach < width ? reach : width - 1; v >= 0 && t->max_points < 0; v--) {
+        if (cost[v] != INT_MAX) t->max_points = v;
+    }
+    if (t->max_points >= 0) t->best[t->max_points] = t->max_points;
+    for (int v = t->max_points - 1; v >= 0; v--) {
+        int b = t->best[v + 1];
+        t->best[v] = cost[v] <= cost[b] ? v : b;
+    }
+    t->next = plan_tables[branch_index];
+    plan_tables[branch_index] = t;
+    return t;
+}
+
+/* The table for a branch and set of remaining semesters, built on first use */
+static const PlanTable *plan_table(int branch_index, unsigned int remaining) {
+    if (!plan_tables && !(plan_tables = arena_alloc(&plan_arena, (size_t)num_branches * sizeof *plan_tables))) return NULL;
+    for (const PlanTable *t = plan_tables[branch_index]; t; t = t->next) {
+        if (t->remaining == remaining) return t;
+    }
+    return plan_build(branch_index, remaining);
+}
+
+/* Plan the semesters a student has not completed for a target CGPA (x 100); 0 if out of memory */
+int plan_student(const StudentRecord *st, int target_x100, Plan *p) {
+    unsigned int remaining = 0;
+    for (int s = 0; s < all_branches[st->branch].num_semesters; s++) {
+        if (!st->sems[s].is_completed) remaining |= 1u << s;
+    }
+    memset(p, 0, sizeof *p);
+    p->table = remaining ? plan_table(st->branch, remaining) : NULL;
+    if (remaining && !p->table) return 0;
+    int credits = p->table ? p->table->credits : 0;
+    /* (done + x) / (credits done + credits left) >= target, in integers */
+    long long total = (long long)target_x100 * (st->total_credits + credits);
+    p->points_needed = (int)((total + 99) / 100) - st->total_credit_points;
+    p->remaining_credits = credits;
+    if (!p->table || p->table->min_points > p->table->max_points) {
+        p->status = p->points_needed <= 0 ? PLAN_MET : PLAN_UNREACHABLE;
+        return 1;
+    }
+    if (p->points_needed > p->table->max_points) {
+        p->status = PLAN_UNREACHABLE;
+        return 1;
+    }
+    p->points = p->table->best[p->points_needed > 0 ? p->points_needed : 0];
+    p->marks = p->table->cost[p->points];
+    p->status = p->points_needed <= p->table->min_points ? PLAN_MET : PLAN_POSSIBLE;
+    return 1;
+}
+
+/* Grade point targets of the cheapest plan, one per table subject */
+void plan_grade_points(const Plan *p, unsigned char *gp) {
+    const PlanTable *t = p->table;
+    int v = p->points;
+    for (int k = t->num_subjects - 1; k >= 0; k--) {
+        gp[k] = t->choice[(size_t)k * (size_t)t->width + (size_t)v];
+        v -= gp[k] * all_branches[t->branch].semesters[t->sem[k]].subjects[t->subject[k]].credits;
+    }
+}
+
+/* Required SGPA x 100 in each remaining semester, rounded up: a figure rounded down would leave
+   the target short */
+static int plan_required_x100(const Plan *p) {
+    int needed = p->points_needed > 0 ? p->points_needed : 0;
+    if (p->remaining_credits <= 0) return 0;
+    return (int)(((long long)needed * 100 + p->remaining_credits - 1) / p->remaining_credits);
+}
+
+/* Target CGPA "8" or "7.25" as x 100 */
+static int parse_cgpa_x100(const char *s, int *out) {
+    char *end;
+    errno = 0;
+    double v = strtod(s, &end);
+    if (end == s || *end || errno || !(v >= 0.0 && v <= 10.0)) return 0;
+    *out = (int)(v * 100.0 + 0.5);
+    return 1;
+}
+
+/* Branch menu: required SGPA and the cheapest subject targets for a target CGPA */
+void what_if_planner(int branch_index) {
+    const StudentRecord *st = console_student(branch_index);
+    const Branch *br = &all_branches[branch_index];
+    char buf[32];
+    int target = 0;
+    printf("Target CGPA: ");
+    if (scanf("%31s", buf) != 1 || !parse_cgpa_x100(buf, &target)) { printf("Invalid target (0-10).\n"); return; }
+
+    Plan p;
+    if (!plan_student(st, target, &p)) { printf("Out of memory.\n"); return; }
+    int done = 0;
+    for (int s = 0; s < br->num_semesters; s++) done += st->sems[s].is_completed;
+    printf("\n--- WHAT-IF PLAN for %s (%s): target CGPA %d.%02d ---\n", br->name, br->code, target / 100, target % 100);
+    char cgpa[GPA_TEXT_MAX];
+    gpa_text(cgpa, CGPA_X100(st));
+    printf("Completed: %d semester(s), %d GPA credits, CGPA %s\n", done, st->total_credits, cgpa);
+    if (!p.table) {
+        printf(p.status == PLAN_MET ? ">> All semesters completed: the target is reached.\n"
+                                    : ">> All semesters completed: the target was not reached.\n");
+        return;
+    }
+    int needed = p.points_needed > 0 ? p.points_needed : 0;
+    printf("Remaining: %d semester(s), %d GPA credits, %d credit-points needed\n", br->num_semesters - done, p.remaining_credits, needed);
+    if (p.status == PLAN_UNREACHABLE) {
+        char best[GPA_TEXT_MAX];
+        gpa_text(best, gpa_x100(st->total_credit_points + p.table->max_points, st->total_credits + p.remaining_credits));
+        printf(">> Not reachable: the best possible CGPA is %s.\n", best);
+        return;
+    }
+    if (p.remaining_credits) {
+        char required[GPA_TEXT_MAX];
+        gpa_text(required, plan_required_x100(&p));
+        printf(">> Required SGPA in each remaining semester: %s\n", required);
+    }
+    if (p.status == PLAN_MET) printf(">> Passing every remaining subject already reaches the target.\n");
+
+    const PlanTable *t = p.table;
+    unsigned char *gp = malloc((size_t)t->num_subjects + 1);
+    if (!gp) { printf("Out of memory.\n"); return; }
+    plan_grade_points(&p, gp);
+    printf("Cheapest subject targets (fewest total marks: %d):\n", p.marks);
+    int k = 0;
+    for (int s = 0; s < br->num_semesters; s++) {
+        if (!(t->remaining >> s & 1u)) continue;
+        const Semester *syl = &br->semesters[s];
+        int min_marks[11], points = 0, credits = 0;
+        plan_levels(SEMESTER_SCHEME(syl), min_marks);
+        for (int j = k; j < t->num_subjects && t->sem[j] == s; j++) {
+            int c = syl->subjects[t->subject[j]].credits;
+            points += gp[j] * c;
+            credits += c;
+        }
+        char sgpa[GPA_TEXT_MAX];
+        gpa_text(sgpa, gpa_x100(points, credits));
+        printf("  Semester %d: SGPA %s\n", syl->sem_number, sgpa);
+        for (int i = 0; i < syl->num_subjects; i++) {
+            const Subject *sub = &syl->subjects[i];
+            if (sub->is_passfail) {
+                printf("    %-28.28s | %2d | P/F   | marks >= %d\n", sub->name, sub->credits, SEMESTER_SCHEME(syl)->pf_pass);
+            } else {
+                printf("    %-28.28s | %2d | GP %2d | marks >= %d\n", sub->name, sub->credits, gp[k], min_marks[gp[k]]);
+                k++;
+            }
+        }
+    }
+    free(gp);
+}
+
+/* A graded student's plan, kept until their last row has been read */
+typedef struct {
+    char id[32];
+    int branch;
+    int done;
+    int cgpa_x100;
+    Plan plan;
+} PlanRow;
+
+static void plan_write_row(FILE *out, const PlanRow *r, unsigned char *gp) {
+    static const char *const status[] = { "met", "possible", "unreachable" };
+    const Plan *p = &r->plan;
+    const Branch *br = &all_branches[r->branch];
+    char cgpa[GPA_TEXT_MAX];
+    gpa_text(cgpa, r->cgpa_x100);
+    fprintf(out, "%s,%s,%d,%s,%d,%d,", r->id, br->code, r->done, cgpa, p->remaining_credits,
+            p->points_needed > 0 ? p->points_needed : 0);
+    if (p->remaining_credits) {
+        char required[GPA_TEXT_MAX];
+        gpa_text(required, plan_required_x100(p));
+        fputs(required, out);
+    }
+    fprintf(out, ",%s,", status[p->status]);
+    if (!p->table || p->status == PLAN_UNREACHABLE) { fputs(",,\n", out); return; }
+
+    const PlanTable *t = p->table;
+    plan_grade_points(p, gp);
+    fprintf(out, "%d,", p->marks);
+    /* per remaining semester: SGPA of the plan, then the grade point of each GPA subject */
+    for (int pass = 0; pass < 2; pass++) {
+        const char *sep = "";
+        for (int k = 0; k < t->num_subjects; ) {
+            int s = t->sem[k], points = 0, credits = 0;
+            fprintf(out, "%s%d=", sep, br->semesters[s].sem_number);
+            sep = " ";
+            for (int j = k; j < t->num_subjects && t->sem[j] == s; j++) {
+                int c = br->semesters[s].subjects[t->subject[j]].credits;
+                points += gp[j] * c;
+                credits += c;
+                if (pass == 1) fprintf(out, j > k ? "/%d" : "%d", gp[j]);
+            }
+            if (pass == 0) {
+                char sgpa[GPA_TEXT_MAX];
+                gpa_text(sgpa, gpa_x100(points, credits));
+                fputs(sgpa, out);
+            }
+            while (k < t->num_subjects && t->sem[k] == s) k++;
+        }
+        fputc(pass == 0 ? ',' : '\n', out);
+    }
+}
+
+int run_plan(const char *in_path, const char *out_path, int target_x100) {
+    BatchInput in;
+    if (!batch_input_open(&in, in_path)) return 1;
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); batch_input_close(&in); return 1; }
+
+    int max_subjects = 0;
+    for (int b = 0; b < num_branches; b++) {
+        if (all_branches[b].num_subjects > max_subjects) max_subjects = all_branches[b].num_subjects;
+    }
+    BatchContext bc;
+    unsigned char *gp = malloc((size_t)max_subjects + 1);
+    int ctx_ok = report_context_init(&bc);
+    if (!ctx_ok || !gp) {
+        fprintf(stderr, "Out of memory.\n");
+        if (ctx_ok) batch_context_free(&bc);
+        free(gp);
+        batch_input_close(&in);
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+
+    fprintf(out, "student_id,branch,semesters_done,cgpa,remaining_credits,points_needed,required_sgpa,status,plan_marks,plan_sgpa,plan_grade_points\n");
+    PlanRow last;
+    long students = 0, line_no = 0;
+    int have_last = 0, ok = 1;
+    const char *row;
+    size_t len;
+    int got;
+    while ((got = batch_input_next(&in, &row, &len, ++line_no, &bc, batch_err())) != 0) {
+        int sem;
+        StudentRecord *st = got > 0 ? batch_grade_row(&bc, row, len, line_no, batch_err(), &sem) : NULL;
+        if (!st) continue;
+        if (have_last && (last.branch != bc.current_branch || strcmp(last.id, bc.current_id) != 0)) {
+            plan_write_row(out, &last, gp);
+            students++;
+        }
+        strcpy(last.id, bc.current_id);
+        last.branch = bc.current_branch;
+        last.cgpa_x100 = CGPA_X100(st);
+        last.done = 0;
+        for (int s = 0; s < all_branches[st->branch].num_semesters; s++) last.done += st->sems[s].is_completed;
+        if (!plan_student(st, target_x100, &last.plan)) { fprintf(stderr, "Out of memory.\n"); ok = 0; have_last = 0; break; }
+        have_last = 1;
+    }
+    if (have_last) {
+        plan_write_row(out, &last, gp);
+        students++;
+    }
+    if (fflush(out) != 0) { perror(out_path ? out_path : "stdout"); ok = 0; }
+
+    fprintf(stderr, "Plan complete: %ld student(s) planned for CGPA %d.%02d, %ld row(s) graded, %ld rejected.\n",
+            students, target_x100 / 100, target_x100 % 100, bc.graded, bc.rejected);
+    free(gp);
+    batch_context_free(&bc);
+    arena_free(&plan_arena);
+    plan_tables = NULL;
+    batch_input_close(&in);
+    if (out != stdout) fclose(out);
+    return !ok ? 1 : bc.rejected > 0 ? 2 : 0;
+}
+
+/* ===========================
+   Revaluation patches (--revaluate FILE, with --store DIR): changed marks of graded subjects
+   applied to stored students, one row per change:  student_id,semester,subject,marks
+   (subject numbered from 1 within the semester, as in the branch menu). Each patch goes
+   through apply_revaluation(), so only the subject's grade-point delta touches the SGPA, CGPA
+   and P/F flag. Ranks come from per-branch histograms of CGPA x 100, taken before the first
+   patch and updated as CGPAs move, so a rank is a suffix sum rather than a sort.
+   The changelog has one row per value that changed:  student_id,branch,field,semester,subject,old,new
+   =========================== */
+#define REVAL_BINS ANALYTICS_BINS
+
+/* State of a patched student before their first patch */
+typedef struct {
+    int student;                    // cohort index
+    int bin;                        // CGPA x 100, -1 while no credits are graded
+    int backlogs;
+    int eligible;
+    int sgpa[SEMESTER_NUMBER_LIMIT];    // x 100
+    unsigned char pf_failed[SEMESTER_NUMBER_LIMIT];
+} RevalTouched;
+
+/* CGPA x 100 rounded from the integer totals, -1 while no credits are graded */
+static int cgpa_bin(const StudentRecord *st) {
+    return st->total_credits > 0 ? CGPA_X100(st) : -1;
+}
+
+/* Failed subjects still to clear: GPA subjects at grade point 0 and failed P/F subjects */
+int count_backlogs(const StudentRecord *st) {
+    const Branch *br = &all_branches[st->branch];
+    int n = 0;
+    for (int s = 0; s < br->num_semesters; s++) {
+        if (!st->sems[s].is_completed) continue;
+        const signed char *gp = STUDENT_GP(st, s);
+        for (int i = 0; i < br->semesters[s].num_subjects; i++) {
+            if (br->semesters[s].subjects[i].is_passfail ? gp[i] == GP_PF_FAIL : gp[i] == 0) n++;
+        }
+    }
+    return n;
+}
+
+/* above[b] = students of the branch whose CGPA bin is higher than b */
+static void reval_ranks(const int *hist, int *above) {
+    above[REVAL_BINS - 1] = 0;
+    for (int b = REVAL_BINS - 2; b >= 0; b--) above[b] = above[b + 1] + hist[b + 1];
+}
+
+static void reval_change(FILE *out, const StudentRecord *st, const char *field, int sem, int subject, const char *old_v, const char *new_v) {
+    fprintf(out, "%s,%s,%s,", st->reg_no, all_branches[st->branch].code, field);
+    if (sem > 0) fprintf(out, "%d", sem);
+    fputc(',', out);
+    if (subject > 0) fprintf(out, "%d", subject);
+    fprintf(out, ",%s,%s\n", old_v, new_v);
+}
+
+static void reval_change_int(FILE *out, const StudentRecord *st, const char *field, int sem, int subject, int old_v, int new_v) {
+    char a[16], b[16];
+    snprintf(a, sizeof a, "%d", old_v);
+    snprintf(b, sizeof b, "%d", new_v);
+    reval_change(out, st, field, sem, subject, a, b);
+}
+
+static void reval_change_gpa(FILE *out, const StudentRecord *st, const char *field, int sem, int old_x100, int new_x100) {
+    char a[GPA_TEXT_MAX], b[GPA_TEXT_MAX];
+    if (old_x100 == new_x100) return;
+    gpa_text(a, old_x100);
+    gpa_text(b, new_x100);
+    reval_change(out, st, field, sem, 0, a, b);
+}
+
+int run_revaluation(const char *in_path, const char *out_path) {
+    StudentStore *ss = &student_store;
+    if (!ss->is_open) {
+        fprintf(stderr, "--revaluate patches stored students: add --store DIR.\n");
+        return 1;
+    }
+    BatchInput in;
+    if (!batch_input_open(&in, in_path)) return 1;
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); batch_input_close(&in); return 1; }
+
+    BatchContext bc;
+    int ctx_ok = batch_context_init(&bc);
+    int n = ss->cohort.count;
+    int *touched_at = malloc(((size_t)n + 1) * sizeof *touched_at);
+    int *hist = calloc((size_t)num_branches * REVAL_BINS, sizeof *hist);
+    int *above_before = malloc((size_t)num_branches * REVAL_BINS * sizeof *above_before);
+    int *above_after = malloc((size_t)num_branches * REVAL_BINS * sizeof *above_after);
+    RevalTouched *touched = NULL;
+    int num_touched = 0, cap_touched = 0, ok = 1;
+    if (!ctx_ok || !touched_at || !hist || !above_before || !above_after) {
+        fprintf(stderr, "Out of memory.\n");
+        ok = 0;
+        goto done;
+    }
+
+    double t0 = bench_now();
+    for (int k = 0; k < n; k++) {
+        touched_at[k] = -1;
+        int b = cgpa_bin(&ss->cohort.students[k]);
+        if (b >= 0) hist[ss->cohort.students[k].branch * REVAL_BINS + b]++;
+    }
+    for (int br = 0; br < num_branches; br++) reval_ranks(hist + br * REVAL_BINS, above_before + br * REVAL_BINS);
+
+    fprintf(out, "student_id,branch,field,semester,subject,old,new\n");
+    long line_no = 0, patches = 0;
+    const char *row;
+    size_t len;
+    int got;
+    while ((got = batch_input_next(&in, &row, &len, ++line_no, &bc, batch_err())) != 0) {
+        if (got < 0 || len == 0 || row[0] == '#' || row[0] == '\n' || row[0] == '\r') continue;
+        const char *end = row + len, *limit = bc.limit && bc.limit >= end ? bc.limit : end;
+        int nf = split_row(row, end, bc.fields, bc.field_len, bc.max_fields);
+        int sem = 0, sub = 0, marks = -1;
+        if (nf != 4 || !parse_int_span(bc.fields[1], bc.field_len[1], limit, &sem) ||
+            !parse_int_span(bc.fields[2], bc.field_len[2], limit, &sub) ||
+            !parse_int_span(bc.fields[3], bc.field_len[3], limit, &marks) || marks < 0 || marks > 100) {
+            if (line_no > 1) batch_reject(&bc, batch_err(), line_no, row, len, "expected student_id,semester,subject,marks 0-100, skipped");
+            continue;
+        }
+        char id[sizeof ss->cohort.students[0].reg_no];
+        int k = bc.field_len[0] < (int)sizeof id ? 0 : -1;
+        if (k == 0) {
+            memcpy(id, bc.fields[0], (size_t)bc.field_len[0]);
+            id[bc.field_len[0]] = '\0';
+            k = student_index_find(ss, id);
+        }
+        if (k < 0) {
+            batch_reject(&bc, batch_err(), line_no, row, len, "student '%.*s' is not stored, skipped", bc.field_len[0], bc.fields[0]);
+            continue;
+        }
+        StudentRecord *st = &ss->cohort.students[k];
+        const Branch *br = &all_branches[st->branch];
+        if (sem < 1 || sem > br->num_semesters || !st->sems[sem - 1].is_completed ||
+            sub < 1 || sub > br->semesters[sem - 1].num_subjects) {
+            batch_reject(&bc, batch_err(), line_no, row, len, "%s has no graded semester %d subject %d, skipped", st->reg_no, sem, sub);
+            continue;
+        }
+
+        if (touched_at[k] < 0) {
+            if (num_touched == cap_touched) {
+                int cap = cap_touched ? cap_touched * 2 : 1024;
+                RevalTouched *grown = realloc(touched, (size_t)cap * sizeof *grown);
+                if (!grown) { fprintf(stderr, "Out of memory.\n"); ok = 0; break; }
+                touched = grown;
+                cap_touched = cap;
+            }
+            RevalTouched *t = &touched[num_touched];
+            t->student = k;
+            t->bin = cgpa_bin(st);
+            t->backlogs = count_backlogs(st);
+            t->eligible = eligibility_failures(st) == 0;
+            for (int s = 0; s < br->num_semesters; s++) {
+                t->sgpa[s] = SGPA_X100(&st->sems[s]);
+                t->pf_failed[s] = st->sems[s].pf_failed;
+            }
+            touched_at[k] = num_touched++;
+        }
+
+        int old_marks = STUDENT_MARKS(st, sem - 1)[sub - 1];
+        int old_gp = STUDENT_GP(st, sem - 1)[sub - 1];
+        int old_bin = cgpa_bin(st);
+        apply_revaluation(st, sem - 1, sub - 1, marks);
+        int new_bin = cgpa_bin(st);
+        if (old_bin != new_bin) {
+            if (old_bin >= 0) hist[st->branch * REVAL_BINS + old_bin]--;
+            if (new_bin >= 0) hist[st->branch * REVAL_BINS + new_bin]++;
+        }
+        if (!store_log_revaluation(ss, st, sem - 1, sub - 1)) {
+            batch_reject(&bc, batch_err(), line_no, row, len, "could not append to the store");
+            ok = 0;
+            break;
+        }
+        patches++;
+        if (old_marks != marks) reval_change_int(out, st, "marks", sem, sub, old_marks, marks);
+        if (old_gp != STUDENT_GP(st, sem - 1)[sub - 1]) {
+            if (br->semesters[sem - 1].subjects[sub - 1].is_passfail) {
+                reval_change(out, st, "pf", sem, sub, old_gp == GP_PF_FAIL ? "fail" : "pass",
+                             STUDENT_GP(st, sem - 1)[sub - 1] == GP_PF_FAIL ? "fail" : "pass");
+            } else {
+                reval_change_int(out, st, "grade_point", sem, sub, old_gp, STUDENT_GP(st, sem - 1)[sub - 1]);
+            }
+        }
+    }
+
+    /* per student: semester results, CGPA, rank and eligibility against their state before */
+    for (int br = 0; br < num_branches; br++) reval_ranks(hist + br * REVAL_BINS, above_after + br * REVAL_BINS);
+    long rank_changes = 0, eligibility_changes = 0, moved = 0;
+    for (int i = 0; i < num_touched; i++) {
+        const RevalTouched *t = &touched[i];
+        const StudentRecord *st = &ss->cohort.students[t->student];
+        const Branch *br = &all_branches[st->branch];
+        for (int s = 0; s < br->num_semesters; s++) {
+            reval_change_gpa(out, st, "sgpa", s + 1, t->sgpa[s], SGPA_X100(&st->sems[s]));
+            if (t->pf_failed[s] != st->sems[s].pf_failed) reval_change_int(out, st, "pf_failed", s + 1, 0, t->pf_failed[s], st->sems[s].pf_failed);
+        }
+        int bin = cgpa_bin(st);
+        reval_change_gpa(out, st, "cgpa", 0, t->bin < 0 ? 0 : t->bin, bin < 0 ? 0 : bin);
+        int old_rank = t->bin >= 0 ? 1 + above_before[st->branch * REVAL_BINS + t->bin] : 0;
+        int new_rank = bin >= 0 ? 1 + above_after[st->branch * REVAL_BINS + bin] : 0;
+        if (old_rank != new_rank) {
+            reval_change_int(out, st, "rank", 0, 0, old_rank, new_rank);
+            rank_changes++;
+        }
+        int backlogs = count_backlogs(st);
+        if (backlogs != t->backlogs) reval_change_int(out, st, "backlogs", 0, 0, t->backlogs, backlogs);
+        int eligible = eligibility_failures(st) == 0;
+        if (eligible != t->eligible) {
+            reval_change(out, st, "eligible", 0, 0, t->eligible ? "yes" : "no", eligible ? "yes" : "no");
+            eligibility_changes++;
+        }
+    }
+    /* students nobody patched whose rank moved because patched students passed them */
+    for (int br = 0; br < num_branches; br++) {
+        for (int b = 0; b < REVAL_BINS; b++) {
+            if (above_before[br * REVAL_BINS + b] != above_after[br * REVAL_BINS + b]) moved += hist[br * REVAL_BINS + b];
+        }
+    }
+    for (int i = 0; i < num_touched; i++) {
+        const StudentRecord *st = &ss->cohort.students[touched[i].student];
+        int b = cgpa_bin(st);
+        if (b >= 0 && above_before[st->branch * REVAL_BINS + b] != above_after[st->branch * REVAL_BINS + b]) moved--;
+    }
+    if (fflush(out) != 0) { perror(out_path ? out_path : "stdout"); ok = 0; }
+    fprintf(stderr, "Revaluation complete: %ld patch(es) applied to %d student(s) in %.1f ms, %ld rejected; "
+            "%ld rank and %ld eligibility change(s), %ld other student(s) moved in rank.\n",
+            patches, num_touched, (bench_now() - t0) * 1e3, bc.rejected, rank_changes, eligibility_changes, moved);
+
+done:
+    free(touched);
+    free(touched_at);
+    free(hist);
+    free(above_before);
+    free(above_after);
+    if (ctx_ok) batch_context_free(&bc);
+    batch_input_close(&in);
+    if (out != stdout) fclose(out);
+    return !ok ? 1 : bc.rejected > 0 ? 2 : 0;
+}
+
+/* ===========================
+   Degree eligibility rules (eligibility_rules.txt or --rules FILE; --eligibility [FILE]).
+   Each rule is one check against a student's results:
+     RULE|name|branch_code or *|check|value|subject name pattern (MIN_CREDITS_IN only)
+   Checks: MIN_CGPA x.xx, MIN_SGPA x.xx (every graded semester), MAX_BACKLOGS n (failed GPA
+   subjects), MAX_PF_FAILURES n, MIN_ACTIVITY n, MIN_CREDITS n (credits of passed GPA subjects),
+   ALL_SEMESTERS, MIN_CREDITS_IN n pattern (passed credits of subjects whose name contains it).
+   Rules are compiled per branch into a flat vector of ops, with the subjects of each pattern
+   resolved up front. A student costs one pass over their results to gather the facts the
+   checks read, then the vector; the result is a bitmask of the rules that failed.
+   =========================== */
+#define DEFAULT_RULES "eligibility_rules.txt"
+#define MAX_RULES 64                        /* rules are reported as bits of a 64-bit mask */
+
+#define CHECK_MIN_CGPA 0
+#define CHECK_MIN_SGPA 1
+#define CHECK_MAX_BACKLOGS 2
+#define CHECK_MAX_PF_FAILURES 3
+#define CHECK_MIN_ACTIVITY 4
+#define CHECK_MIN_CREDITS 5
+#define CHECK_ALL_SEMESTERS 6
+#define CHECK_MIN_CREDITS_IN 7
+
+static const char *const check_names[] = {
+    "MIN_CGPA", "MIN_SGPA", "MAX_BACKLOGS", "MAX_PF_FAILURES", "MIN_ACTIVITY", "MIN_CREDITS", "ALL_SEMESTERS", "MIN_CREDITS_IN"
+};
+#define NUM_CHECKS ((int)(sizeof check_names / sizeof check_names[0]))
+
+typedef struct {
+    char name[32];
+    int check;                      // CHECK_*
+    int branch;                     // -1 = every branch
+    int value;                      // CGPA / SGPA x 100
+    char pattern[64];
+} EligibilityRule;
+
+/* A subject counted by a MIN_CREDITS_IN op */
+typedef struct {
+    int offset;                     // into the student's marks / grade_points
+    int sem_index;
+    int credits;
+} EligibilitySubject;
+
+typedef struct {
+    int check;
+    int rule;                       // bit set in the result when the op fails
+    int value;
+    int first_subject;              // MIN_CREDITS_IN: subjects[first_subject .. + num_subjects)
+    int num_subjects;
+} EligibilityOp;
+
+/* The rules that apply to one branch */
+typedef struct {
+    EligibilityOp *ops;
+    int num_ops;
+    EligibilitySubject *subjects;
+} EligibilityProgram;
+
+/* What the checks read, gathered in one pass over a student's graded semesters */
+typedef struct {
+    int cgpa_x100;                  // -1 while no credits are graded
+    int min_sgpa_x100;              // INT_MAX while no semester with GPA credits is graded
+    int backlogs;                   // GPA subjects at grade point 0
+    int pf_failures;
+    int activity;
+    int credits_earned;
+    int semesters_done;
+} EligibilityFacts;
+
+Arena rules_arena;
+EligibilityRule eligibility_rules[MAX_RULES];
+int num_eligibility_rules;
+EligibilityProgram *eligibility_programs;  // [num_branches]
+
+static int add_rule(const char *name, int check, int branch, int value, const char *pattern) {
+    if (num_eligibility_rules == MAX_RULES) return 0;
+    EligibilityRule *r = &eligibility_rules[num_eligibility_rules++];
+    snprintf(r->name, sizeof r->name, "%s", name);
+    r->check = check;
+    r->branch = branch;
+    r->value = value;
+    snprintf(r->pattern, sizeof r->pattern, "%s", pattern ? pattern : "");
+    return 1;
+}
+
+/* Build each branch's op vector from the loaded rules */
+static int compile_eligibility_rules(void) {
+    arena_free(&rules_arena);
+    eligibility_programs = arena_alloc(&rules_arena, (size_t)num_branches * sizeof *eligibility_programs);
+    if (!eligibility_programs) return 0;
+    for (int b = 0; b < num_branches; b++) {
+        const Branch *br = &all_branches[b];
+        EligibilityProgram *p = &eligibility_programs[b];
+        int num_subjects = 0;
+        for (int k = 0; k < num_eligibility_rules; k++) {
+            const EligibilityRule *r = &eligibility_rules[k];
+            if (r->branch >= 0 && r->branch != b) continue;
+            p->num_ops++;
+            if (r->check != CHECK_MIN_CREDITS_IN) continue;
+            for (int s = 0; s < br->num_semesters; s++) {
+                const Semester *syl = &br->semesters[s];
+                for (int i = 0; i < syl->num_subjects; i++) num_subjects += !syl->subjects[i].is_passfail && strstr(syl->subjects[i].name, r->pattern);
+            }
+        }
+        p->ops = arena_alloc(&rules_arena, (size_t)(p->num_ops + 1) * sizeof *p->ops);
+        p->subjects = arena_alloc(&rules_arena, (size_t)(num_subjects + 1) * sizeof *p->subjects);
+        if (!p->ops || !p->subjects) return 0;
+
+        int n = 0, m = 0;
+        for (int k = 0; k < num_eligibility_rules; k++) {
+            const EligibilityRule *r = &eligibility_rules[k];
+            if (r->branch >= 0 && r->branch != b) continue;
+            EligibilityOp *op = &p->ops[n++];
+            op->check = r->check;
+            op->rule = k;
+            op->value = r->value;
+            op->first_subject = m;
+            if (r->check != CHECK_MIN_CREDITS_IN) continue;
+            for (int s = 0; s < br->num_semesters; s++) {
+                const Semester *syl = &br->semesters[s];
+                for (int i = 0; i < syl->num_subjects; i++) {
+                    if (!strstr(syl->subjects[i].name, r->pattern) || syl->subjects[i].is_passfail) continue;
+                    p->subjects[m].offset = syl->first_subject + i;
+                    p->subjects[m].sem_index = s;
+                    p->subjects[m++].credits = syl->subjects[i].credits;
+                }
+            }
+            op->num_subjects = m - op->first_subject;
+        }
+    }
+    return 1;
+}
+
+/* Load and compile eligibility rules (call after load_syllabus). Without the default file the
+   built-in rules apply: every semester graded, no backlogs or P/F failures, activity points met. */
+int load_eligibility_rules(const char *path, int required) {
+    num_eligibility_rules = 0;
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        if (required) { perror(path); return 0; }
+        add_rule("all_semesters", CHECK_ALL_SEMESTERS, -1, 0, NULL);
+        add_rule("no_backlogs", CHECK_MAX_BACKLOGS, -1, 0, NULL);
+        add_rule("no_pf_failures", CHECK_MAX_PF_FAILURES, -1, 0, NULL);
+        add_rule("activity_points", CHECK_MIN_ACTIVITY, -1, ACTIVITY_REQUIRED, NULL);
+        return compile_eligibility_rules();
+    }
+
+    char line[SYLLABUS_LINE_MAX];
+    char *f[6];
+    int line_no = 0, ok = 1;
+    while (ok && fgets(line, sizeof line, in)) {
+        line_no++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
+
+        int nf = 0;
+        char *p = line;
+        f[nf++] = p;
+        while (nf < 6 && (p = strchr(p, '|')) != NULL) { *p++ = '\0'; f[nf++] = p; }
+
+        int check = -1, branch = -1, value = 0;
+        if (strcmp(f[0], "RULE") != 0 || nf < 5) {
+            fprintf(stderr, "%s:%d: expected RULE|name|branch or *|check|value[|pattern]\n", path, line_no);
+            ok = 0;
+            break;
+        }
+        for (int c = 0; c < NUM_CHECKS; c++) {
+            if (strcmp(f[3], check_names[c]) == 0) check = c;
+        }
+        if (strcmp(f[2], "*") != 0 && (branch = find_branch_by_code(f[2])) < 0) {
+            fprintf(stderr, "%s:%d: unknown branch '%s'\n", path, line_no, f[2]);
+            ok = 0;
+        } else if (check < 0) {
+            fprintf(stderr, "%s:%d: unknown check '%s'\n", path, line_no, f[3]);
+            ok = 0;
+        } else if (check == CHECK_MIN_CGPA || check == CHECK_MIN_SGPA ? !parse_cgpa_x100(f[4], &value)
+                   : check != CHECK_ALL_SEMESTERS && (!parse_int_field(f[4], &value) || value < 0)) {
+            fprintf(stderr, "%s:%d: bad value '%s' for %s\n", path, line_no, f[4], f[3]);
+            ok = 0;
+        } else if ((check == CHECK_MIN_CREDITS_IN) != (nf == 6 && f[5][0] != '\0')) {
+            fprintf(stderr, "%s:%d: a subject name pattern goes with MIN_CREDITS_IN only\n", path, line_no);
+            ok = 0;
+        } else if (f[1][0] == '\0' || strlen(f[1]) >= sizeof eligibility_rules[0].name || strchr(f[1], ';') || strchr(f[1], ',')) {
+            fprintf(stderr, "%s:%d: rule name empty, too long or containing ',' or ';'\n", path, line_no);
+            ok = 0;
+        } else if (!add_rule(f[1], check, branch, value, nf == 6 ? f[5] : NULL)) {
+            fprintf(stderr, "%s:%d: more than %d rules\n", path, line_no, MAX_RULES);
+            ok = 0;
+        }
+    }
+    fclose(in);
+    if (ok && !compile_eligibility_rules()) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        ok = 0;
+    }
+    return ok;
+}
+
+static void eligibility_facts(const StudentRecord *st, EligibilityFacts *f) {
+    const Branch *br = &all_branches[st->branch];
+    memset(f, 0, sizeof *f);
+    f->cgpa_x100 = cgpa_bin(st);
+    f->min_sgpa_x100 = INT_MAX;
+    for (int s = 0; s < br->num_semesters; s++) {
+        const SemesterResult *res = &st->sems[s];
+        f->activity += res->activity_points;
+        if (!res->is_completed) continue;
+        f->semesters_done++;
+        if (res->gpa_credits > 0) {
+            int sgpa = SGPA_X100(res);
+            if (sgpa < f->min_sgpa_x100) f->min_sgpa_x100 = sgpa;
+        }
+        const Semester *syl = &br->semesters[s];
+        const signed char *gp = STUDENT_GP(st, s);
+        for (int i = 0; i < syl->num_subjects; i++) {
+            if (syl->subjects[i].is_passfail) f->pf_failures += gp[i] == GP_PF_FAIL;
+            else if (gp[i] == 0) f->backlogs++;
+            else f->credits_earned += syl->subjects[i].credits;
+        }
+    }
+}
+
+/* Bitmask of the eligibility rules a student fails (bit k = eligibility_rules[k]); 0 = eligible */
+unsigned long long eligibility_failures(const StudentRecord *st) {
+    const EligibilityProgram *p = &eligibility_programs[st->branch];
+    EligibilityFacts f;
+    eligibility_facts(st, &f);
+    unsigned long long failed = 0;
+    for (int k = 0; k < p->num_ops; k++) {
+        const EligibilityOp *op = &p->ops[k];
+        int ok = 1;
+        switch (op->check) {
+        case CHECK_MIN_CGPA:        ok = f.cgpa_x100 >= op->value; break;
+        case CHECK_MIN_SGPA:        ok = f.min_sgpa_x100 >= op->value; break;
+        case CHECK_MAX_BACKLOGS:    ok = f.backlogs <= op->value; break;
+        case CHECK_MAX_PF_FAILURES: ok = f.pf_failures <= op->value; break;
+        case CHECK_MIN_ACTIVITY:    ok = f.activity >= op->value; break;
+        case CHECK_MIN_CREDITS:     ok = f.credits_earned >= op->value; break;
+        case CHECK_ALL_SEMESTERS:   ok = f.semesters_done == all_branches[st->branch].num_semesters; break;
+        case CHECK_MIN_CREDITS_IN: {
+            int credits = 0;
+            for (int j = 0; j < op->num_subjects; j++) {
+                const EligibilitySubject *sub = &p->subjects[op->first_subject + j];
+                if (st->sems[sub->sem_index].is_completed && st->grade_points[sub->offset] > 0) credits += sub->credits;
+            }
+            ok = credits >= op->value;
+            break;
+        }
+        }
+        if (!ok) failed |= 1ull << op->rule;
+    }
+    return failed;
+}
+
+/* One CSV row: student_id,branch,eligible,failed rules separated by ';' */
+static void eligibility_write_row(FILE *out, const char *reg_no, int branch, unsigned long long failed, long *rule_failures) {
+    fprintf(out, "%s,%s,%s,", reg_no, all_branches[branch].code, failed ? "no" : "yes");
+    const char *sep = "";
+    for (int k = 0; k < num_eligibility_rules; k++) {
+        if (!(failed >> k & 1ull)) continue;
+        fprintf(out, "%s%s", sep, eligibility_rules[k].name);
+        sep = ";";
+        rule_failures[k]++;
+    }
+    fputc('\n', out);
+}
+
+static void eligibility_summary(long students, long eligible, const long *rule_failures, double seconds) {
+    fprintf(stderr, "Eligibility: %ld of %ld student(s) eligible (evaluated in %.1f ms).\n", eligible, students, seconds * 1e3);
+    for (int k = 0; k < num_eligibility_rules; k++) {
+        fprintf(stderr, "  %-24s %-16s failed by %ld\n", eligibility_rules[k].name, check_names[eligibility_rules[k].check], rule_failures[k]);
+    }
+}
+
+/* Evaluate every student of a marks file, or of the store when in_path is NULL */
+int run_eligibility(const char *in_path, const char *out_path) {
+    long rule_failures[MAX_RULES] = { 0 };
+    long students = 0, eligible = 0;
+    if (!in_path) {
+        if (!student_store.is_open) {
+            fprintf(stderr, "--eligibility without a marks file evaluates the student store: add --store DIR.\n");
+            return 1;
+        }
+        FILE *out = out_path ? fopen(out_path, "w") : stdout;
+        if (!out) { perror(out_path); return 1; }
+        fprintf(out, "student_id,branch,eligible,failed_rules\n");
+        double t0 = bench_now();
+        for (int k = 0; k < student_store.cohort.count; k++) {
+            const StudentRecord *st = &student_store.cohort.students[k];
+            unsigned long long failed = eligibility_failures(st);
+            eligibility_write_row(out, st->reg_no, st->branch, failed, rule_failures);
+            eligible += failed == 0;
+            students++;
+        }
+        int ok = fflush(out) == 0;
+        if (!ok) perror(out_path ? out_path : "stdout");
+        eligibility_summary(students, eligible, rule_failures, bench_now() - t0);
+        if (out != stdout) fclose(out);
+        return ok ? 0 : 1;
+    }
+
+    BatchInput in;
+    if (!batch_input_open(&in, in_path)) return 1;
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); batch_input_close(&in); return 1; }
+    BatchContext bc;
+    if (!report_context_init(&bc)) {
+        fprintf(stderr, "Out of memory.\n");
+        batch_input_close(&in);
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+    fprintf(out, "student_id,branch,eligible,failed_rules\n");
+    /* a student's rows are complete once the next student starts; their result is kept until then */
+    char last_id[32] = "";
+    int last_branch = -1;
+    unsigned long long last_failed = 0;
+    long line_no = 0;
+    const char *row;
+    size_t len;
+    int got;
+    double t0 = bench_now();
+    while ((got = batch_input_next(&in, &row, &len, ++line_no, &bc, batch_err())) != 0) {
+        int sem;
+        StudentRecord *st = got > 0 ? batch_grade_row(&bc, row, len, line_no, batch_err(), &sem) : NULL;
+        if (!st) continue;
+        if (last_branch >= 0 && (last_branch != bc.current_branch || strcmp(last_id, bc.current_id) != 0)) {
+            eligibility_write_row(out, last_id, last_branch, last_failed, rule_failures);
+            eligible += last_failed == 0;
+            students++;
+        }
+        strcpy(last_id, bc.current_id);
+        last_branch = bc.current_branch;
+        last_failed = eligibility_failures(st);
+    }
+    if (last_branch >= 0) {
+        eligibility_write_row(out, last_id, last_branch, last_failed, rule_failures);
+        eligible += last_failed == 0;
+        students++;
+    }
+    int ok = fflush(out) == 0;
+    if (!ok) perror(out_path ? out_path : "stdout");
+    eligibility_summary(students, eligible, rule_failures, bench_now() - t0);
+    batch_context_free(&bc);
+    batch_input_close(&in);
+    if (out != stdout) fclose(out);
+    return !ok ? 1 : bc.rejected > 0 ? 2 : 0;
+}
+
+/* ===========================
+   Exact GPA check (--verify-gpa FILE [-o OUT]): grades a marks file and checks every SGPA and
+   CGPA the engine prints against a reference recomputed from the row's marks alone: credit-points
+   summed per semester straight from the grading tables (no running totals), then divided by
+   long division with the remainder deciding the last digit. OUT lists the values the old float
+   path ("%.2f" of a float quotient) printed differently:  student_id,semester,field,exact,float
+   Exit status 2 if the engine disagrees with the reference anywhere.
+   =========================== */
+
+/* Credit-points and GPA credits of one graded semester, from its marks */
+static void reference_semester(const StudentRecord *st, int s, long long *points, long long *credits) {
+    const Semester *syl = &all_branches[st->branch].semesters[s];
+    const GradingScheme *g = SEMESTER_SCHEME(syl);
+    const unsigned char *marks = STUDENT_MARKS(st, s);
+    for (int i = 0; i < syl->num_subjects; i++) {
+        const Subject *sub = &syl->subjects[i];
+        if (sub->is_passfail || sub->credits <= 0) continue;
+        *points += (long long)g->grade_point[marks[i]] * sub->credits;
+        *credits += sub->credits;
+    }
+}
+
+/* points / credits to two decimals: two long-division digits, then half up on the remainder */
+static int reference_x100(long long points, long long credits) {
+    if (credits <= 0) return 0;
+    long long x = points / credits, rem = points % credits;
+    for (int d = 0; d < 2; d++) {
+        x = x * 10 + rem * 10 / credits;
+        rem = rem * 10 % credits;
+    }
+    return (int)(2 * rem >= credits ? x + 1 : x);
+}
+
+/* Compare one printed value with the reference and with what the float path printed */
+static int verify_value(FILE *out, const char *id, int sem, const char *field, int engine, long long points, long long credits, long *float_diffs) {
+    char exact[GPA_TEXT_MAX], approx[32];
+    int ref = reference_x100(points, credits);
+    gpa_text(exact, ref);
+    snprintf(approx, sizeof approx, "%.2f", credits ? (float)points / (float)credits : 0.0f);
+    if (strcmp(exact, approx) != 0) {
+        fprintf(out, "%s,%d,%s,%s,%s\n", id, sem, field, exact, approx);
+        (*float_diffs)++;
+    }
+    if (engine == ref) return 1;
+    char got[GPA_TEXT_MAX];
+    gpa_text(got, engine);
+    fprintf(stderr, "%s S%d %s: engine %s, reference %s\n", id, sem, field, got, exact);
+    return 0;
+}
+
+int run_verify_gpa(const char *in_path, const char *out_path) {
+    BatchInput in;
+    if (!batch_input_open(&in, in_path)) return 1;
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); batch_input_close(&in); return 1; }
+    BatchContext bc;
+    if (!report_context_init(&bc)) {
+        fprintf(stderr, "Out of memory.\n");
+        batch_input_close(&in);
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+    fprintf(out, "student_id,semester,field,exact,float\n");
+    long line_no = 0, mismatches = 0, float_diffs = 0;
+    const char *row;
+    size_t len;
+    int got;
+    while ((got = batch_input_next(&in, &row, &len, ++line_no, &bc, batch_err())) != 0) {
+        int sem;
+        StudentRecord *st = got > 0 ? batch_grade_row(&bc, row, len, line_no, batch_err(), &sem) : NULL;
+        if (!st) continue;
+        const Branch *br = &all_branches[st->branch];
+        long long sem_points = 0, sem_credits = 0, points = 0, credits = 0;
+        reference_semester(st, sem, &sem_points, &sem_credits);
+        for (int s = 0; s < br->num_semesters; s++) {
+            if (st->sems[s].is_completed) reference_semester(st, s, &points, &credits);
+        }
+        int n = br->semesters[sem].sem_number;
+        mismatches += !verify_value(out, bc.current_id, n, "sgpa", SGPA_X100(&st->sems[sem]), sem_points, sem_credits, &float_diffs);
+        mismatches += !verify_value(out, bc.current_id, n, "cgpa", CGPA_X100(st), points, credits, &float_diffs);
+    }
+    int ok = fflush(out) == 0;
+    if (!ok) perror(out_path ? out_path : "stdout");
+    fprintf(stderr, "GPA check: %ld row(s), %ld value(s) off the exact reference; the float path printed %ld value(s) differently (%ld rejected).\n",
+            bc.graded, mismatches, float_diffs, bc.rejected);
+    batch_context_free(&bc);
+    batch_input_close(&in);
+    if (out != stdout) fclose(out);
+    return !ok ? 1 : mismatches > 0 || bc.rejected > 0 ? 2 : 0;
+}
+
+/* ===========================
+   Result archive (--archive FILE -o ARCH, --archive-scan ARCH): graded results of a marks
+   file kept compactly for years and read back by streaming column scans.
+     - the syllabus image the results were graded against is embedded as-is, so names and
+       codes are stored once in its interned string table and old archives stay readable
+       after the syllabus changes;
+     - rows are cut into groups of up to ARCHIVE_GROUP_ROWS rows of one branch/semester,
+       stored column by column: student (delta from the previous row), activity points,
+       then marks and grade point code of each subject;
+     - every column is frame-of-reference bit-packed: its minimum, then each value minus the
+       minimum in just enough bits for the column's range (marks fit 7 bits, grade point
+       codes 4, a P/F column 1);
+     - a grade point column that is exactly its scheme applied to the marks (the usual case)
+       is stored as that scheme's 101 4-bit codes instead, and rebuilt by lookup on scan.
+     - register numbers follow the groups once, front-coded against the previous one.
+   Packed words are read as little-endian 64-bit loads, like the other native-endian files.
+   =========================== */
+#define ARCHIVE_MAGIC "MBARC03"       /* 02: columns padded by a full 8 bytes, 03: 16-bit column count */
+#define ARCHIVE_GROUP_ROWS 16384
+#define ARCHIVE_GROUP_TAG 0x50524741u       /* "AGRP" */
+#define ARCHIVE_END_TAG 0x444E4541u         /* "AEND" */
+#define ARCHIVE_GP_PF_PASS 11               /* grade point codes: 0-10, then P/F pass/fail */
+#define ARCHIVE_GP_PF_FAIL 12
+#define ARCHIVE_MARKS_NOT_ENTERED 127
+#define ARCHIVE_MAX_SUBJECTS ((USHRT_MAX - 2) / 2)     /* per semester, for num_columns */
+
+typedef struct {
+    char magic[8];
+    unsigned int syllabus_size;     // bytes of the syllabus image that follows
+    unsigned int reserved;
+} ArchiveHeader;
+
+typedef struct {
+    unsigned int tag;               // ARCHIVE_GROUP_TAG, or ARCHIVE_END_TAG before the student table
+    unsigned int rows;              // rows in the group / students in the table
+    unsigned int bytes;             // payload bytes that follow
+    unsigned short branch;
+    unsigned short num_columns;     // 2 + 2 * subjects
+    unsigned char sem_index;
+    unsigned char reserved[3];
+    unsigned int first_student;     // ordinal of the first row's student
+} ArchiveGroupHeader;
+
+typedef struct {
+    unsigned int base;              // column minimum
+    unsigned char width;            // bits per value, 0 if every value equals base
+    unsigned char encoding;         // ARCHIVE_PACKED, or ARCHIVE_BY_MARKS for grade point codes
+    unsigned char reserved[2];
+    /* followed by ARCHIVE_PACKED_BYTES(rows, width) bytes; ARCHIVE_BY_MARKS: (101, 4) */
+} ArchiveColumn;
+
+#define ARCHIVE_PACKED 0
+#define ARCHIVE_BY_MARKS 1
+
+/* packed bits rounded up to 8 bytes, plus 8 bytes of padding: the decoder loads 64 bits from the
+   byte holding a value's first bit, which for the last value can reach 7 bytes past the packed data */
+#define ARCHIVE_PACKED_BYTES(rows, width) (((((size_t)(rows) * (width) + 7) / 8 + 7) & ~(size_t)7) + 8)
+
+/* One branch/semester row group being filled */
+typedef struct {
+    int rows;
+    unsigned int *student;          // [ARCHIVE_GROUP_ROWS] student ordinal
+    unsigned int *values;           // [num_columns - 1][ARCHIVE_GROUP_ROWS] activity, then marks, grade code per subject
+} ArchiveGroup;
+
+typedef struct {
+    OutBuf ob;
+    ArchiveGroup **groups;          // [branch][semester], allocated on first row
+    unsigned int *column;           // scratch for one column
+    OutBuf students;                // front-coded register numbers and branches
+    char last_id[32];               // student of the previous row
+    int last_branch;
+    unsigned int num_students;
+    long rows;
+} ArchiveWriter;
+
+static int archive_bits(unsigned int range) {
+    int w = 0;
+    while (range) { w++; range >>= 1; }
+    return w;
+}
+
+static void archive_put_packed(OutBuf *ob, int encoding, unsigned int base, int width, const unsigned int *v, int n) {
+    ArchiveColumn c;
+    memset(&c, 0, sizeof c);
+    c.base = base;
+    c.width = (unsigned char)width;
+    c.encoding = (unsigned char)encoding;
+    size_t bytes = ARCHIVE_PACKED_BYTES(n, width);
+    ob_put(ob, (const char *)&c, sizeof c);
+    if (!ob_reserve(ob, bytes)) return;
+    unsigned char *p = (unsigned char *)ob->data + ob->len;
+    memset(p, 0, bytes);
+    unsigned long long acc = 0;
+    int bits = 0;
+    for (int i = 0; i < n; i++) {
+        acc |= (unsigned long long)(v[i] - base) << bits;
+        bits += width;
+        while (bits >= 8) { *p++ = (unsigned char)acc; acc >>= 8; bits -= 8; }
+    }
+    if (bits) *p = (unsigned char)acc;
+    ob->len += bytes;
+}
+
+static void archive_put_column(OutBuf *ob, const unsigned int *v, int n) {
+    unsigned int lo = UINT_MAX, hi = 0;
+    for (int i = 0; i < n; i++) {
+        if (v[i] < lo) lo = v[i];
+        if (v[i] > hi) hi = v[i];
+    }
+    if (n == 0) lo = 0;
+    archive_put_packed(ob, ARCHIVE_PACKED, lo, archive_bits(hi - lo), v, n);
+}
+
+/* Grade point code the semester's scheme gives these marks */
+static unsigned int archive_grade_code(const Semester *syl, int subject_index, int marks) {
+    const GradingScheme *g = SEMESTER_SCHEME(syl);
+    if (syl->subjects[subject_index].is_passfail) return marks >= g->pf_pass ? ARCHIVE_GP_PF_PASS : ARCHIVE_GP_PF_FAIL;
+    return (unsigned int)g->grade_point[marks];
+}
+
+/* A grade code column: the scheme's code table when every row follows it, else the codes themselves */
+static void archive_put_grades(OutBuf *ob, const Semester *syl, int subject_index, const unsigned int *codes, const unsigned int *marks, int n) {
+    unsigned int table[101];
+    for (int m = 0; m <= 100; m++) table[m] = archive_grade_code(syl, subject_index, m);
+    int i = 0;
+    while (i < n && marks[i] <= 100 && codes[i] == table[marks[i]]) i++;
+    if (i == n) archive_put_packed(ob, ARCHIVE_BY_MARKS, 0, 4, table, 101);
+    else archive_put_column(ob, codes, n);
+}
+
+static int archive_flush_group(ArchiveWriter *aw, int branch, int sem_index) {
+    ArchiveGroup *g = aw->groups[branch] + sem_index;
+    if (g->rows == 0) return 1;
+    int num_subjects = all_branches[branch].semesters[sem_index].num_subjects;
+    ArchiveGroupHeader h;
+    memset(&h, 0, sizeof h);
+    h.tag = ARCHIVE_GROUP_TAG;
+    h.rows = (unsigned int)g->rows;
+    h.branch = (unsigned short)branch;
+    h.sem_index = (unsigned char)sem_index;
+    h.num_columns = (unsigned short)(2 + 2 * num_subjects);
+    h.first_student = g->student[0];
+    size_t at = aw->ob.len;
+    ob_put(&aw->ob, (const char *)&h, sizeof h);
+
+    unsigned int prev = g->student[0];
+    for (int r = 0; r < g->rows; r++) { aw->column[r] = g->student[r] - prev; prev = g->student[r]; }
+    archive_put_column(&aw->ob, aw->column, g->rows);
+    archive_put_column(&aw->ob, g->values, g->rows);
+    for (int i = 0; i < num_subjects; i++) {
+        const unsigned int *marks = g->values + (size_t)(1 + 2 * i) * ARCHIVE_GROUP_ROWS;
+        archive_put_column(&aw->ob, marks, g->rows);
+        archive_put_grades(&aw->ob, &all_branches[branch].semesters[sem_index], i, marks + ARCHIVE_GROUP_ROWS, marks, g->rows);
+    }
+    if (aw->ob.failed) return 0;
+
+    h.bytes = (unsigned int)(aw->ob.len - at - sizeof h);
+    memcpy(aw->ob.data + at, &h, sizeof h);
+    g->rows = 0;
+    return ob_flush(&aw->ob);
+}
+
+/* Append one graded row of the current (last added) student */
+static int archive_add_row(ArchiveWriter *aw, const StudentRecord *st, int sem_index) {
+    const Semester *syl = &all_branches[st->branch].semesters[sem_index];
+    if (!aw->groups[st->branch]) {
+        aw->groups[st->branch] = calloc((size_t)all_branches[st->branch].num_semesters, sizeof(ArchiveGroup));
+        if (!aw->groups[st->branch]) return 0;
+    }
+    ArchiveGroup *g = aw->groups[st->branch] + sem_index;
+    if (!g->student) {
+        g->student = malloc(ARCHIVE_GROUP_ROWS * sizeof *g->student);
+        g->values = malloc((size_t)(1 + 2 * syl->num_subjects) * ARCHIVE_GROUP_ROWS * sizeof *g->values);
+        if (!g->student || !g->values) return 0;
+    }
+    const unsigned char *marks = STUDENT_MARKS(st, sem_index);
+    const signed char *gp = STUDENT_GP(st, sem_index);
+    unsigned int *v = g->values + g->rows;
+    g->student[g->rows] = aw->num_students - 1;
+    v[0] = st->sems[sem_index].activity_points;
+    for (int i = 0; i < syl->num_subjects; i++) {
+        v[(size_t)(1 + 2 * i) * ARCHIVE_GROUP_ROWS] = marks[i] == MARKS_NOT_ENTERED ? ARCHIVE_MARKS_NOT_ENTERED : marks[i];
+        v[(size_t)(2 + 2 * i) * ARCHIVE_GROUP_ROWS] =
+            gp[i] == GP_PF_PASS ? ARCHIVE_GP_PF_PASS : gp[i] == GP_PF_FAIL ? ARCHIVE_GP_PF_FAIL : (unsigned int)gp[i];
+    }
+    aw->rows++;
+    if (++g->rows == ARCHIVE_GROUP_ROWS) return archive_flush_group(aw, st->branch, sem_index);
+    return 1;
+}
+
+/* Start the next student: register number front-coded against the previous one, then the branch */
+static void archive_add_student(ArchiveWriter *aw, const char *reg_no, int branch) {
+    size_t shared = 0, len = strlen(reg_no);
+    while (aw->last_id[shared] && aw->last_id[shared] == reg_no[shared]) shared++;
+    unsigned char head[3] = { (unsigned char)shared, (unsigned char)(len - shared), (unsigned char)branch };
+    ob_put(&aw->students, (const char *)head, sizeof head);
+    ob_put(&aw->students, reg_no + shared, len - shared);
+    snprintf(aw->last_id, sizeof aw->last_id, "%s", reg_no);
+    aw->last_branch = branch;
+    aw->num_students++;
+}
+
+int run_archive_write(const char *in_path, const char *out_path) {
+    if (!out_path) { fprintf(stderr, "--archive needs -o ARCHIVE\n"); return 1; }
+    for (int b = 0; b < num_branches; b++) {
+        for (int s = 0; s < all_branches[b].num_semesters; s++) {
+            if (all_branches[b].semesters[s].num_subjects <= ARCHIVE_MAX_SUBJECTS) continue;
+            fprintf(stderr, "--archive: %s S%d has more than %d subjects, which an archive cannot hold\n",
+                    all_branches[b].code, all_branches[b].semesters[s].sem_number, ARCHIVE_MAX_SUBJECTS);
+            return 1;
+        }
+    }
+    BatchInput in;
+    if (!batch_input_open(&in, in_path)) return 1;
+    FILE *out = fopen(out_path, "wb");
+    if (!out) { perror(out_path); batch_input_close(&in); return 1; }
+
+    ArchiveWriter aw;
+    BatchContext bc;
+    memset(&aw, 0, sizeof aw);
+    aw.ob.file = out;
+    aw.groups = calloc((size_t)num_branches, sizeof *aw.groups);
+    aw.column = malloc(ARCHIVE_GROUP_ROWS * sizeof *aw.column);
+    int ctx_ok = report_context_init(&bc), ok = ctx_ok;
+    if (!ok || !aw.groups || !aw.column) {
+        fprintf(stderr, "Out of memory.\n");
+        ok = 0;
+    }
+
+    if (ok) {
+        const SyllabusHeader *sh = syllabus_image;
+        ArchiveHeader h;
+        memset(&h, 0, sizeof h);
+        memcpy(h.magic, ARCHIVE_MAGIC, sizeof h.magic);
+        h.syllabus_size = (unsigned int)(sizeof *sh + sh->num_branches * sizeof(SyllabusBranchEntry)
+                        + sh->num_subjects * sizeof(SyllabusSubjectEntry) + sh->strings_size);
+        ob_put(&aw.ob, (const char *)&h, sizeof h);
+        ob_put(&aw.ob, syllabus_image, h.syllabus_size);
+        ob_fill(&aw.ob, '\0', (int)(-(long)h.syllabus_size & 7));
+        ok = ob_flush(&aw.ob);
+    }
+
+    long line_no = 0;
+    const char *row;
+    size_t len;
+    int got;
+    while (ok && (got = batch_input_next(&in, &row, &len, ++line_no, &bc, batch_err())) != 0) {
+        int sem;
+        if (got < 0) continue;
+        StudentRecord *st = batch_grade_row(&bc, row, len, line_no, batch_err(), &sem);
+        if (!st) continue;
+        if (aw.num_students == 0 || aw.last_branch != bc.current_branch || strcmp(aw.last_id, bc.current_id) != 0) {
+            archive_add_student(&aw, bc.current_id, bc.current_branch);
+        }
+        if (!archive_add_row(&aw, st, sem)) { fprintf(stderr, "Out of memory.\n"); ok = 0; }
+    }
+    for (int b = 0; ok && b < num_branches; b++) {
+        for (int s = 0; aw.groups[b] && ok && s < all_branches[b].num_semesters; s++) ok = archive_flush_group(&aw, b, s);
+    }
+    if (ok) {
+        ArchiveGroupHeader end;
+        memset(&end, 0, sizeof end);
+        end.tag = ARCHIVE_END_TAG;
+        end.rows = aw.num_students;
+        end.bytes = (unsigned int)aw.students.len;
+        ob_put(&aw.ob, (const char *)&end, sizeof end);
+        ob_put(&aw.ob, aw.students.data ? aw.students.data : "", aw.students.len);
+        ok = ob_flush(&aw.ob) && !aw.students.failed;
+    }
+    if (fclose(out) != 0) ok = 0;
+    if (!ok) fprintf(stderr, "%s: could not write the archive\n", out_path);
+    else {
+        long bytes = 0;
+        FILE *f = fopen(out_path, "rb");
+        if (f) { fseek(f, 0, SEEK_END); bytes = ftell(f); fclose(f); }
+        fprintf(stderr, "Archived %ld row(s) of %u student(s) into %s: %ld bytes, %.2f bytes per student-semester (%ld rejected).\n",
+                aw.rows, aw.num_students, out_path, bytes, aw.rows ? (double)bytes / (double)aw.rows : 0.0, bc.rejected);
+    }
+
+    for (int b = 0; aw.groups && b < num_branches; b++) {
+        for (int s = 0; aw.groups[b] && s < all_branches[b].num_semesters; s++) {
+            free(aw.groups[b][s].student);
+            free(aw.groups[b][s].values);
+        }
+        free(aw.groups[b]);
+    }
+    free(aw.groups);
+    free(aw.column);
+    free(aw.ob.data);
+    free(aw.students.data);
+    if (ctx_ok) batch_context_free(&bc);
+    batch_input_close(&in);
+    if (!ok) return 1;
+    return bc.rejected > 0 ? 2 : 0;
+}
+
+/* Eight values of `width` bits fill exactly `width` bytes: one load, eight shifts.
+   Called with a constant width so each case compiles to straight-line code. */
+static inline int archive_unpack_blocks(const unsigned char *p, const int width, unsigned int base, int n, unsigned char *out) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8, p += width) {
+        unsigned long long w;
+        memcpy(&w, p, sizeof w);
+        for (int k = 0; k < 8; k++) out[i + k] = (unsigned char)(base + ((w >> (k * width)) & ((1u << width) - 1)));
+    }
+    return i;
+}
+
+/* Decode n values of a packed column into bytes (values must fit; see archive_open_column) */
+static void archive_unpack8(const unsigned char *p, int width, unsigned int base, int n, unsigned char *out) {
+    if (width == 0) { memset(out, (int)base, (size_t)n); return; }
+    int i = 0;
+    switch (width) {
+    case 1: i = archive_unpack_blocks(p, 1, base, n, out); break;
+    case 2: i = archive_unpack_blocks(p, 2, base, n, out); break;
+    case 3: i = archive_unpack_blocks(p, 3, base, n, out); break;
+    case 4: i = archive_unpack_blocks(p, 4, base, n, out); break;
+    case 5: i = archive_unpack_blocks(p, 5, base, n, out); break;
+    case 6: i = archive_unpack_blocks(p, 6, base, n, out); break;
+    case 7: i = archive_unpack_blocks(p, 7, base, n, out); break;
+    default: i = archive_unpack_blocks(p, 8, base, n, out); break;
+    }
+    unsigned long long mask = (1ull << width) - 1;
+    size_t bit = (size_t)i * (size_t)width;
+    for (; i < n; i++, bit += (size_t)width) {
+        unsigned long long w;
+        memcpy(&w, p + (bit >> 3), sizeof w);
+        out[i] = (unsigned char)(base + ((w >> (bit & 7)) & mask));
+    }
+}
+
+/* Count byte values, in four interleaved tables so runs of one value do not serialise on a counter */
+static void archive_histogram(const unsigned char *v, int n, long *out) {
+    static int hist[4][256];
+    memset(hist, 0, sizeof hist);
+    int r = 0;
+    for (; r + 4 <= n; r += 4) {
+        hist[0][v[r]]++;
+        hist[1][v[r + 1]]++;
+        hist[2][v[r + 2]]++;
+        hist[3][v[r + 3]]++;
+    }
+    for (; r < n; r++) hist[0][v[r]]++;
+    for (int k = 0; k < 256; k++) out[k] = (long)hist[0][k] + hist[1][k] + hist[2][k] + hist[3][k];
+}
+
+/* Check the next column of a group and step past it; NULL if it does not fit */
+static const unsigned char *archive_open_column(const char **pos, const char *end, unsigned int rows, int max_width, ArchiveColumn *c) {
+    if ((size_t)(end - *pos) < sizeof *c) return NULL;
+    memcpy(c, *pos, sizeof *c);
+    if (c->encoding == ARCHIVE_BY_MARKS) rows = 101;
+    else if (c->encoding != ARCHIVE_PACKED) return NULL;
+    size_t bytes = ARCHIVE_PACKED_BYTES(rows, c->width);
+    if (c->width > max_width || (size_t)(end - *pos) - sizeof *c < bytes) return NULL;
+    if (max_width <= 8 && c->base + ((1ull << c->width) - 1) > 255) return NULL;
+    const unsigned char *data = (const unsigned char *)*pos + sizeof *c;
+    *pos += sizeof *c + bytes;
+    return data;
+}
+
+/* Per branch/semester totals gathered by the scan */
+typedef struct {
+    RunningStats sgpa;
+    long *marks_sum;                // [num_subjects]
+    long *grade_counts;             // [num_subjects * GRADE_SLOTS], as in the analytics
+} ArchiveSemesterScan;
+
+int run_archive_scan(const char *path, const char *out_path) {
+    size_t size = 0;
+    int mapped = 0;
+    const char *data = map_file(path, &size, &mapped);
+    if (!data) { perror(path); return 1; }
+    const ArchiveHeader *h = (const ArchiveHeader *)data;
+    if (size < sizeof *h || memcmp(h->magic, ARCHIVE_MAGIC, sizeof h->magic) != 0 ||
+        size - sizeof *h < ((size_t)h->syllabus_size + 7) / 8 * 8) {
+        fprintf(stderr, "%s: not a result archive\n", path);
+        unmap_file(data, size, mapped);
+        return 1;
+    }
+    /* the archive is read against the syllabus it was written with */
+    if (!install_syllabus_image(data + sizeof *h, h->syllabus_size, path)) { unmap_file(data, size, mapped); return 1; }
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); unmap_file(data, size, mapped); return 1; }
+
+    ArchiveSemesterScan **scan = calloc((size_t)num_branches, sizeof *scan);
+    unsigned char *col = malloc(ARCHIVE_GROUP_ROWS);
+    unsigned char *gp = malloc(ARCHIVE_GROUP_ROWS);
+    int *cp = malloc(ARCHIVE_GROUP_ROWS * sizeof *cp);
+    int ok = scan && col && gp && cp;
+    for (int b = 0; ok && b < num_branches; b++) {
+        const Branch *br = &all_branches[b];
+        if (br->num_semesters == 0) continue;  /* no group can name it; scan[b] stays NULL */
+        scan[b] = calloc((size_t)br->num_semesters, sizeof **scan);
+        long *sums = calloc((size_t)br->num_subjects * (1 + GRADE_SLOTS) + 1, sizeof *sums);
+        if (!scan[b] || !sums) { free(sums); ok = 0; break; }
+        for (int s = 0; s < br->num_semesters; s++) {
+            scan[b][s].marks_sum = sums + br->semesters[s].first_subject;
+            scan[b][s].grade_counts = sums + br->num_subjects + (size_t)br->semesters[s].first_subject * GRADE_SLOTS;
+        }
+    }
+    if (!ok) fprintf(stderr, "Out of memory.\n");
+
+    const char *pos = data + sizeof *h + ((size_t)h->syllabus_size + 7) / 8 * 8, *end = data + size;
+    long rows = 0, groups = 0, values = 0;
+    unsigned int students = 0;
+    double t = bench_now();
+    while (ok) {
+        ArchiveGroupHeader g;
+        if ((size_t)(end - pos) < sizeof g) { ok = 0; break; }
+        memcpy(&g, pos, sizeof g);
+        pos += sizeof g;
+        if (g.bytes > (size_t)(end - pos)) { ok = 0; break; }
+        if (g.tag == ARCHIVE_END_TAG) { students = g.rows; break; }
+        if (g.tag != ARCHIVE_GROUP_TAG || g.branch >= num_branches || g.sem_index >= all_branches[g.branch].num_semesters ||
+            g.rows == 0 || g.rows > ARCHIVE_GROUP_ROWS) { ok = 0; break; }
+        const Semester *syl = &all_branches[g.branch].semesters[g.sem_index];
+        if (g.num_columns != 2 + 2 * syl->num_subjects) { ok = 0; break; }
+        ArchiveSemesterScan *ss = &scan[g.branch][g.sem_index];
+        const char *gpos = pos, *gend = pos + g.bytes;
+        int n = (int)g.rows;
+        ArchiveColumn c;
+
+        /* students and activity points are not aggregated; step over them */
+        if (!archive_open_column(&gpos, gend, g.rows, 32, &c) || !archive_open_column(&gpos, gend, g.rows, 8, &c)) { ok = 0; break; }
+        memset(cp, 0, (size_t)n * sizeof *cp);
+        for (int i = 0; ok && i < syl->num_subjects; i++) {
+            const unsigned char *pm = archive_open_column(&gpos, gend, g.rows, 8, &c);
+            if (!pm) { ok = 0; break; }
+            archive_unpack8(pm, c.width, c.base, n, col);
+            long sum = 0;
+            for (int r = 0; r < n; r++) sum += col[r];
+            ss->marks_sum[i] += sum;
+
+            const unsigned char *pg = archive_open_column(&gpos, gend, g.rows, 4, &c);
+            if (!pg || c.base + ((1u << c.width) - 1) > 15) { ok = 0; break; }     /* 4-bit codes */
+            if (c.encoding == ARCHIVE_BY_MARKS) {
+                unsigned char table[128] = { 0 };     /* marks 101-127 only as "not entered" */
+                archive_unpack8(pg, c.width, c.base, 101, table);
+                for (int r = 0; r < n; r++) gp[r] = table[col[r] & 127];
+            } else {
+                archive_unpack8(pg, c.width, c.base, n, gp);
+            }
+            long hist[256];
+            archive_histogram(gp, n, hist);
+            long *counts = ss->grade_counts + (size_t)i * GRADE_SLOTS;
+            for (int k = 0; k < 16; k++) counts[k < GRADE_SLOTS ? k : GRADE_SLOTS - 1] += hist[k];
+            int weight = syl->weight[i];
+            if (weight > 0) {
+                for (int r = 0; r < n; r++) cp[r] += gp[r] * weight;
+            }
+        }
+        if (!ok) break;
+        /* SGPA = cp / gpa_credits: exact integer sums per group, merged into the running statistics */
+        long long sum = 0, sum_sq = 0;
+        for (int r = 0; r < n; r++) { sum += cp[r]; sum_sq += (long long)cp[r] * cp[r]; }
+        double scale = syl->gpa_credits > 0 ? 1.0 / syl->gpa_credits : 0.0;
+        stats_merge(&ss->sgpa, n, (double)sum / n * scale, ((double)sum_sq - (double)sum * (double)sum / n) * scale * scale);
+        pos = gend;
+        rows += n;
+        values += (long)n * 2 * syl->num_subjects;
+        groups++;
+    }
+    t = bench_now() - t;
+    if (!ok && scan && col && gp && cp) fprintf(stderr, "%s: corrupt archive (group %ld)\n", path, groups + 1);
+
+    if (ok) {
+        fprintf(out, "============================================================\n");
+        fprintf(out, "   ARCHIVE SCAN: %s\n", path);
+        fprintf(out, "============================================================\n");
+        fprintf(out, "Students: %u   Rows: %ld   Row groups: %ld\n", students, rows, groups);
+        for (int b = 0; b < num_branches; b++) {
+            const Branch *br = &all_branches[b];
+            for (int s = 0; s < br->num_semesters; s++) {
+                const ArchiveSemesterScan *ss = &scan[b][s];
+                const Semester *syl = &br->semesters[s];
+                if (ss->sgpa.n == 0) continue;
+                fprintf(out, "\n--- %s S%d: %ld row(s), SGPA mean %.2f  stddev %.2f ---\n", br->code, syl->sem_number,
+                        ss->sgpa.n, ss->sgpa.mean, stats_stddev(&ss->sgpa));
+                for (int i = 0; i < syl->num_subjects; i++) {
+                    const long *c = ss->grade_counts + (size_t)i * GRADE_SLOTS;
+                    fprintf(out, "  %-28.28s marks %6.2f |", syl->subjects[i].name, (double)ss->marks_sum[i] / (double)ss->sgpa.n);
+                    if (syl->subjects[i].is_passfail) {
+                        fprintf(out, " pass:%ld fail:%ld\n", c[11], c[12]);
+                        continue;
+                    }
+                    for (int k = 10; k >= 0; k--) if (c[k]) fprintf(out, " %d:%ld", k, c[k]);
+                    fprintf(out, "\n");
+                }
+            }
+        }
+        fprintf(stderr, "Scanned %ld row(s) in %ld group(s): %.1f M values decoded in %.2f ms (%.2f GB/s of decoded bytes).\n",
+                rows, groups, values / 1e6, t * 1e3, t > 0 ? values / t / 1e9 : 0.0);
+    }
+
+    for (int b = 0; scan && b < num_branches; b++) {
+        if (scan[b]) free(scan[b][0].marks_sum);   /* the branch's sums block; set only with semesters */
+        free(scan[b]);
+    }
+    free(scan);
+    free(col);
+    free(gp);
+    free(cp);
+    if (out != stdout) fclose(out);
+    unmap_file(data, size, mapped);
+    return ok ? 0 : 1;
+}
+
+/* ===========================
+   Parquet export (--export FILE, with --store DIR): one row per graded subject of every stored
+   student, in a file analytics tools read directly (pyarrow, pandas, DuckDB, Spark):
+     student_id, branch, subject     string
+     semester, credits               int32
+     marks, grade_point              int32; grade_point is null for P/F subjects
+     sgpa, cgpa                      decimal(4,2), exactly as printed (SGPA_X100 / CGPA_X100)
+     activity_points, pf_failed      int32 / boolean, of the row's semester
+   cgpa is the student's current CGPA. Rows leave in row groups of EXPORT_GROUP_ROWS, so the
+   buffers stay the same size for any cohort. Each column chunk is a PLAIN dictionary page and
+   one data page of RLE / bit-packed dictionary indices. Subject names are deduplicated through
+   the syllabus' interned strings and branch codes are the branch table; an integer column's
+   dictionary is 0 .. its largest value in the group, so the index is the value itself, and the
+   per-semester columns collapse into runs. Pages are uncompressed. The footer is Thrift compact protocol.
+   =========================== */
+#define EXPORT_GROUP_ROWS (1 << 19)
+#define EXPORT_NULL UINT_MAX                /* value of a null cell in a row group column */
+#define EXPORT_CREATED_BY "mbcet_cgpa_final"
+
+/* Parquet physical types, encodings and page types (parquet.thrift) */
+#define PQ_BOOLEAN 0
+#define PQ_INT32 1
+#define PQ_BYTE_ARRAY 6
+#define PQ_UTF8 0                           /* converted types */
+#define PQ_DECIMAL 5
+#define PQ_PLAIN 0
+#define PQ_RLE 3
+#define PQ_RLE_DICTIONARY 8
+#define PQ_DATA_PAGE 0
+#define PQ_DICTIONARY_PAGE 2
+
+/* Thrift compact protocol field types */
+#define TC_I32 5
+#define TC_I64 6
+#define TC_BINARY 8
+#define TC_LIST 9
+#define TC_STRUCT 12
+
+enum {
+    EXPORT_STUDENT, EXPORT_BRANCH, EXPORT_SEMESTER, EXPORT_SUBJECT, EXPORT_CREDITS, EXPORT_MARKS,
+    EXPORT_GRADE_POINT, EXPORT_SGPA, EXPORT_CGPA, EXPORT_ACTIVITY, EXPORT_PF_FAILED, EXPORT_COLUMNS
+};
+
+typedef struct {
+    const char *name;
+    int type;                       // PQ_*
+    int converted;                  // PQ_UTF8, PQ_DECIMAL, or -1
+    int optional;
+} ExportColumnSpec;
+
+static const ExportColumnSpec export_columns[EXPORT_COLUMNS] = {
+    { "student_id",      PQ_BYTE_ARRAY, PQ_UTF8,    0 },
+    { "branch",          PQ_BYTE_ARRAY, PQ_UTF8,    0 },
+    { "semester",        PQ_INT32,      -1,         0 },
+    { "subject",         PQ_BYTE_ARRAY, PQ_UTF8,    0 },
+    { "credits",         PQ_INT32,      -1,         0 },
+    { "marks",           PQ_INT32,      -1,         1 },
+    { "grade_point",     PQ_INT32,      -1,         1 },
+    { "sgpa",            PQ_INT32,      PQ_DECIMAL, 0 },
+    { "cgpa",            PQ_INT32,      PQ_DECIMAL, 0 },
+    { "activity_points", PQ_INT32,      -1,         0 },
+    { "pf_failed",       PQ_BOOLEAN,    -1,         0 },
+};
+
+/* Where one column chunk landed in the file */
+typedef struct {
+    long long dictionary_offset;    // -1 for a column without dictionary
+    long long data_offset;
+    long long bytes;                // both pages, headers included
+} ExportChunk;
+
+typedef struct {
+    OutBuf ob;                      // file bytes not yet written
+    long long offset;               // file offset of ob.data[0]
+    OutBuf page;                    // body of the page being built
+    unsigned int *values[EXPORT_COLUMNS];   // [EXPORT_GROUP_ROWS] of the row group being filled
+    unsigned int *packed;           // [EXPORT_GROUP_ROWS] non-null values of one column
+    int rows;
+    const char **students;          // [EXPORT_GROUP_ROWS] student dictionary of the row group
+    int num_students;
+    const StudentRecord *last_student;
+    int **subject_code;             // [branch][subject] -> subject dictionary index
+    const char **subjects;          // subject dictionary: distinct names
+    int num_subjects;
+    ExportChunk *chunks;            // [row group][EXPORT_COLUMNS]
+    int *group_rows;
+    int num_groups, cap_groups;
+    long long total_rows;
+} ExportWriter;
+
+static long long export_tell(const ExportWriter *ew) {
+    return ew->offset + (long long)ew->ob.len;
+}
+
+static int export_flush(ExportWriter *ew) {
+    long long len = (long long)ew->ob.len;
+    if (!ob_flush(&ew->ob)) return 0;
+    ew->offset += len;
+    return 1;
+}
+
+static void export_le32(char *p, unsigned int v) {
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+    p[2] = (char)(v >> 16);
+    p[3] = (char)(v >> 24);
+}
+
+static void export_put_u32(OutBuf *ob, unsigned int v) {
+    char le[4];
+    export_le32(le, v);
+    ob_put(ob, le, 4);
+}
+
+/* ---- Thrift compact protocol: fields carry their id as a delta from the previous one ---- */
+static void tc_varint(OutBuf *ob, unsigned long long v) {
+    char buf[10];
+    int n = 0;
+    while (v >= 0x80) { buf[n++] = (char)(v | 0x80); v >>= 7; }
+    buf[n++] = (char)v;
+    ob_put(ob, buf, (size_t)n);
+}
+
+static void tc_field(OutBuf *ob, int *last_id, int id, int type) {
+    char c = (char)((id - *last_id) << 4 | type);       /* ids only ever grow by 1-15 here */
+    ob_put(ob, &c, 1);
+    *last_id = id;
+}
+
+static void tc_i64(OutBuf *ob, int *last_id, int id, long long v) {
+    tc_field(ob, last_id, id, TC_I64);
+    tc_varint(ob, ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63));
+}
+
+static void tc_i32(OutBuf *ob, int *last_id, int id, int v) {
+    tc_field(ob, last_id, id, TC_I32);
+    tc_varint(ob, ((unsigned long long)(unsigned int)v << 1) ^ (unsigned long long)(long long)(v >> 31));
+}
+
+static void tc_string(OutBuf *ob, int *last_id, int id, const char *s) {
+    size_t n = strlen(s);
+    tc_field(ob, last_id, id, TC_BINARY);
+    tc_varint(ob, n);
+    ob_put(ob, s, n);
+}
+
+static void tc_list(OutBuf *ob, int *last_id, int id, int elem_type, int n) {
+    tc_field(ob, last_id, id, TC_LIST);
+    if (n < 15) {
+        char c = (char)(n << 4 | elem_type);
+        ob_put(ob, &c, 1);
+    } else {
+        char c = (char)(0xF0 | elem_type);
+        ob_put(ob, &c, 1);
+        tc_varint(ob, (unsigned long long)n);
+    }
+}
+
+static void tc_stop(OutBuf *ob) {
+    ob_put(ob, "", 1);
+}
+
+/* ---- RLE / bit-packed hybrid: a run of equal values as (count, value) where that is smaller
+   than packing it, everything else bit-packed 8 values at a time ---- */
+static int export_run(const unsigned int *v, int from, int n) {
+    int to = from + 1;
+    while (to < n && v[to] == v[from]) to++;
+    return to - from;
+}
+
+static void export_hybrid(OutBuf *ob, const unsigned int *v, int n, int width) {
+    int value_bytes = (width + 7) / 8;
+    int rle_bits = 8 * (value_bytes + 1);   /* a short run's header and value */
+    int i = 0;
+    while (i < n) {
+        int run = export_run(v, i, n);
+        if (run >= 8 || run * width > rle_bits) {
+            char le[4];
+            export_le32(le, v[i]);
+            tc_varint(ob, (unsigned long long)run << 1);
+            ob_put(ob, le, (size_t)value_bytes);
+            i += run;
+            continue;
+        }
+        /* whole groups of 8 until a run worth encoding starts; the last group is zero-padded */
+        int end = i + 8;
+        while (end < n && (run = export_run(v, end, n)) < 8 && run * width <= rle_bits) end += 8;
+        int groups = (end - i) / 8;
+        tc_varint(ob, (unsigned long long)groups << 1 | 1);
+        if (!ob_reserve(ob, (size_t)groups * (size_t)width + 8)) return;
+        unsigned char *out = (unsigned char *)ob->data + ob->len;
+        unsigned long long acc = 0;
+        int bits = 0;
+        for (int k = i; k < end; k++) {
+            acc |= (unsigned long long)(k < n ? v[k] : 0) << bits;
+            for (bits += width; bits >= 8; bits -= 8, acc >>= 8) *out++ = (unsigned char)acc;
+        }
+        ob->len += (size_t)groups * (size_t)width;
+        i = end;
+    }
+}
+
+static int export_width(unsigned int dictionary_size) {
+    int w = 1;
+    while (w < 32 && (1u << w) < dictionary_size) w++;
+    return w;
+}
+
+/* Page header, then the body built in ew->page */
+static void export_page(ExportWriter *ew, int page_type, int num_values, int encoding) {
+    OutBuf *ob = &ew->ob;
+    int last = 0, sub = 0;
+    tc_i32(ob, &last, 1, page_type);
+    tc_i32(ob, &last, 2, (int)ew->page.len);
+    tc_i32(ob, &last, 3, (int)ew->page.len);
+    if (page_type == PQ_DATA_PAGE) {
+        tc_field(ob, &last, 5, TC_STRUCT);
+        tc_i32(ob, &sub, 1, num_values);
+        tc_i32(ob, &sub, 2, encoding);
+        tc_i32(ob, &sub, 3, PQ_RLE);        /* definition levels */
+        tc_i32(ob, &sub, 4, PQ_RLE);        /* repetition levels (none: the schema is flat) */
+    } else {
+        tc_field(ob, &last, 7, TC_STRUCT);
+        tc_i32(ob, &sub, 1, num_values);
+        tc_i32(ob, &sub, 2, encoding);
+    }
+    tc_stop(ob);
+    tc_stop(ob);
+    ob_put(ob, ew->page.data ? ew->page.data : "", ew->page.len);
+    ew->page.len = 0;
+}
+
+/* One column chunk of the current row group */
+static void export_column(ExportWriter *ew, int c, ExportChunk *chunk) {
+    const ExportColumnSpec *spec = &export_columns[c];
+    const unsigned int *v = ew->values[c];
+    int n = ew->rows;
+    OutBuf *page = &ew->page;
+    long long start = export_tell(ew);
+
+    if (spec->type == PQ_BOOLEAN) {
+        chunk->dictionary_offset = -1;
+        chunk->data_offset = start;
+        for (int i = 0; i < n; i += 8) {
+            char byte = 0;
+            for (int k = i; k < i + 8 && k < n; k++) byte |= (char)((v[k] & 1) << (k - i));
+            ob_put(page, &byte, 1);
+        }
+        export_page(ew, PQ_DATA_PAGE, n, PQ_PLAIN);
+        chunk->bytes = export_tell(ew) - start;
+        return;
+    }
+
+    /* dictionary page */
+    unsigned int dictionary_size;
+    chunk->dictionary_offset = start;
+    if (spec->type == PQ_BYTE_ARRAY) {
+        const char **strings = c == EXPORT_STUDENT ? ew->students : ew->subjects;
+        dictionary_size = (unsigned int)(c == EXPORT_STUDENT ? ew->num_students : c == EXPORT_SUBJECT ? ew->num_subjects : num_branches);
+        for (unsigned int k = 0; k < dictionary_size; k++) {
+            const char *s = c == EXPORT_BRANCH ? all_branches[k].code : strings[k];
+            unsigned int len = (unsigned int)strlen(s);
+            export_put_u32(page, len);
+            ob_put(page, s, len);
+        }
+    } else {
+        unsigned int max = 0;
+        for (int i = 0; i < n; i++) {
+            if (v[i] != EXPORT_NULL && v[i] > max) max = v[i];
+        }
+        dictionary_size = max + 1;
+        for (unsigned int k = 0; k < dictionary_size; k++) export_put_u32(page, k);
+    }
+    export_page(ew, PQ_DICTIONARY_PAGE, (int)dictionary_size, PQ_PLAIN);
+
+    /* data page: definition levels (nullable columns only), then the indices of the non-null values */
+    chunk->data_offset = export_tell(ew);
+    const unsigned int *present = v;
+    int num_present = n;
+    if (spec->optional) {
+        unsigned int *defined = ew->packed;
+        for (int i = 0; i < n; i++) defined[i] = v[i] != EXPORT_NULL;
+        size_t at = page->len;
+        export_put_u32(page, 0);            /* byte length of the levels, filled in below */
+        export_hybrid(page, defined, n, 1);
+        if (!page->failed) export_le32(page->data + at, (unsigned int)(page->len - at - 4));
+        num_present = 0;
+        for (int i = 0; i < n; i++) {
+            if (v[i] != EXPORT_NULL) defined[num_present++] = v[i];
+        }
+        present = defined;
+    }
+    char width = (char)export_width(dictionary_size);
+    ob_put(page, &width, 1);
+    export_hybrid(page, present, num_present, width);
+    export_page(ew, PQ_DATA_PAGE, n, PQ_RLE_DICTIONARY);
+    chunk->bytes = export_tell(ew) - start;
+}
+
+/* Write out the filled row group and start the next one */
+static int export_flush_group(ExportWriter *ew) {
+    if (ew->rows == 0) return 1;
+    if (ew->num_groups == ew->cap_groups) {
+        int cap = ew->cap_groups ? ew->cap_groups * 2 : 16;
+        ExportChunk *chunks = realloc(ew->chunks, (size_t)cap * EXPORT_COLUMNS * sizeof *chunks);
+        if (chunks) ew->chunks = chunks;
+        int *rows = realloc(ew->group_rows, (size_t)cap * sizeof *rows);
+        if (rows) ew->group_rows = rows;
+        if (!chunks || !rows) return 0;
+        ew->cap_groups = cap;
+    }
+    ExportChunk *chunks = ew->chunks + (size_t)ew->num_groups * EXPORT_COLUMNS;
+    for (int c = 0; c < EXPORT_COLUMNS; c++) {
+        export_column(ew, c, &chunks[c]);
+        if (ew->ob.len >= OUTBUF_FLUSH_AT && !export_flush(ew)) return 0;
+    }
+    ew->group_rows[ew->num_groups++] = ew->rows;
+    ew->total_rows += ew->rows;
+    ew->rows = 0;
+    ew->num_students = 0;
+    ew->last_student = NULL;
+    return !ew->ob.failed && !ew->page.failed;
+}
+
+/* Every graded subject of one student */
+static int export_student(ExportWriter *ew, const StudentRecord *st) {
+    const Branch *br = &all_branches[st->branch];
+    unsigned int cgpa = (unsigned int)CGPA_X100(st);
+    for (int s = 0; s < br->num_semesters; s++) {
+        const SemesterResult *res = &st->sems[s];
+        if (!res->is_completed) continue;
+        const Semester *syl = &br->semesters[s];
+        const unsigned char *marks = STUDENT_MARKS(st, s);
+        const signed char *gp = STUDENT_GP(st, s);
+        unsigned int sgpa = (unsigned int)SGPA_X100(res);
+        for (int i = 0; i < syl->num_subjects; i++) {
+            if (ew->last_student != st) {
+                ew->students[ew->num_students++] = st->reg_no;
+                ew->last_student = st;
+            }
+            int r = ew->rows;
+            ew->values[EXPORT_STUDENT][r] = (unsigned int)ew->num_students - 1;
+            ew->values[EXPORT_BRANCH][r] = (unsigned int)st->branch;
+            ew->values[EXPORT_SEMESTER][r] = (unsigned int)syl->sem_number;
+            ew->values[EXPORT_SUBJECT][r] = (unsigned int)ew->subject_code[st->branch][syl->first_subject + i];
+            ew->values[EXPORT_CREDITS][r] = (unsigned int)syl->subjects[i].credits;
+            ew->values[EXPORT_MARKS][r] = marks[i] == MARKS_NOT_ENTERED ? EXPORT_NULL : marks[i];
+            ew->values[EXPORT_GRADE_POINT][r] = gp[i] < 0 || marks[i] == MARKS_NOT_ENTERED ? EXPORT_NULL : (unsigned int)gp[i];
+            ew->values[EXPORT_SGPA][r] = sgpa;
+            ew->values[EXPORT_CGPA][r] = cgpa;
+            ew->values[EXPORT_ACTIVITY][r] = res->activity_points;
+            ew->values[EXPORT_PF_FAILED][r] = res->pf_failed;
+            if (++ew->rows == EXPORT_GROUP_ROWS && !export_flush_group(ew)) return 0;
+        }
+    }
+    return 1;
+}
+
+/* Subject dictionary: one entry per distinct name (interned strings compare by address) */
+static int export_subjects(ExportWriter *ew) {
+    int total = 0;
+    for (int b = 0; b < num_branches; b++) total += all_branches[b].num_subjects;
+    ew->subject_code = calloc((size_t)num_branches + 1, sizeof *ew->subject_code);
+    ew->subjects = malloc(((size_t)total + 1) * sizeof *ew->subjects);
+    if (!ew->subject_code || !ew->subjects) return 0;
+    for (int b = 0; b < num_branches; b++) {
+        const Branch *br = &all_branches[b];
+        ew->subject_code[b] = malloc(((size_t)br->num_subjects + 1) * sizeof **ew->subject_code);
+        if (!ew->subject_code[b]) return 0;
+        for (int s = 0; s < br->num_semesters; s++) {
+            const Semester *syl = &br->semesters[s];
+            for (int i = 0; i < syl->num_subjects; i++) {
+                const char *name = syl->subjects[i].name;
+                int k = 0;
+                while (k < ew->num_subjects && ew->subjects[k] != name) k++;
+                if (k == ew->num_subjects) ew->subjects[ew->num_subjects++] = name;
+                ew->subject_code[b][syl->first_subject + i] = k;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Footer: FileMetaData with the schema and every row group's column chunks */
+static void export_footer(ExportWriter *ew) {
+    OutBuf *ob = &ew->ob;
+    int last = 0;
+    tc_i32(ob, &last, 1, 1);
+    tc_list(ob, &last, 2, TC_STRUCT, EXPORT_COLUMNS + 1);
+    {
+        int f = 0;
+        tc_string(ob, &f, 4, "schema");
+        tc_i32(ob, &f, 5, EXPORT_COLUMNS);
+        tc_stop(ob);
+    }
+    for (int c = 0; c < EXPORT_COLUMNS; c++) {
+        const ExportColumnSpec *spec = &export_columns[c];
+        int f = 0;
+        tc_i32(ob, &f, 1, spec->type);
+        tc_i32(ob, &f, 3, spec->optional);  /* FieldRepetitionType: REQUIRED 0, OPTIONAL 1 */
+        tc_string(ob, &f, 4, spec->name);
+        if (spec->converted >= 0) tc_i32(ob, &f, 6, spec->converted);
+        if (spec->converted == PQ_DECIMAL) {
+            tc_i32(ob, &f, 7, 2);           /* scale */
+            tc_i32(ob, &f, 8, 4);           /* precision */
+        }
+        tc_stop(ob);
+    }
+    tc_i64(ob, &last, 3, ew->total_rows);
+    tc_list(ob, &last, 4, TC_STRUCT, ew->num_groups);
+    for (int g = 0; g < ew->num_groups; g++) {
+        const ExportChunk *chunks = ew->chunks + (size_t)g * EXPORT_COLUMNS;
+        long long group_bytes = 0;
+        int rg = 0;
+        tc_list(ob, &rg, 1, TC_STRUCT, EXPORT_COLUMNS);
+        for (int c = 0; c < EXPORT_COLUMNS; c++) {
+            const ExportChunk *chunk = &chunks[c];
+            int dictionary = chunk->dictionary_offset >= 0;
+            int cc = 0, md = 0;
+            tc_i64(ob, &cc, 2, dictionary ? chunk->dictionary_offset : chunk->data_offset);
+            tc_field(ob, &cc, 3, TC_STRUCT);
+            tc_i32(ob, &md, 1, export_columns[c].type);
+            tc_list(ob, &md, 2, TC_I32, dictionary ? 3 : 2);
+            tc_varint(ob, PQ_PLAIN << 1);
+            tc_varint(ob, PQ_RLE << 1);
+            if (dictionary) tc_varint(ob, PQ_RLE_DICTIONARY << 1);
+            tc_list(ob, &md, 3, TC_BINARY, 1);
+            tc_varint(ob, strlen(export_columns[c].name));
+            ob_str(ob, export_columns[c].name);
+            tc_i32(ob, &md, 4, 0);          /* UNCOMPRESSED */
+            tc_i64(ob, &md, 5, ew->group_rows[g]);
+            tc_i64(ob, &md, 6, chunk->bytes);
+            tc_i64(ob, &md, 7, chunk->bytes);
+            tc_i64(ob, &md, 9, chunk->data_offset);
+            if (dictionary) tc_i64(ob, &md, 11, chunk->dictionary_offset);
+            tc_stop(ob);
+            tc_stop(ob);
+            group_bytes += chunk->bytes;
+        }
+        tc_i64(ob, &rg, 2, group_bytes);
+        tc_i64(ob, &rg, 3, ew->group_rows[g]);
+        tc_stop(ob);
+    }
+    tc_string(ob, &last, 6, EXPORT_CREATED_BY);
+    tc_stop(ob);
+}
+
+int run_export(const char *out_path) {
+    if (!student_store.is_open) {
+        fprintf(stderr, "--export writes out a student store: add --store DIR.\n");
+        return 1;
+    }
+    FILE *out = fopen(out_path, "wb");
+    if (!out) { perror(out_path); return 1; }
+    double t0 = bench_now();
+    ExportWriter ew;
+    memset(&ew, 0, sizeof ew);
+    ew.ob.file = out;
+    int ok = export_subjects(&ew);
+    for (int c = 0; ok && c < EXPORT_COLUMNS; c++) ok = (ew.values[c] = malloc(EXPORT_GROUP_ROWS * sizeof **ew.values)) != NULL;
+    ok = ok && (ew.packed = malloc(EXPORT_GROUP_ROWS * sizeof *ew.packed)) != NULL &&
+         (ew.students = malloc(EXPORT_GROUP_ROWS * sizeof *ew.students)) != NULL;
+    if (!ok) fprintf(stderr, "Out of memory.\n");
+
+    const Cohort *co = &student_store.cohort;
+    ob_put(&ew.ob, "PAR1", 4);
+    for (int k = 0; ok && k < co->count; k++) ok = export_student(&ew, &co->students[k]);
+    ok = ok && export_flush_group(&ew);
+    if (ok) {
+        long long footer = export_tell(&ew);
+        export_footer(&ew);
+        export_put_u32(&ew.ob, (unsigned int)(export_tell(&ew) - footer));
+        ob_put(&ew.ob, "PAR1", 4);
+        ok = export_flush(&ew);
+    }
+    long long bytes = export_tell(&ew);
+    if (fclose(out) != 0) ok = 0;
+    if (!ok) fprintf(stderr, "%s: could not write the export\n", out_path);
+    else {
+        fprintf(stderr, "Exported %lld row(s) of %d student(s) in %d row group(s) to %s: %lld bytes (%.1f ms).\n",
+                ew.total_rows, co->count, ew.num_groups, out_path, bytes, (bench_now() - t0) * 1e3);
+    }
+
+    for (int c = 0; c < EXPORT_COLUMNS; c++) free(ew.values[c]);
+    for (int b = 0; ew.subject_code && b < num_branches; b++) free(ew.subject_code[b]);
+    free(ew.subject_code);
+    free(ew.subjects);
+    free(ew.students);
+    free(ew.packed);
+    free(ew.chunks);
+    free(ew.group_rows);
+    free(ew.ob.data);
+    free(ew.page.data);
+    return ok ? 0 : 1;
+}
+
+/* ===========================
+   Transcripts (--transcripts OUT, with --store DIR): every stored student's graded semesters on
+   one document, HTML by default or a plain PDF with --pdf, from a template (--template FILE,
+   built-in otherwise). OUT is a directory receiving <student_id>.html/.pdf, or one ustar
+   archive when it ends in ".tar".
+   Templates are text with {{field}} slots, {{field:W}} padded or cut to W columns, and
+   {{#semesters}}...{{/semesters}} / {{#subjects}}...{{/subjects}} repeated per graded semester
+   and per subject of it. A template is compiled once into a list of literal spans and slots,
+   so rendering a transcript is copying spans and formatting numbers. The PDF backend lays the
+   rendered text out in Courier, one page per TRANSCRIPT_PDF_LINES lines.
+   Students are handed to --threads workers TRANSCRIPT_CHUNK at a time; archive members are
+   written in cohort order with a fixed mtime, so the archive is the same for any number of
+   threads and from one run to the next. Ids that sanitize to a file name an earlier student
+   already has are reported and skipped before any file is written.
+   =========================== */
+#define TRANSCRIPT_CHUNK 64
+#define TRANSCRIPT_TAR_MTIME 0L             /* archive members carry no run time */
+#define TRANSCRIPT_PDF_LINES 66
+#define TAR_BLOCK 512
+
+enum {
+    TPL_SPAN, TPL_FIELD, TPL_SEMESTERS, TPL_SUBJECTS, TPL_END
+};
+
+/* Template fields; each is valid in its scope and the scopes inside it */
+enum {
+    TF_STUDENT_ID, TF_NAME, TF_BRANCH, TF_BRANCH_NAME, TF_CGPA, TF_TOTAL_CREDITS, TF_ACTIVITY_POINTS,
+    TF_SEMESTERS_COMPLETED, TF_ELIGIBLE,
+    TF_SEMESTER, TF_SGPA, TF_SEMESTER_CREDITS, TF_SEMESTER_ACTIVITY,
+    TF_SUBJECT, TF_CREDITS, TF_MARKS, TF_GRADE_POINT, TF_RESULT,
+    TF_COUNT
+};
+
+static const struct {
+    const char *name;
+    int scope;                      // 0 student, 1 semester, 2 subject
+} template_fields[TF_COUNT] = {
+    { "student_id", 0 }, { "name", 0 }, { "branch", 0 }, { "branch_name", 0 }, { "cgpa", 0 },
+    { "total_credits", 0 }, { "activity_points", 0 }, { "semesters_completed", 0 }, { "eligible", 0 },
+    { "semester", 1 }, { "sgpa", 1 }, { "semester_credits", 1 }, { "semester_activity", 1 },
+    { "subject", 2 }, { "credits", 2 }, { "marks", 2 }, { "grade_point", 2 }, { "result", 2 },
+};
+
+typedef struct {
+    unsigned char op;               // TPL_*
+    unsigned char field;            // TPL_FIELD: TF_*
+    short width;                    // TPL_FIELD: column width, 0 = as is
+    int arg;                        // TPL_SPAN: offset into text; loops: index of their TPL_END
+    int len;                        // TPL_SPAN: bytes
+} TemplateOp;
+
+typedef struct {
+    char *text;                     // template source; spans point into it
+    TemplateOp *ops;
+    int num_ops;
+    int html;                       // escape text fields for HTML
+} Template;
+
+static const char transcript_html_template[] =
+    "<!DOCTYPE html>\n"
+    "<html><head><meta charset=\"utf-8\"><title>Transcript {{student_id}}</title>\n"
+    "<style>body{font-family:sans-serif;margin:2em}table{border-collapse:collapse;margin:.5em 0}"
+    "th,td{border:1px solid #999;padding:2px 8px}td.n{text-align:right}</style></head>\n"
+    "<body>\n<h1>Transcript of Records</h1>\n"
+    "<p>{{name}} ({{student_id}})<br>{{branch_name}} ({{branch}})</p>\n"
+    "{{#semesters}}<h2>Semester {{semester}}</h2>\n"
+    "<table><tr><th>Subject</th><th>Credits</th><th>Marks</th><th>Grade point</th><th>Result</th></tr>\n"
+    "{{#subjects}}<tr><td>{{subject}}</td><td class=\"n\">{{credits}}</td><td class=\"n\">{{marks}}</td>"
+    "<td class=\"n\">{{grade_point}}</td><td>{{result}}</td></tr>\n{{/subjects}}</table>\n"
+    "<p>SGPA <b>{{sgpa}}</b> over {{semester_credits}} credits; activity points {{semester_activity}}</p>\n"
+    "{{/semesters}}<p>CGPA <b>{{cgpa}}</b> over {{total_credits}} credits in {{semesters_completed}} semester(s); "
+    "activity points {{activity_points}}; eligible for the degree: {{eligible}}</p>\n"
+    "</body></html>\n";
+
+static const char transcript_text_template[] =
+    "TRANSCRIPT OF RECORDS\n"
+    "Student: {{name}} ({{student_id}})\n"
+    "Programme: {{branch_name}} ({{branch}})\n\n"
+    "{{#semesters}}SEMESTER {{semester}}\n"
+    "SUBJECT                          CR  MARKS  GP  RESULT\n"
+    "{{#subjects}}{{subject:32}} {{credits:2}}  {{marks:5}}  {{grade_point:2}}  {{result}}\n{{/subjects}}"
+    "SGPA {{sgpa}} over {{semester_credits}} credits, activity points {{semester_activity}}\n\n{{/semesters}}"
+    "CGPA {{cgpa}} over {{total_credits}} credits in {{semesters_completed}} semester(s)\n"
+    "Activity points {{activity_points}}, eligible for the degree: {{eligible}}\n";
+
+static int template_push(Template *t, int *cap, TemplateOp op) {
+    if (t->num_ops == *cap) {
+        int n = *cap ? *cap * 2 : 64;
+        TemplateOp *grown = realloc(t->ops, (size_t)n * sizeof *grown);
+        if (!grown) return 0;
+        t->ops = grown;
+        *cap = n;
+    }
+    t->ops[t->num_ops++] = op;
+    return 1;
+}
+
+/* Compile template source (taken over by t) into spans and slots; 0 with a message on error */
+static int template_compile(Template *t, char *text, const char *path, int html) {
+    memset(t, 0, sizeof *t);
+    t->text = text;
+    t->html = html;
+    int cap = 0, depth = 0, line_no = 1;
+    int open[2];                    /* ops of the loops entered */
+    const char *p = text, *span = text;
+    for (;;) {
+        const char *tag = strstr(p, "{{");
+        const char *stop = tag ? tag : p + strlen(p);
+        for (const char *c = p; c < stop; c++) line_no += *c == '\n';
+        if (stop > span) {
+            TemplateOp op = { TPL_SPAN, 0, 0, (int)(span - text), (int)(stop - span) };
+            if (!template_push(t, &cap, op)) goto oom;
+        }
+        if (!tag) break;
+        const char *close = strstr(tag + 2, "}}");
+        if (!close) { fprintf(stderr, "%s:%d: unclosed {{\n", path, line_no); goto fail; }
+        char word[64];
+        size_t n = (size_t)(close - tag - 2);
+        if (n >= sizeof word) { fprintf(stderr, "%s:%d: unknown field '%.20s...'\n", path, line_no, tag + 2); goto fail; }
+        memcpy(word, tag + 2, n);
+        word[n] = '\0';
+
+        TemplateOp op = { TPL_FIELD, 0, 0, 0, 0 };
+        if (word[0] == '#' || word[0] == '/') {
+            int loop = strcmp(word + 1, "semesters") == 0 ? TPL_SEMESTERS : strcmp(word + 1, "subjects") == 0 ? TPL_SUBJECTS : -1;
+            if (loop < 0) { fprintf(stderr, "%s:%d: unknown section '%s'\n", path, line_no, word + 1); goto fail; }
+            if (word[0] == '#') {
+                if (depth != loop - TPL_SEMESTERS) {
+                    fprintf(stderr, "%s:%d: {{#subjects}} goes inside {{#semesters}}, once\n", path, line_no);
+                    goto fail;
+                }
+                op.op = (unsigned char)loop;
+                open[depth++] = t->num_ops;
+            } else {
+                if (depth == 0 || t->ops[open[depth - 1]].op != loop) {
+                    fprintf(stderr, "%s:%d: {{/%s}} without its {{#%s}}\n", path, line_no, word + 1, word + 1);
+                    goto fail;
+                }
+                op.op = TPL_END;
+                op.arg = open[--depth];
+                t->ops[op.arg].arg = t->num_ops;
+            }
+        } else {
+            char *colon = strchr(word, ':');
+            if (colon) {
+                char *end;
+                long w = strtol(colon + 1, &end, 10);
+                if (*end || w < 1 || w > 200) { fprintf(stderr, "%s:%d: width of '%s' must be 1-200\n", path, line_no, word); goto fail; }
+                op.width = (short)w;
+                *colon = '\0';
+            }
+            int f = 0;
+            while (f < TF_COUNT && strcmp(template_fields[f].name, word) != 0) f++;
+            if (f == TF_COUNT) { fprintf(stderr, "%s:%d: unknown field '%s'\n", path, line_no, word); goto fail; }
+            if (template_fields[f].scope > depth) {
+                fprintf(stderr, "%s:%d: '%s' is only known inside {{#%s}}\n", path, line_no, word, template_fields[f].scope == 1 ? "semesters" : "subjects");
+                goto fail;
+            }
+            op.field = (unsigned char)f;
+        }
+        if (!template_push(t, &cap, op)) goto oom;
+        p = span = close + 2;
+    }
+    if (depth > 0) { fprintf(stderr, "%s: {{#%s}} is never closed\n", path, depth == 2 ? "subjects" : "semesters"); goto fail; }
+    return 1;
+
+oom:
+    fprintf(stderr, "Out of memory.\n");
+fail:
+    free(t->ops);
+    free(t->text);
+    memset(t, 0, sizeof *t);
+    return 0;
+}
+
+static void template_free(Template *t) {
+    free(t->ops);
+    free(t->text);
+}
+
+/* Text field value, cut and padded to width if given, HTML-escaped when the template is HTML */
+static void template_put_text(OutBuf *ob, const Template *t, const char *s, int width) {
+    size_t n = 0;
+    while (s[n] && (width == 0 || n < (size_t)width)) n++;
+    if (!t->html) ob_put(ob, s, n);
+    else {
+        const char *run = s, *end = s + n;
+        for (; s < end; s++) {
+            const char *esc = *s == '&' ? "&amp;" : *s == '<' ? "&lt;" : *s == '>' ? "&gt;" : *s == '"' ? "&quot;" : NULL;
+            if (!esc) continue;
+            ob_put(ob, run, (size_t)(s - run));
+            ob_str(ob, esc);
+            run = s + 1;
+        }
+        ob_put(ob, run, (size_t)(end - run));
+    }
+    ob_fill(ob, ' ', width - (int)n);
+}
+
+typedef struct {
+    const StudentRecord *st;
+    int sem;                        // current semester / subject of the loops
+    int subject;
+    int activity;                   // over all semesters
+    int completed;
+} TemplateScope;
+
+static void template_field(OutBuf *ob, const Template *t, const TemplateOp *op, const TemplateScope *sc) {
+    const StudentRecord *st = sc->st;
+    const Branch *br = &all_branches[st->branch];
+    int number = -1, gpa = -1;      /* numeric fields, right-aligned; otherwise text */
+    const char *text = "";
+    switch (op->field) {
+    case TF_STUDENT_ID:          text = st->reg_no; break;
+    case TF_NAME:                text = st->name ? st->name : ""; break;
+    case TF_BRANCH:              text = br->code; break;
+    case TF_BRANCH_NAME:         text = br->name; break;
+    case TF_CGPA:                gpa = CGPA_X100(st); break;
+    case TF_TOTAL_CREDITS:       number = st->total_credits; break;
+    case TF_ACTIVITY_POINTS:     number = sc->activity; break;
+    case TF_SEMESTERS_COMPLETED: number = sc->completed; break;
+    case TF_ELIGIBLE:            text = eligibility_failures(st) == 0 ? "Yes" : "No"; break;
+    case TF_SEMESTER:            number = br->semesters[sc->sem].sem_number; break;
+    case TF_SGPA:                gpa = SGPA_X100(&st->sems[sc->sem]); break;
+    case TF_SEMESTER_CREDITS:    number = st->sems[sc->sem].gpa_credits; break;
+    case TF_SEMESTER_ACTIVITY:   number = st->sems[sc->sem].activity_points; break;
+    default: {
+        const Subject *sub = &br->semesters[sc->sem].subjects[sc->subject];
+        int marks = STUDENT_MARKS(st, sc->sem)[sc->subject];
+        int gp = STUDENT_GP(st, sc->sem)[sc->subject];
+        if (op->field == TF_SUBJECT) text = sub->name;
+        else if (op->field == TF_CREDITS) number = sub->credits;
+        else if (op->field == TF_MARKS) { if (marks != MARKS_NOT_ENTERED) number = marks; else text = "-"; }
+        else if (op->field == TF_GRADE_POINT) {
+            if (marks == MARKS_NOT_ENTERED) text = "-";
+            else if (sub->is_passfail) text = gp == GP_PF_PASS ? "P" : "F";
+            else number = gp;
+        } else {
+            if (marks == MARKS_NOT_ENTERED) text = "Pending";
+            else if (sub->is_passfail) text = gp == GP_PF_PASS ? "P/F pass" : "P/F fail";
+            else text = gp > 0 ? "Pass" : "Fail";
+        }
+    }
+    }
+    if (number >= 0) ob_int(ob, number, op->width);
+    else if (gpa >= 0) {
+        char buf[GPA_TEXT_MAX];
+        int n = gpa_text(buf, gpa);
+        ob_fill(ob, ' ', op->width - n);
+        ob_put(ob, buf, (size_t)n);
+    } else if (op->field == TF_MARKS || op->field == TF_GRADE_POINT) {
+        ob_fill(ob, ' ', op->width - (int)strlen(text));      /* "-", "P", "F" line up with the numbers */
+        ob_str(ob, text);
+    } else template_put_text(ob, t, text, op->width);
+}
+
+/* Render one student's transcript through the compiled ops */
+static void template_render(OutBuf *ob, const Template *t, const StudentRecord *st) {
+    const Branch *br = &all_branches[st->branch];
+    TemplateScope sc;
+    memset(&sc, 0, sizeof sc);
+    sc.st = st;
+    for (int s = 0; s < br->num_semesters; s++) {
+        sc.activity += st->sems[s].activity_points;
+        sc.completed += st->sems[s].is_completed;
+    }
+    sc.sem = -1;
+    for (int i = 0; i < t->num_ops; i++) {
+        const TemplateOp *op = &t->ops[i];
+        switch (op->op) {
+        case TPL_SPAN:
+            ob_put(ob, t->text + op->arg, (size_t)op->len);
+            break;
+        case TPL_FIELD:
+            template_field(ob, t, op, &sc);
+            break;
+        case TPL_SEMESTERS:
+            for (sc.sem = 0; sc.sem < br->num_semesters && !st->sems[sc.sem].is_completed; sc.sem++) {}
+            if (sc.sem == br->num_semesters) i = op->arg;
+            break;
+        case TPL_SUBJECTS:
+            sc.subject = 0;
+            if (br->semesters[sc.sem].num_subjects == 0) i = op->arg;
+            break;
+        case TPL_END:
+            if (t->ops[op->arg].op == TPL_SUBJECTS) {
+                if (++sc.subject < br->semesters[sc.sem].num_subjects) i = op->arg;
+            } else {
+                for (sc.sem++; sc.sem < br->num_semesters && !st->sems[sc.sem].is_completed; sc.sem++) {}
+                if (sc.sem < br->num_semesters) i = op->arg;
+            }
+            break;
+        }
+    }
+}
+
+/* PDF backend: the rendered text (in) as Courier lines on A4 pages, appended to out */
+static void transcript_pdf(OutBuf *out, const char *text, size_t len) {
+    size_t start = out->len;
+    int num_lines = 1;
+    for (size_t i = 0; i < len; i++) num_lines += text[i] == '\n';
+    if (len > 0 && text[len - 1] == '\n') num_lines--;
+    int pages = num_lines > 0 ? (num_lines + TRANSCRIPT_PDF_LINES - 1) / TRANSCRIPT_PDF_LINES : 1;
+    long *offsets = malloc((size_t)(4 + 2 * pages) * sizeof *offsets);    /* of each object, from start */
+    if (!offsets) { out->failed = 1; return; }
+
+    ob_str(out, "%PDF-1.4\n");
+    offsets[1] = (long)(out->len - start);
+    ob_str(out, "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    offsets[2] = (long)(out->len - start);
+    ob_str(out, "2 0 obj\n<< /Type /Pages /Count ");
+    ob_int(out, pages, 0);
+    ob_str(out, " /Kids [");
+    for (int p = 0; p < pages; p++) {
+        ob_str(out, p ? " " : "");
+        ob_int(out, 4 + 2 * p, 0);
+        ob_str(out, " 0 R");
+    }
+    ob_str(out, "] >>\nendobj\n");
+    offsets[3] = (long)(out->len - start);
+    ob_str(out, "3 0 obj\n<< /Type /Font /Subtype /Type1 /BaseFont /Courier >>\nendobj\n");
+
+    const char *line = text, *end = text + len;
+    for (int p = 0; p < pages; p++) {
+        offsets[4 + 2 * p] = (long)(out->len - start);
+        ob_int(out, 4 + 2 * p, 0);
+        ob_str(out, " 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 595 842] /Resources << /Font << /F1 3 0 R >> >> /Contents ");
+        ob_int(out, 5 + 2 * p, 0);
+        ob_str(out, " 0 R >>\nendobj\n");
+
+        /* content stream: its length is known once written, so it is patched into a fixed-width field */
+        offsets[5 + 2 * p] = (long)(out->len - start);
+        ob_int(out, 5 + 2 * p, 0);
+        ob_str(out, " 0 obj\n<< /Length ");
+        size_t length_at = out->len;
+        ob_str(out, "0000000000 >>\nstream\n");
+        size_t stream_at = out->len;
+        ob_str(out, "BT /F1 9 Tf 11 TL 36 806 Td\n");
+        for (int k = 0; k < TRANSCRIPT_PDF_LINES && line < end; k++) {
+            const char *nl = memchr(line, '\n', (size_t)(end - line));
+            const char *stop = nl ? nl : end;
+            ob_put(out, "(", 1);
+            for (const char *c = line; c < stop; c++) {
+                if (*c == '\r') continue;
+                if (*c == '(' || *c == ')' || *c == '\\') ob_put(out, "\\", 1);
+                ob_put(out, c, 1);
+            }
+            ob_str(out, ") Tj T*\n");
+            line = nl ? nl + 1 : end;
+        }
+        ob_str(out, "ET\n");
+        if (!out->failed) {
+            char digits[11];
+            snprintf(digits, sizeof digits, "%010lu", (unsigned long)(out->len - stream_at));
+            memcpy(out->data + length_at, digits, 10);
+        }
+        ob_str(out, "endstream\nendobj\n");
+    }
+
+    long xref = (long)(out->len - start);
+    int objects = 4 + 2 * pages;
+    ob_str(out, "xref\n0 ");
+    ob_int(out, objects, 0);
+    ob_str(out, "\n0000000000 65535 f \n");
+    for (int k = 1; k < objects; k++) {
+        char entry[24];
+        snprintf(entry, sizeof entry, "%010ld 00000 n \n", offsets[k]);
+        ob_put(out, entry, 20);
+    }
+    ob_str(out, "trailer\n<< /Size ");
+    ob_int(out, objects, 0);
+    ob_str(out, " /Root 1 0 R >>\nstartxref\n");
+    ob_int(out, (int)xref, 0);
+    ob_str(out, "\n%%EOF\n");
+    free(offsets);
+}
+
+/* ustar member header for a file of `size` bytes */
+static void tar_header(OutBuf *ob, const char *name, size_t size, long mtime) {
+    char h[TAR_BLOCK];
+    memset(h, 0, sizeof h);
+    snprintf(h, 100, "%s", name);
+    memcpy(h + 100, "0000644", 8);
+    memcpy(h + 108, "0000000", 8);
+    memcpy(h + 116, "0000000", 8);
+    snprintf(h + 124, 12, "%011lo", (unsigned long)size);
+    snprintf(h + 136, 12, "%011lo", (unsigned long)mtime);
+    memset(h + 148, ' ', 8);
+    h[156] = '0';
+    memcpy(h + 257, "ustar", 6);
+    memcpy(h + 263, "00", 2);
+    unsigned int sum = 0;
+    for (int i = 0; i < TAR_BLOCK; i++) sum += (unsigned char)h[i];
+    snprintf(h + 148, 8, "%06o", sum);
+    ob_put(ob, h, sizeof h);
+}
+
+typedef struct {
+    const Template *tpl;
+    const char *out;                // directory, or NULL for the archive
+    FILE *archive;
+    const char *ext;                // ".html" / ".pdf"
+    int pdf;
+    const unsigned char *skip;      // [cohort] 1 = file name clash, no transcript; NULL = none
+    int num_chunks;
+    int next_chunk;                 // next chunk to take
+#ifdef HAVE_THREADS
+    pthread_mutex_t lock;           // next_chunk, written_chunk and the archive
+    pthread_cond_t turn;
+#endif
+    int written_chunk;              // archive: chunks before this one are written
+    long files;
+    long bytes;
+    int failed;
+} TranscriptJob;
+
+static int transcript_take(TranscriptJob *job) {
+#ifdef HAVE_THREADS
+    pthread_mutex_lock(&job->lock);
+    int c = job->failed ? job->num_chunks : job->next_chunk++;
+    pthread_mutex_unlock(&job->lock);
+    return c;
+#else
+    return job->failed ? job->num_chunks : job->next_chunk++;
+#endif
+}
+
+/* Archive: append a rendered chunk once every earlier chunk is in (each taken chunk comes here,
+   rendered or not, so nobody waits for a chunk that will never arrive) */
+static int transcript_write_chunk(TranscriptJob *job, int chunk, OutBuf *ob, long files, int ok) {
+#ifdef HAVE_THREADS
+    pthread_mutex_lock(&job->lock);
+    while (job->written_chunk != chunk) pthread_cond_wait(&job->turn, &job->lock);
+#else
+    (void)chunk;                    /* one worker takes the chunks in order */
+#endif
+    ok = ok && !job->failed && !ob->failed && write_all(job->archive, ob->data, ob->len);
+    if (!ok) job->failed = 1;
+    job->files += files;
+    job->bytes += (long)ob->len;
+    job->written_chunk++;
+#ifdef HAVE_THREADS
+    pthread_cond_broadcast(&job->turn);
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return ok;
+}
+
+static void *transcript_worker(void *arg) {
+    TranscriptJob *job = arg;
+    const Cohort *co = &student_store.cohort;
+    OutBuf doc, pdf, chunk;
+    memset(&doc, 0, sizeof doc);
+    memset(&pdf, 0, sizeof pdf);
+    memset(&chunk, 0, sizeof chunk);
+    char name[96];
+    int c;
+    while ((c = transcript_take(job)) < job->num_chunks) {
+        int lo = c * TRANSCRIPT_CHUNK, hi = lo + TRANSCRIPT_CHUNK < co->count ? lo + TRANSCRIPT_CHUNK : co->count;
+        long files = 0, bytes = 0;
+        int ok = 1;
+        chunk.len = 0;
+        for (int k = lo; k < hi; k++) {
+            const StudentRecord *st = &co->students[k];
+            if (job->skip && job->skip[k]) continue;
+            doc.len = 0;
+            template_render(&doc, job->tpl, st);
+            OutBuf *file = &doc;
+            if (job->pdf) {
+                pdf.len = 0;
+                transcript_pdf(&pdf, doc.data ? doc.data : "", doc.len);
+                file = &pdf;
+            }
+            if (doc.failed || pdf.failed) { ok = 0; break; }
+            safe_file_name(st->reg_no, name, sizeof name - 8);
+            strcat(name, job->ext);
+            if (job->archive) {
+                tar_header(&chunk, name, file->len, TRANSCRIPT_TAR_MTIME);
+                ob_put(&chunk, file->data, file->len);
+                ob_fill(&chunk, '\0', (int)(-(long)file->len & (TAR_BLOCK - 1)));
+            } else {
+                char path[1024];
+                snprintf(path, sizeof path, "%s/%s", job->out, name);
+                file->file = fopen(path, "wb");
+                if (!file->file) { perror(path); ok = 0; break; }
+                size_t n = file->len;
+                ok = ob_flush(file);
+                if (fclose(file->file) != 0) ok = 0;
+                file->file = NULL;
+                if (!ok) { fprintf(stderr, "%s: write failed\n", path); break; }
+                bytes += (long)n;
+            }
+            files++;
+        }
+        if (job->archive) ok = transcript_write_chunk(job, c, &chunk, files, ok);
+        else {
+#ifdef HAVE_THREADS
+            pthread_mutex_lock(&job->lock);
+#endif
+            job->files += files;
+            job->bytes += bytes;
+#ifdef HAVE_THREADS
+            pthread_mutex_unlock(&job->lock);
+#endif
+        }
+        if (!ok) {
+#ifdef HAVE_THREADS
+            pthread_mutex_lock(&job->lock);
+#endif
+            job->failed = 1;
+#ifdef HAVE_THREADS
+            pthread_cond_broadcast(&job->turn);
+            pthread_mutex_unlock(&job->lock);
+#endif
+        }
+    }
+    free(doc.data);
+    free(pdf.data);
+    free(chunk.data);
+    return NULL;
+}
+
+int run_transcripts(const char *out, const char *template_path, int pdf, int threads) {
+    if (!student_store.is_open) {
+        fprintf(stderr, "--transcripts renders a student store: add --store DIR.\n");
+        return 1;
+    }
+    char *text;
+    const char *source = pdf ? transcript_text_template : transcript_html_template;
+    if (template_path) {
+        size_t size;
+        int mapped;
+        const char *data = map_file(template_path, &size, &mapped);
+        if (!data) { perror(template_path); return 1; }
+        text = malloc(size + 1);
+        if (text) { memcpy(text, data, size); text[size] = '\0'; }
+        unmap_file(data, size, mapped);
+    } else {
+        text = malloc(strlen(source) + 1);
+        if (text) strcpy(text, source);
+    }
+    Template tpl;
+    if (!text) { fprintf(stderr, "Out of memory.\n"); return 1; }
+    if (!template_compile(&tpl, text, template_path ? template_path : "built-in template", !pdf)) return 1;
+
+    size_t out_len = strlen(out);
+    int is_archive = out_len > 4 && strcmp(out + out_len - 4, ".tar") == 0;
+    TranscriptJob job;
+    memset(&job, 0, sizeof job);
+    job.tpl = &tpl;
+    job.pdf = pdf;
+    job.ext = pdf ? ".pdf" : ".html";
+    job.num_chunks = (student_store.cohort.count + TRANSCRIPT_CHUNK - 1) / TRANSCRIPT_CHUNK;
+
+    /* file names are claimed in cohort order up front, so which student keeps a contested name
+       does not depend on the workers */
+    const Cohort *co = &student_store.cohort;
+    FileNames names;
+    memset(&names, 0, sizeof names);
+    unsigned char *skip = NULL;
+    long skipped = 0;
+    char name[64];
+    for (int k = 0; k < co->count; k++) {
+        const char *owner = NULL;
+        safe_file_name(co->students[k].reg_no, name, sizeof name);
+        int claimed = file_names_claim(&names, name, co->students[k].reg_no, &owner);
+        if (claimed == -2 || (claimed == -1 && !skip && !(skip = calloc((size_t)co->count, 1)))) {
+            fprintf(stderr, "Out of memory.\n");
+            file_names_free(&names);
+            template_free(&tpl);
+            return 1;
+        }
+        if (claimed == -1) {
+            fprintf(stderr, "%s: transcript %s%s already holds student '%s'; '%s' skipped\n",
+                    out, name, job.ext, owner, co->students[k].reg_no);
+            skip[k] = 1;
+            skipped++;
+        }
+    }
+    file_names_free(&names);
+    job.skip = skip;
+
+    if (is_archive) {
+        job.archive = fopen(out, "wb");
+        if (!job.archive) { perror(out); free(skip); template_free(&tpl); return 1; }
+    } else {
+        job.out = out;
+#ifdef HAVE_POSIX
+        mkdir(out, 0755);
+#endif
+    }
+
+    double t0 = bench_now();
+#ifdef HAVE_THREADS
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.turn, NULL);
+    pthread_t *tids = threads > 1 ? calloc((size_t)threads, sizeof *tids) : NULL;
+    int started = 0;
+    for (int w = 0; tids && w < threads; w++) {
+        if (pthread_create(&tids[w], NULL, transcript_worker, &job) != 0) break;
+        started++;
+    }
+    if (started == 0) transcript_worker(&job);
+    for (int w = 0; w < started; w++) pthread_join(tids[w], NULL);
+    free(tids);
+    pthread_cond_destroy(&job.turn);
+    pthread_mutex_destroy(&job.lock);
+#else
+    (void)threads;
+    transcript_worker(&job);
+#endif
+    int ok = !job.failed;
+    if (job.archive) {
+        char zeros[2 * TAR_BLOCK];
+        memset(zeros, 0, sizeof zeros);
+        if (ok) ok = write_all(job.archive, zeros, sizeof zeros);
+        if (fclose(job.archive) != 0) ok = 0;
+        if (!ok) fprintf(stderr, "%s: could not write the archive\n", out);
+    }
+    double seconds = bench_now() - t0;
+    fprintf(stderr, "Transcripts: %ld %s file(s), %ld bytes, into %s in %.1f ms (%.0f per second).\n",
+            job.files, pdf ? "PDF" : "HTML", job.bytes, out, seconds * 1e3, seconds > 0 ? job.files / seconds : 0.0);
+    if (skipped) fprintf(stderr, "Transcripts: %ld student(s) skipped for file name clashes.\n", skipped);
+    free(skip);
+    template_free(&tpl);
+    return ok ? 0 : 1;
+}
+
+/* ===========================
+   Metrics export: Prometheus text exposition format, or one JSON object with the counters and,
+   per histogram, count, sum, p50/p90/p99 (upper bounds of their buckets) and non-empty buckets.
+   =========================== */
+#ifdef HAVE_METRICS
+static const char *const counter_info[NUM_COUNTERS][2] = {
+    { "cgpa_rows_graded_total", "Marks rows graded" },
+    { "cgpa_rows_rejected_total", "Marks rows rejected" },
+    { "cgpa_grade_lookups_total", "Marks mapped to a grade point" },
+    { "cgpa_semesters_graded_total", "Semester SGPAs computed" },
+    { "cgpa_cgpa_updates_total", "CGPA updates from running totals" },
+    { "cgpa_store_records_total", "Records appended to the store log" }
+};
+
+static const char *const timer_info[NUM_TIMERS][2] = {
+    { "cgpa_ingest_row_seconds", "Parsing, grading and storing one marks row" },
+    { "cgpa_grade_semester_seconds", "SGPA and CGPA update of one semester" },
+    { "cgpa_revaluation_seconds", "Applying one revised mark" },
+    { "cgpa_render_report_seconds", "Rendering one semester report" },
+    { "cgpa_store_append_seconds", "Appending one store log record, fsync included when due" },
+    { "cgpa_store_sync_seconds", "fsync of the store log" },
+    { "cgpa_store_compact_seconds", "Writing a store snapshot" },
+    { "cgpa_http_request_seconds", "Answering one HTTP request" }
+};
+
+/* Every thread's shard added up; live shards may be a few increments behind */
+static void metrics_merge(MetricsShard *total) {
+    memset(total, 0, sizeof *total);
+    pthread_mutex_lock(&metrics_lock);
+    for (const MetricsShard *s = metrics_shards; s; s = s->next) {
+        for (int c = 0; c < NUM_COUNTERS; c++) total->counter[c] += s->counter[c];
+        for (int t = 0; t < NUM_TIMERS; t++) {
+            total->count[t] += s->count[t];
+            total->sum_ns[t] += s->sum_ns[t];
+            for (int k = 0; k < METRIC_BUCKETS; k++) total->bucket[t][k] += s->bucket[t][k];
+        }
+    }
+    pthread_mutex_unlock(&metrics_lock);
+}
+
+static void ob_printf(OutBuf *ob, const char *fmt, ...) {
+    char tmp[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof tmp, fmt, ap);
+    va_end(ap);
+    if (n > 0) ob_put(ob, tmp, (size_t)n < sizeof tmp ? (size_t)n : sizeof tmp - 1);
+}
+
+/* Upper bound in seconds of the bucket holding quantile q of a histogram */
+static double metrics_quantile(const MetricsShard *m, int t, double q) {
+    unsigned long long rank = (unsigned long long)(q * (double)m->count[t]), seen = 0;
+    if (m->count[t] == 0) return 0.0;
+    for (int k = 0; k < METRIC_BUCKETS; k++) {
+        seen += m->bucket[t][k];
+        if (seen > rank) return (double)(1ull << k) * 1e-9;
+    }
+    return (double)(1ull << (METRIC_BUCKETS - 1)) * 1e-9;
+}
+
+void metrics_render(OutBuf *ob, int json) {
+    MetricsShard m;
+    metrics_merge(&m);
+    if (json) {
+        ob_str(ob, "{\"counters\":{");
+        for (int c = 0; c < NUM_COUNTERS; c++) ob_printf(ob, "%s\"%s\":%llu", c ? "," : "", counter_info[c][0], m.counter[c]);
+        ob_str(ob, "},\"histograms\":{");
+        for (int t = 0; t < NUM_TIMERS; t++) {
+            ob_printf(ob, "%s\"%s\":{\"count\":%llu,\"sum\":%.9f,\"p50\":%.9g,\"p90\":%.9g,\"p99\":%.9g,\"buckets\":[",
+                      t ? "," : "", timer_info[t][0], m.count[t], (double)m.sum_ns[t] * 1e-9,
+                      metrics_quantile(&m, t, 0.5), metrics_quantile(&m, t, 0.9), metrics_quantile(&m, t, 0.99));
+            const char *sep = "";
+            for (int k = 0; k < METRIC_BUCKETS; k++) {
+                if (!m.bucket[t][k]) continue;
+                ob_printf(ob, "%s[%.9g,%llu]", sep, (double)(1ull << k) * 1e-9, m.bucket[t][k]);
+                sep = ",";
+            }
+            ob_str(ob, "]}");
+        }
+        ob_str(ob, "}}\n");
+        return;
+    }
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        ob_printf(ob, "# HELP %s %s.\n# TYPE %s counter\n%s %llu\n", counter_info[c][0], counter_info[c][1],
+                  counter_info[c][0], counter_info[c][0], m.counter[c]);
+    }
+    for (int t = 0; t < NUM_TIMERS; t++) {
+        const char *name = timer_info[t][0];
+        ob_printf(ob, "# HELP %s %s.\n# TYPE %s histogram\n", name, timer_info[t][1], name);
+        unsigned long long cumulative = 0;
+        for (int k = 0; k < METRIC_BUCKETS - 1; k++) {
+            cumulative += m.bucket[t][k];
+            ob_printf(ob, "%s_bucket{le=\"%.9g\"} %llu\n", name, (double)(1ull << k) * 1e-9, cumulative);
+        }
+        ob_printf(ob, "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.9f\n%s_count %llu\n", name, m.count[t],
+                  name, (double)m.sum_ns[t] * 1e-9, name, m.count[t]);
+    }
+}
+
+/* Write a snapshot of the metrics to path: JSON when it ends in ".json", Prometheus text otherwise */
+int metrics_write(const char *path) {
+    size_t n = strlen(path);
+    OutBuf ob;
+    memset(&ob, 0, sizeof ob);
+    metrics_render(&ob, n >= 5 && strcmp(path + n - 5, ".json") == 0);
+    ob.file = fopen(path, "wb");
+    if (!ob.file) { perror(path); free(ob.data); return 0; }
+    int ok = ob_flush(&ob);
+    if (fclose(ob.file) != 0) ok = 0;
+    if (!ok) perror(path);
+    free(ob.data);
+    return ok;
+}
+#endif
+
+/* ===========================
+   Result service (--serve PORT, with --store DIR)
+   A single-threaded epoll loop on 127.0.0.1 answering HTTP/1.1 GET requests with JSON:
+     /students/<reg_no>          every graded semester (SGPA, subjects), CGPA and activity points
+     /students/<reg_no>/summary  activity points and P/F failures, as show_branch_pf_summary()
+     /health                     number of stored students
+     /metrics                    counters and latency histograms, Prometheus text format
+   Connections and their buffers come from a fixed pool and are reused. The requests of one
+   wakeup are parsed first, their register numbers looked up together, and each connection's
+   responses then leave in one send(). Nothing writes to the store while it is served, so every
+   student's response is serialized once, headers included, and later requests copy it.
+   =========================== */
+#ifdef HAVE_EPOLL
+#define SERVE_MAX_CONNECTIONS 4096
+#define SERVE_REQUEST_MAX 8192              /* request head bytes held per connection */
+#define SERVE_OUT_MAX (1u << 20)            /* a connection is not read while this much is unsent */
+#define SERVE_EVENTS 256
+#define SERVE_IDLE_SECONDS 30
+#define SERVE_CACHE_BYTES (256u << 20)      /* beyond this, responses are rendered per request */
+#define SERVE_LISTENER SERVE_MAX_CONNECTIONS
+
+#define SERVE_STUDENT 0
+#define SERVE_SUMMARY 1
+#define SERVE_HEALTH 2
+#define SERVE_NOT_FOUND 3
+#define SERVE_BAD_REQUEST 4
+#define SERVE_BAD_METHOD 5
+#define SERVE_TOO_LARGE 6
+#define SERVE_METRICS 7
+
+typedef struct {
+    int fd;                         // -1 = free
+    int next_free;                  // free list link
+    unsigned int generation;        // bumped on close, so queued requests of a reused slot are dropped
+    int closing;                    // close once everything queued is sent
+    int queued;                     // listed in Server.touched this wakeup
+    unsigned int events;            // registered with epoll
+    time_t last_active;
+    size_t in_len;
+    size_t out_sent;
+    OutBuf out;                     // responses not yet sent; the buffer stays with the slot
+    char in[SERVE_REQUEST_MAX];     // request bytes not yet parsed
+} ServeConnection;
+
+typedef struct {
+    int conn;
+    unsigned int generation;
+    int kind;                       // SERVE_*
+    int close;                      // the client asked to close after this response
+    int student;                    // cohort index once looked up, -1 = unknown
+    char reg_no[16];
+} ServeRequest;
+
+typedef struct {
+    char *response;                 // status line, headers and body; NULL until first asked for
+    size_t length;
+} ServeCacheEntry;
+
+typedef struct {
+    int epfd;
+    int listen_fd;
+    time_t now;
+    ServeConnection *conns;         // [SERVE_MAX_CONNECTIONS]
+    int free_head;
+    ServeRequest *reqs;             // requests parsed this wakeup
+    int num_reqs;
+    int cap_reqs;
+    int *touched;                   // connections with requests (or an end of input) this wakeup
+    int num_touched;
+    ServeCacheEntry *cache[2];      // [SERVE_STUDENT / SERVE_SUMMARY][cohort index]
+    size_t cache_bytes;
+    OutBuf body;                    // response being serialized
+    long served;
+} Server;
+
+static volatile sig_atomic_t serve_stop;
+
+static void serve_on_signal(int sig) {
+    (void)sig;
+    serve_stop = 1;
+}
+
+/* JSON string with quotes, backslashes and control characters escaped */
+static void ob_json_str(OutBuf *ob, const char *s) {
+    ob_put(ob, "\"", 1);
+    for (const char *run = s;; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        ob_put(ob, run, (size_t)(s - run));
+        if (!c) break;
+        char esc[8];
+        int n = c < 0x20 ? snprintf(esc, sizeof esc, "\\u%04x", c) : snprintf(esc, sizeof esc, "\\%c", c);
+        ob_put(ob, esc, (size_t)n);
+        run = s + 1;
+    }
+    ob_put(ob, "\"", 1);
+}
+
+/* The stored record of a student: every graded semester with its subjects */
+static void serve_student_json(OutBuf *ob, const StudentRecord *st) {
+    const Branch *br = &all_branches[st->branch];
+    ob_str(ob, "{\"reg_no\":");
+    ob_json_str(ob, st->reg_no);
+    ob_str(ob, ",\"name\":");
+    if (st->name) ob_json_str(ob, st->name);
+    else ob_str(ob, "null");
+    ob_str(ob, ",\"branch\":");
+    ob_json_str(ob, br->code);
+    ob_str(ob, ",\"cgpa\":");
+    ob_gpa(ob, CGPA_X100(st));
+    ob_str(ob, ",\"credits\":");
+    ob_int(ob, st->total_credits, 0);
+    ob_str(ob, ",\"activity_points\":");
+    ob_int(ob, sum_activity_points(st), 0);
+    ob_str(ob, ",\"pf_failures\":");
+    ob_int(ob, count_pf_failures(st), 0);
+    ob_str(ob, ",\"semesters\":[");
+    const char *sep = "";
+    for (int s = 0; s < br->num_semesters; s++) {
+        const SemesterResult *res = &st->sems[s];
+        if (!res->is_completed) continue;
+        const Semester *syl = &br->semesters[s];
+        const unsigned char *marks = STUDENT_MARKS(st, s);
+        const signed char *gp = STUDENT_GP(st, s);
+        ob_str(ob, sep);
+        sep = ",";
+        ob_str(ob, "{\"semester\":");
+        ob_int(ob, syl->sem_number, 0);
+        ob_str(ob, ",\"sgpa\":");
+        ob_gpa(ob, SGPA_X100(res));
+        ob_str(ob, ",\"credits\":");
+        ob_int(ob, res->gpa_credits, 0);
+        ob_str(ob, ",\"credit_points\":");
+        ob_int(ob, res->credit_points, 0);
+        ob_str(ob, ",\"activity_points\":");
+        ob_int(ob, res->activity_points, 0);
+        ob_str(ob, res->pf_failed ? ",\"pf_failed\":true,\"subjects\":[" : ",\"pf_failed\":false,\"subjects\":[");
+        for (int i = 0; i < syl->num_subjects; i++) {
+            const Subject *sub = &syl->subjects[i];
+            ob_str(ob, i ? ",{\"name\":" : "{\"name\":");
+            ob_json_str(ob, sub->name);
+            ob_str(ob, ",\"credits\":");
+            ob_int(ob, sub->credits, 0);
+            ob_str(ob, ",\"marks\":");
+            if (marks[i] == MARKS_NOT_ENTERED) ob_str(ob, "null");
+            else ob_int(ob, marks[i], 0);
+            if (sub->is_passfail) {
+                ob_str(ob, gp[i] == GP_PF_PASS ? ",\"pf\":\"pass\"}" : gp[i] == GP_PF_FAIL ? ",\"pf\":\"fail\"}" : ",\"pf\":\"pending\"}");
+            } else {
+                ob_str(ob, ",\"grade_point\":");
+                ob_int(ob, gp[i], 0);
+                ob_str(ob, "}");
+            }
+        }
+        ob_str(ob, "]}");
+    }
+    ob_str(ob, "]}");
+}
+
+/* Activity points and P/F failures of a student, worded as show_branch_pf_summary() */
+static void serve_summary_json(OutBuf *ob, const StudentRecord *st) {
+    int activity = sum_activity_points(st);
+    int fails = count_pf_failures(st);
+    ob_str(ob, "{\"reg_no\":");
+    ob_json_str(ob, st->reg_no);
+    ob_str(ob, ",\"branch\":");
+    ob_json_str(ob, all_branches[st->branch].code);
+    ob_str(ob, ",\"activity_points\":");
+    ob_int(ob, activity, 0);
+    ob_str(ob, ",\"activity_required\":");
+    ob_int(ob, ACTIVITY_REQUIRED, 0);
+    ob_str(ob, activity >= ACTIVITY_REQUIRED ? ",\"activity_met\":true" : ",\"activity_met\":false");
+    ob_str(ob, ",\"pf_failures\":");
+    ob_int(ob, fails, 0);
+    ob_str(ob, ",\"message\":");
+    if (fails == 0) {
+        ob_json_str(ob, "All pass/fail subjects passed so far.");
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof msg, "There are %d failed pass/fail subject(s). You must clear them to be eligible for the degree.", fails);
+        ob_json_str(ob, msg);
+    }
+    ob_str(ob, "}");
+}
+
+static void serve_head(OutBuf *ob, int kind, size_t body_len, int close) {
+    static const char *const status[] = {
+        "200 OK", "200 OK", "200 OK", "404 Not Found", "400 Bad Request",
+        "405 Method Not Allowed", "431 Request Header Fields Too Large", "200 OK"
+    };
+    ob_str(ob, "HTTP/1.1 ");
+    ob_str(ob, status[kind]);
+    ob_str(ob, kind == SERVE_METRICS ? "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                                     : "\r\nContent-Type: application/json\r\nContent-Length: ");
+    ob_int(ob, (int)body_len, 0);
+    ob_str(ob, close ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n");
+}
+
+/* Queue the response to one request on its connection */
+static void serve_respond(Server *sv, ServeConnection *c, const ServeRequest *r) {
+    OutBuf *body = &sv->body;
+    body->len = 0;
+    body->failed = 0;
+    if ((r->kind == SERVE_STUDENT || r->kind == SERVE_SUMMARY) && r->student >= 0) {
+        ServeCacheEntry *e = &sv->cache[r->kind][r->student];
+        if (!e->response) {
+            const StudentRecord *st = &student_store.cohort.students[r->student];
+            if (r->kind == SERVE_STUDENT) serve_student_json(body, st);
+            else serve_summary_json(body, st);
+            char head[160];
+            OutBuf hb = { head, 0, sizeof head, NULL, 0 };
+            serve_head(&hb, r->kind, body->len, 0);
+            size_t n = hb.len + body->len;
+            char *p = !body->failed && sv->cache_bytes + n <= SERVE_CACHE_BYTES ? malloc(n) : NULL;
+            if (!p) {
+                ob_put(&c->out, head, hb.len);
+                ob_put(&c->out, body->data, body->len);
+                return;
+            }
+            memcpy(p, head, hb.len);
+            memcpy(p + hb.len, body->data, body->len);
+            e->response = p;
+            e->length = n;
+            sv->cache_bytes += n;
+        }
+        ob_put(&c->out, e->response, e->length);
+        if (r->close) {
+            /* cached responses omit "Connection: close"; the connection is closed after it anyway */
+            c->closing = 1;
+        }
+        return;
+    }
+
+    int kind = r->kind;
+    if (kind == SERVE_HEALTH) {
+        ob_str(body, "{\"status\":\"ok\",\"students\":");
+        ob_int(body, student_store.cohort.count, 0);
+        ob_str(body, "}");
+#ifdef HAVE_METRICS
+    } else if (kind == SERVE_METRICS) {
+        metrics_render(body, 0);
+#endif
+    } else {
+        if (kind == SERVE_STUDENT || kind == SERVE_SUMMARY) kind = SERVE_NOT_FOUND;
+        ob_str(body, "{\"error\":");
+        ob_json_str(body, kind == SERVE_NOT_FOUND ? "not found" : kind == SERVE_BAD_METHOD ? "only GET is served" :
+                          kind == SERVE_TOO_LARGE ? "request too large" : "bad request");
+        ob_str(body, "}");
+    }
+    int close = r->close || kind == SERVE_BAD_REQUEST || kind == SERVE_BAD_METHOD || kind == SERVE_TOO_LARGE;
+    serve_head(&c->out, kind, body->len, close);
+    ob_put(&c->out, body->data, body->len);
+    if (close) c->closing = 1;
+}
+
+static int serve_header_is(const char *line, const char *end, const char *name) {
+    size_t n = strlen(name);
+    if ((size_t)(end - line) <= n || line[n] != ':') return 0;
+    for (size_t i = 0; i < n; i++) if (tolower((unsigned char)line[i]) != name[i]) return 0;
+    return 1;
+}
+
+static int serve_value_has(const char *v, const char *end, const char *token) {
+    size_t n = strlen(token);
+    for (; v + n <= end; v++) {
+        size_t i = 0;
+        while (i < n && tolower((unsigned char)v[i]) == token[i]) i++;
+        if (i == n) return 1;
+    }
+    return 0;
+}
+
+/* Route one request head (len bytes up to its blank line) */
+static void serve_route(ServeRequest *r, const char *p, size_t len) {
+    const char *end = p + len;
+    const char *eol = memchr(p, '\n', len);
+    const char *sp1 = memchr(p, ' ', (size_t)(eol - p));
+    const char *sp2 = sp1 ? memchr(sp1 + 1, ' ', (size_t)(eol - sp1 - 1)) : NULL;
+    r->kind = SERVE_BAD_REQUEST;
+    r->close = 1;
+    r->student = -1;
+    r->reg_no[0] = '\0';
+    if (!sp2) return;
+    const char *version = sp2 + 1;
+    if ((size_t)(eol - version) < 8 || memcmp(version, "HTTP/1.", 7) != 0) return;
+    r->close = version[7] == '0';
+
+    for (const char *line = eol + 1; line < end; ) {
+        const char *next = memchr(line, '\n', (size_t)(end - line));
+        if (serve_header_is(line, next, "connection")) {
+            if (serve_value_has(line, next, "close")) r->close = 1;
+            else if (serve_value_has(line, next, "keep-alive")) r->close = 0;
+        } else if (serve_header_is(line, next, "transfer-encoding")) {
+            return;     /* a request with a body: not worth skipping */
+        } else if (serve_header_is(line, next, "content-length")) {
+            const char *v = line + 15;
+            while (v < next && (*v == ' ' || *v == '\t' || *v == '0')) v++;
+            if (v < next && *v != '\r') return;
+        }
+        line = next + 1;
+    }
+
+    if (sp1 - p != 3 || memcmp(p, "GET", 3) != 0) { r->kind = SERVE_BAD_METHOD; return; }
+    const char *path = sp1 + 1, *path_end = sp2;
+    const char *query = memchr(path, '?', (size_t)(path_end - path));
+    if (query) path_end = query;
+    size_t n = (size_t)(path_end - path);
+    r->kind = SERVE_NOT_FOUND;
+    if (n == 7 && memcmp(path, "/health", 7) == 0) { r->kind = SERVE_HEALTH; return; }
+#ifdef HAVE_METRICS
+    if (n == 8 && memcmp(path, "/metrics", 8) == 0) { r->kind = SERVE_METRICS; return; }
+#endif
+    if (n <= 10 || memcmp(path, "/students/", 10) != 0) return;
+    const char *id = path + 10;
+    const char *slash = memchr(id, '/', (size_t)(path_end - id));
+    const char *id_end = slash ? slash : path_end;
+    if (id_end - id >= (long)sizeof r->reg_no) return;
+    if (slash && !(path_end - slash == 8 && memcmp(slash, "/summary", 8) == 0)) return;
+    memcpy(r->reg_no, id, (size_t)(id_end - id));
+    r->reg_no[id_end - id] = '\0';
+    r->kind = slash ? SERVE_SUMMARY : SERVE_STUDENT;
+}
+
+/* Length of the request head at p (through its blank line), 0 if it is not complete yet */
+static size_t serve_head_length(const char *p, size_t n) {
+    for (const char *nl = memchr(p, '\n', n); nl; nl = memchr(nl + 1, '\n', n - (size_t)(nl + 1 - p))) {
+        const char *q = nl + 1;
+        if (q < p + n && *q == '\r') q++;
+        if (q < p + n && *q == '\n') return (size_t)(q + 1 - p);
+    }
+    return 0;
+}
+
+static void serve_touch(Server *sv, int ci) {
+    if (sv->conns[ci].queued) return;
+    sv->conns[ci].queued = 1;
+    sv->touched[sv->num_touched++] = ci;
+}
+
+static ServeRequest *serve_push(Server *sv, int ci) {
+    if (sv->num_reqs == sv->cap_reqs) {
+        int cap = sv->cap_reqs ? sv->cap_reqs * 2 : 1024;
+        ServeRequest *grown = realloc(sv->reqs, (size_t)cap * sizeof *grown);
+        if (!grown) return NULL;
+        sv->reqs = grown;
+        sv->cap_reqs = cap;
+    }
+    ServeRequest *r = &sv->reqs[sv->num_reqs++];
+    serve_touch(sv, ci);
+    r->conn = ci;
+    r->generation = sv->conns[ci].generation;
+    return r;
+}
+
+static void serve_close(Server *sv, int ci) {
+    ServeConnection *c = &sv->conns[ci];
+    close(c->fd);               /* also leaves the epoll set */
+    c->fd = -1;
+    c->generation++;
+    c->out.len = 0;
+    c->next_free = sv->free_head;
+    sv->free_head = ci;
+}
+
+/* Register interest in reading unless output is backed up, and in writing while any is pending */
+static void serve_watch(Server *sv, int ci) {
+    ServeConnection *c = &sv->conns[ci];
+    size_t pending = c->out.len - c->out_sent;
+    unsigned int events = (!c->closing && pending < SERVE_OUT_MAX ? EPOLLIN : 0) | (pending ? EPOLLOUT : 0);
+    if (events == c->events) return;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = events;
+    ev.data.u32 = (unsigned int)ci;
+    if (epoll_ctl(sv->epfd, EPOLL_CTL_MOD, c->fd, &ev) != 0) { serve_close(sv, ci); return; }
+    c->events = events;
+}
+
+/* Send what is queued on a connection, as far as the socket takes it */
+static void serve_send(Server *sv, int ci) {
+    ServeConnection *c = &sv->conns[ci];
+    if (c->out.failed) { serve_close(sv, ci); return; }
+    while (c->out_sent < c->out.len) {
+        ssize_t w = send(c->fd, c->out.data + c->out_sent, c->out.len - c->out_sent, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            serve_close(sv, ci);
+            return;
+        }
+        c->out_sent += (size_t)w;
+        c->last_active = sv->now;
+    }
+    if (c->out_sent == c->out.len) {
+        c->out.len = c->out_sent = 0;
+        if (c->closing) { serve_close(sv, ci); return; }
+    }
+    serve_watch(sv, ci);
+}
+
+/* Read what a connection has sent and queue every complete request in it */
+static void serve_read(Server *sv, int ci) {
+    ServeConnection *c = &sv->conns[ci];
+    if (c->closing) return;
+    ssize_t got = recv(c->fd, c->in + c->in_len, SERVE_REQUEST_MAX - c->in_len, 0);
+    if (got < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) serve_close(sv, ci);
+        return;
+    }
+    if (got == 0) {
+        /* the client is done sending: answer what it asked, then close */
+        c->closing = 1;
+        serve_touch(sv, ci);
+        return;
+    }
+    c->in_len += (size_t)got;
+    c->last_active = sv->now;
+
+    size_t pos = 0, head;
+    while (!c->closing && (head = serve_head_length(c->in + pos, c->in_len - pos)) > 0) {
+        ServeRequest *r = serve_push(sv, ci);
+        if (!r) { serve_close(sv, ci); return; }
+        serve_route(r, c->in + pos, head);
+        pos += head;
+        c->closing = r->close;  /* anything after it is not answered */
+    }
+    if (pos == 0 && c->in_len == SERVE_REQUEST_MAX) {
+        ServeRequest *r = serve_push(sv, ci);
+        if (!r) { serve_close(sv, ci); return; }
+        r->kind = SERVE_TOO_LARGE;
+        r->close = 1;
+        c->closing = 1;
+    }
+    memmove(c->in, c->in + pos, c->in_len - pos);
+    c->in_len -= pos;
+}
+
+static void serve_accept(Server *sv) {
+    static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    for (;;) {
+        int fd = accept(sv->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;             /* EAGAIN, or out of descriptors until some close */
+        }
+        if (sv->free_head < 0) {
+            if (send(fd, busy, sizeof busy - 1, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) { /* dropped either way */ }
+            close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int ci = sv->free_head;
+        ServeConnection *c = &sv->conns[ci];
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof ev);
+        ev.events = EPOLLIN;
+        ev.data.u32 = (unsigned int)ci;
+        if (epoll_ctl(sv->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) { close(fd); continue; }
+        sv->free_head = c->next_free;
+        c->fd = fd;
+        c->closing = 0;
+        c->events = EPOLLIN;
+        c->last_active = sv->now;
+        c->in_len = 0;
+        c->out_sent = 0;
+        c->out.len = 0;
+        c->out.failed = 0;
+    }
+}
+
+/* Answer everything parsed this wakeup: look the students up in one pass, queue the responses
+   in request order, then send once per connection */
+static void serve_answer(Server *sv) {
+    for (int i = 0; i < sv->num_reqs; i++) {
+        ServeRequest *r = &sv->reqs[i];
+        if (r->kind == SERVE_STUDENT || r->kind == SERVE_SUMMARY) r->student = student_index_find(&student_store, r->reg_no);
+    }
+    for (int i = 0; i < sv->num_reqs; i++) {
+        const ServeRequest *r = &sv->reqs[i];
+        ServeConnection *c = &sv->conns[r->conn];
+        if (c->fd < 0 || c->generation != r->generation) continue;
+        METRIC_START(t0);
+        serve_respond(sv, c, r);
+        METRIC_STOP(TIMER_HTTP_REQUEST, t0);
+        sv->served++;
+    }
+    for (int i = 0; i < sv->num_touched; i++) {
+        int ci = sv->touched[i];
+        sv->conns[ci].queued = 0;
+        if (sv->conns[ci].fd >= 0) serve_send(sv, ci);
+    }
+    sv->num_reqs = 0;
+    sv->num_touched = 0;
+}
+
+static void serve_free(Server *sv) {
+    for (int i = 0; i < SERVE_MAX_CONNECTIONS && sv->conns; i++) {
+        if (sv->conns[i].fd >= 0) close(sv->conns[i].fd);
+        free(sv->conns[i].out.data);
+    }
+    for (int k = 0; k < 2; k++) {
+        for (int i = 0; sv->cache[k] && i < student_store.cohort.count; i++) free(sv->cache[k][i].response);
+        free(sv->cache[k]);
+    }
+    free(sv->conns);
+    free(sv->reqs);
+    free(sv->touched);
+    free(sv->body.data);
+    if (sv->epfd >= 0) close(sv->epfd);
+    if (sv->listen_fd >= 0) close(sv->listen_fd);
+}
+#endif
+
+int run_serve(int port) {
+#ifdef HAVE_EPOLL
+    if (!student_store.is_open) {
+        fprintf(stderr, "--serve answers from a student store: add --store DIR.\n");
+        return 1;
+    }
+    Server sv;
+    memset(&sv, 0, sizeof sv);
+    sv.epfd = sv.listen_fd = -1;
+    sv.conns = calloc(SERVE_MAX_CONNECTIONS, sizeof *sv.conns);
+    sv.touched = malloc(SERVE_MAX_CONNECTIONS * sizeof *sv.touched);
+    for (int k = 0; k < 2; k++) sv.cache[k] = calloc((size_t)student_store.cohort.count + 1, sizeof *sv.cache[k]);
+    if (!sv.conns || !sv.touched || !sv.cache[0] || !sv.cache[1]) {
+        fprintf(stderr, "Out of memory.\n");
+        serve_free(&sv);
+        return 1;
+    }
+    sv.free_head = -1;
+    for (int i = SERVE_MAX_CONNECTIONS - 1; i >= 0; i--) {
+        sv.conns[i].fd = -1;
+        sv.conns[i].next_free = sv.free_head;
+        sv.free_head = i;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int one = 1;
+    sv.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sv.listen_fd < 0 || setsockopt(sv.listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one) != 0 ||
+        bind(sv.listen_fd, (struct sockaddr *)&addr, sizeof addr) != 0 || listen(sv.listen_fd, SOMAXCONN) != 0 ||
+        fcntl(sv.listen_fd, F_SETFL, fcntl(sv.listen_fd, F_GETFL) | O_NONBLOCK) != 0) {
+        perror("--serve");
+        serve_free(&sv);
+        return 1;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN;
+    ev.data.u32 = SERVE_LISTENER;
+    if ((sv.epfd = epoll_create1(0)) < 0 || epoll_ctl(sv.epfd, EPOLL_CTL_ADD, sv.listen_fd, &ev) != 0) {
+        perror("epoll");
+        serve_free(&sv);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = serve_on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("Serving %d student(s) on http://127.0.0.1:%d/ (Ctrl-C to stop).\n", student_store.cohort.count, port);
+    fflush(stdout);
+    struct epoll_event events[SERVE_EVENTS];
+    time_t last_sweep = time(NULL);
+    while (!serve_stop) {
+        int n = epoll_wait(sv.epfd, events, SERVE_EVENTS, 1000);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        sv.now = time(NULL);
+        for (int i = 0; i < n; i++) {
+            unsigned int ci = events[i].data.u32;
+            if (ci == SERVE_LISTENER) { serve_accept(&sv); continue; }
+            if (sv.conns[ci].fd < 0) continue;
+            if (events[i].events & EPOLLOUT) serve_send(&sv, (int)ci);
+            if (sv.conns[ci].fd >= 0 && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))) serve_read(&sv, (int)ci);
+        }
+        serve_answer(&sv);
+
+        if (sv.now - last_sweep >= 1) {
+            for (int i = 0; i < SERVE_MAX_CONNECTIONS; i++) {
+                if (sv.conns[i].fd >= 0 && sv.now - sv.conns[i].last_active > SERVE_IDLE_SECONDS) serve_close(&sv, i);
+            }
+            last_sweep = sv.now;
+        }
+    }
+    printf("Stopped after %ld request(s).\n", sv.served);
+    serve_free(&sv);
+    return 0;
+#else
+    (void)port;
+    fprintf(stderr, "--serve needs epoll (Linux).\n");
+    return 1;
+#endif
+}
+
+/* ===========================
+   Concurrent mark entry (--entry PORT, with --store DIR)
+   Exam-cell operators commit marks at the same time over a line protocol on 127.0.0.1:PORT,
+   one thread per connection:
+     MARKS <a --batch row>   ->  OK <id> S<n> SGPA x.xx CGPA x.xx      or  ERR <reason>
+     GET <student_id>        ->  OK <id> <branch> CGPA x.xx S<n> x.xx ...  (graded semesters)
+     QUIT
+   Students are guarded by striped seqlocks. A writer takes its stripe's mutex and keeps the
+   sequence odd while it changes the record; it appends the log record before letting the mutex
+   go, so each student's log order is their apply order. Readers copy the record and retry if
+   the sequence moved, so they never block writers. Adding a student can move the cohort array
+   and takes the directory lock exclusively; every other request holds it shared.
+   A commit is acknowledged once fsync'ed. The first waiter that finds no fsync running syncs
+   everything appended so far (group commit), and the replies to a client's pipelined lines leave
+   together after one wait. Reads are uncommitted: a GET sees marks as soon as they are applied,
+   before the fsync that makes them durable.
+   A failed append or fsync stops the server for good (entry_fail): it accepts no more
+   connections, every session answers ERR store sync failed and closes, and the store is closed
+   as the log has it rather than compacted from a cohort holding unlogged marks.
+   =========================== */
+#ifdef HAVE_EPOLL
+#define ENTRY_STRIPES 1024                  /* power of two */
+#define ENTRY_MAX_SESSIONS 256
+#define ENTRY_IN_MAX (BATCH_LINE_MAX + 16)  /* one request line plus its command word */
+
+typedef struct {
+    pthread_mutex_t lock;           // held by a writer of one of the stripe's students
+    unsigned int seq;               // odd while that writer is changing the record
+} EntryStripe;
+
+typedef struct {
+    EntryStripe stripes[ENTRY_STRIPES];
+    pthread_rwlock_t directory;     // shared while records are used, exclusive to add a student
+    pthread_mutex_t log_lock;       // store log appends and the group commit state below
+    pthread_cond_t synced_cond;
+    unsigned long long appended;    // log records appended, and how many of them are fsync'ed
+    unsigned long long synced;
+    int syncing;
+    int sync_failed;                // set once, by entry_fail()
+    int listen_fd;
+    pthread_mutex_t sessions_lock;
+    pthread_cond_t sessions_done;
+    int session_fds[ENTRY_MAX_SESSIONS];    // -1 = free
+    int num_sessions;
+    long commits;                   // totals of the sessions that have ended
+    long reads;
+} EntryServer;
+
+typedef struct {
+    int fd;
+    int slot;
+    BatchContext bc;                // row parsing, and one scratch record per branch for snapshots
+    OutBuf out;
+    char in[ENTRY_IN_MAX];
+    long line_no;
+    long commits;
+    long reads;
+} EntrySession;
+
+static EntryServer entry;
+
+static void entry_write_begin(EntryStripe *x) {
+    __atomic_store_n(&x->seq, x->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void entry_write_end(EntryStripe *x) {
+    __atomic_store_n(&x->seq, x->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* A consistent copy of a student into a scratch record of their branch, without locking */
+static void entry_snapshot(const EntryStripe *x, const StudentRecord *st, StudentRecord *copy) {
+    const Branch *br = &all_branches[st->branch];
+    for (;;) {
+        unsigned int seq = __atomic_load_n(&x->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) { sched_yield(); continue; }
+        copy->total_credit_points = st->total_credit_points;
+        copy->total_credits = st->total_credits;
+        memcpy(copy->sems, st->sems, (size_t)br->num_semesters * sizeof *st->sems);
+        memcpy(copy->marks, st->marks, (size_t)br->num_subjects);
+        memcpy(copy->grade_points, st->grade_points, (size_t)br->num_subjects);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&x->seq, __ATOMIC_RELAXED) == seq) break;
+    }
+    memcpy(copy->reg_no, st->reg_no, sizeof copy->reg_no);
+}
+
+/* The log lost records: stop the server (called with log_lock held) */
+static void entry_fail(void) {
+    __atomic_store_n(&entry.sync_failed, 1, __ATOMIC_RELEASE);
+    serve_stop = 1;
+    shutdown(entry.listen_fd, SHUT_RDWR);   /* wakes the accept loop */
+}
+
+/* Wait until log record number ticket is on disk, fsyncing for everyone if nobody is */
+static int entry_durable(unsigned long long ticket) {
+    pthread_mutex_lock(&entry.log_lock);
+    while (entry.synced < ticket && !entry.sync_failed) {
+        if (entry.syncing) {
+            pthread_cond_wait(&entry.synced_cond, &entry.log_lock);
+            continue;
+        }
+        unsigned long long upto = entry.appended;
+        int ok = fflush(student_store.log) == 0;
+        entry.syncing = 1;
+        student_store.pending = 0;
+        pthread_mutex_unlock(&entry.log_lock);
+        METRIC_START(t0);
+        if (ok) ok = fsync(fileno(student_store.log)) == 0;
+        METRIC_STOP(TIMER_STORE_SYNC, t0);
+        pthread_mutex_lock(&entry.log_lock);
+        entry.syncing = 0;
+        if (ok) entry.synced = upto;
+        else { perror(STORE_LOG_NAME); entry_fail(); }
+        pthread_cond_broadcast(&entry.synced_cond);
+    }
+    int ok = !entry.sync_failed;
+    pthread_mutex_unlock(&entry.log_lock);
+    return ok;
+}
+
+static void entry_reply_gpa(OutBuf *ob, const char *label, int x100) {
+    ob_str(ob, label);
+    ob_gpa(ob, x100);
+}
+
+/* MARKS: grade one row into the stored student; *ticket is set to its log record */
+static void entry_commit(EntrySession *s, const char *row, size_t len, unsigned long long *ticket) {
+    OutBuf *ob = &s->out;
+    int b, sem, ap;
+    char why[160], id[sizeof ((StudentRecord *)0)->reg_no];
+    if (!batch_parse_row(&s->bc, row, len, &b, &sem, &ap, why, sizeof why)) {
+        ob_str(ob, "ERR ");
+        ob_str(ob, why[0] ? why : "malformed row");
+        ob_str(ob, "\n");
+        return;
+    }
+    if ((size_t)s->bc.field_len[0] >= sizeof id) { ob_str(ob, "ERR student id too long\n"); return; }
+    memcpy(id, s->bc.fields[0], (size_t)s->bc.field_len[0]);
+    id[s->bc.field_len[0]] = '\0';
+
+    StudentStore *ss = &student_store;
+    pthread_rwlock_rdlock(&entry.directory);
+    int idx = student_index_find(ss, id);
+    if (idx < 0) {
+        pthread_rwlock_unlock(&entry.directory);
+        pthread_rwlock_wrlock(&entry.directory);
+        StudentRecord *added = store_student(ss, id, b);    /* or found, if another session added them meanwhile */
+        idx = added ? (int)(added - ss->cohort.students) : student_index_find(ss, id);
+        pthread_rwlock_unlock(&entry.directory);
+        pthread_rwlock_rdlock(&entry.directory);
+        if (idx < 0) {
+            pthread_rwlock_unlock(&entry.directory);
+            ob_str(ob, "ERR student cannot be stored\n");
+            return;
+        }
+    }
+    StudentRecord *st = &ss->cohort.students[idx];
+    if (st->branch != b) {
+        pthread_rwlock_unlock(&entry.directory);
+        ob_str(ob, "ERR ");
+        ob_str(ob, id);
+        ob_str(ob, " is registered under ");
+        ob_str(ob, all_branches[st->branch].code);
+        ob_str(ob, "\n");
+        return;
+    }
+
+    EntryStripe *x = &entry.stripes[idx & (ENTRY_STRIPES - 1)];
+    const int *marks = s->bc.marks;
+    pthread_mutex_lock(&x->lock);
+    entry_write_begin(x);
+    for (int i = 0; i < all_branches[b].semesters[sem - 1].num_subjects; i++) set_subject_marks(st, sem - 1, i, marks[i]);
+    st->sems[sem - 1].activity_points = (unsigned char)ap;
+    update_pf_failed(st, sem - 1);
+    grade_semester(st, sem - 1);
+    int sgpa = SGPA_X100(&st->sems[sem - 1]), cgpa = CGPA_X100(st);
+    entry_write_end(x);
+    pthread_mutex_lock(&entry.log_lock);
+    int logged = store_log_semester(ss, st, sem - 1);
+    if (logged) *ticket = ++entry.appended;
+    else entry_fail();
+    pthread_mutex_unlock(&entry.log_lock);
+    pthread_mutex_unlock(&x->lock);
+    pthread_rwlock_unlock(&entry.directory);
+
+    if (!logged) { ob_str(ob, "ERR could not append to the store\n"); return; }
+    s->commits++;
+    METRIC_COUNT(METRIC_ROWS_GRADED, 1);
+    ob_str(ob, "OK ");
+    ob_str(ob, id);
+    ob_str(ob, " S");
+    ob_int(ob, all_branches[b].semesters[sem - 1].sem_number, 0);
+    entry_reply_gpa(ob, " SGPA ", sgpa);
+    entry_reply_gpa(ob, " CGPA ", cgpa);
+    ob_str(ob, "\n");
+}
+
+/* GET: a snapshot of one student's results */
+static void entry_get(EntrySession *s, const char *id, size_t len) {
+    OutBuf *ob = &s->out;
+    char key[sizeof ((StudentRecord *)0)->reg_no];
+    while (len > 0 && (id[len - 1] == ' ' || id[len - 1] == '\r')) len--;
+    while (len > 0 && *id == ' ') { id++; len--; }
+    if (len == 0 || len >= sizeof key) { ob_str(ob, "ERR bad student id\n"); return; }
+    memcpy(key, id, len);
+    key[len] = '\0';
+
+    pthread_rwlock_rdlock(&entry.directory);
+    int idx = student_index_find(&student_store, key);
+    if (idx < 0) {
+        pthread_rwlock_unlock(&entry.directory);
+        ob_str(ob, "ERR unknown student\n");
+        return;
+    }
+    const StudentRecord *st = &student_store.cohort.students[idx];
+    StudentRecord *copy = &s->bc.scratch[st->branch];
+    entry_snapshot(&entry.stripes[idx & (ENTRY_STRIPES - 1)], st, copy);
+    pthread_rwlock_unlock(&entry.directory);
+
+    const Branch *br = &all_branches[copy->branch];
+    s->reads++;
+    ob_str(ob, "OK ");
+    ob_str(ob, copy->reg_no);
+    ob_str(ob, " ");
+    ob_str(ob, br->code);
+    entry_reply_gpa(ob, " CGPA ", CGPA_X100(copy));
+    for (int k = 0; k < br->num_semesters; k++) {
+        if (!copy->sems[k].is_completed) continue;
+        ob_str(ob, " S");
+        ob_int(ob, br->semesters[k].sem_number, 0);
+        entry_reply_gpa(ob, " ", SGPA_X100(&copy->sems[k]));
+    }
+    ob_str(ob, "\n");
+}
+
+/* One request line; returns 1 on QUIT */
+static int entry_command(EntrySession *s, const char *line, size_t len, unsigned long long *ticket) {
+    s->line_no++;
+    if (__atomic_load_n(&entry.sync_failed, __ATOMIC_ACQUIRE)) {
+        ob_str(&s->out, "ERR store sync failed\n");
+        return 1;
+    }
+    if (len >= 6 && memcmp(line, "MARKS ", 6) == 0) entry_commit(s, line + 6, len - 6, ticket);
+    else if (len >= 4 && memcmp(line, "GET ", 4) == 0) entry_get(s, line + 4, len - 5);
+    else if (len >= 4 && memcmp(line, "QUIT", 4) == 0) return 1;
+    else ob_str(&s->out, "ERR expected MARKS <row>, GET <student_id> or QUIT\n");
+    return 0;
+}
+
+static int entry_send(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 1;
+}
+
+/* Session thread: answer the complete lines of each read once their commits are durable */
+static void *entry_session(void *arg) {
+    EntrySession *s = arg;
+    size_t in_len = 0;
+    int done = 0;
+    while (!done) {
+        ssize_t got = recv(s->fd, s->in + in_len, sizeof s->in - in_len, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        in_len += (size_t)got;
+
+        size_t pos = 0;
+        unsigned long long ticket = 0;
+        const char *nl;
+        while (!done && (nl = memchr(s->in + pos, '\n', in_len - pos)) != NULL) {
+            size_t n = (size_t)(nl - (s->in + pos)) + 1;
+            done = entry_command(s, s->in + pos, n, &ticket);
+            pos += n;
+        }
+        if (pos == 0 && in_len == sizeof s->in) {
+            ob_str(&s->out, "ERR line too long\n");
+            done = 1;
+        }
+        memmove(s->in, s->in + pos, in_len - pos);
+        in_len -= pos;
+        if (ticket && !entry_durable(ticket)) {
+            s->out.len = 0;         /* nothing in this batch may be reported as committed */
+            ob_str(&s->out, "ERR store sync failed\n");
+            done = 1;
+        }
+        if (s->out.failed || !entry_send(s->fd, s->out.data, s->out.len)) break;
+        s->out.len = 0;
+    }
+
+    pthread_mutex_lock(&entry.sessions_lock);
+    close(s->fd);
+    entry.session_fds[s->slot] = -1;
+    entry.num_sessions--;
+    entry.commits += s->commits;
+    entry.reads += s->reads;
+    pthread_cond_signal(&entry.sessions_done);
+    pthread_mutex_unlock(&entry.sessions_lock);
+    batch_context_free(&s->bc);
+    free(s->out.data);
+    free(s);
+    return NULL;
+}
+
+/* Hand an accepted connection to a new session thread */
+static void entry_start_session(int fd) {
+    static const char busy[] = "ERR too many sessions\n";
+    EntrySession *s = calloc(1, sizeof *s);
+    if (!s || !batch_context_init(&s->bc)) {
+        free(s);
+        close(fd);
+        return;
+    }
+    s->fd = fd;
+    s->bc.limit = s->in + sizeof s->in;
+    pthread_mutex_lock(&entry.sessions_lock);
+    s->slot = -1;
+    for (int i = 0; i < ENTRY_MAX_SESSIONS && s->slot < 0; i++) {
+        if (entry.session_fds[i] < 0) s->slot = i;
+    }
+    if (s->slot >= 0) {
+        entry.session_fds[s->slot] = fd;
+        entry.num_sessions++;
+    }
+    pthread_mutex_unlock(&entry.sessions_lock);
+    if (s->slot < 0) {
+        entry_send(fd, busy, sizeof busy - 1);
+        close(fd);
+        batch_context_free(&s->bc);
+        free(s);
+        return;
+    }
+
+    /* sessions leave SIGINT/SIGTERM to the accepting thread */
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    pthread_attr_t attr;
+    pthread_t tid;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&tid, &attr, entry_session, s);
+    pthread_attr_destroy(&attr);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (rc != 0) {
+        pthread_mutex_lock(&entry.sessions_lock);
+        entry.session_fds[s->slot] = -1;
+        entry.num_sessions--;
+        pthread_mutex_unlock(&entry.sessions_lock);
+        close(fd);
+        batch_context_free(&s->bc);
+        free(s);
+    }
+}
+#endif
+
+int run_entry(int port) {
+#ifdef HAVE_EPOLL
+    if (!student_store.is_open) {
+        fprintf(stderr, "--entry commits marks to a student store: add --store DIR.\n");
+        return 1;
+    }
+    memset(&entry, 0, sizeof entry);
+    for (int i = 0; i < ENTRY_STRIPES; i++) pthread_mutex_init(&entry.stripes[i].lock, NULL);
+    for (int i = 0; i < ENTRY_MAX_SESSIONS; i++) entry.session_fds[i] = -1;
+    pthread_rwlock_init(&entry.directory, NULL);
+    pthread_mutex_init(&entry.log_lock, NULL);
+    pthread_cond_init(&entry.synced_cond, NULL);
+    pthread_mutex_init(&entry.sessions_lock, NULL);
+    pthread_cond_init(&entry.sessions_done, NULL);
+    student_store.sync_every = INT_MAX;     /* fsyncs are group commits, see entry_durable() */
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int one = 1;
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0 || setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one) != 0 ||
+        bind(listen_fd, (struct sockaddr *)&addr, sizeof addr) != 0 || listen(listen_fd, SOMAXCONN) != 0) {
+        perror("--entry");
+        if (listen_fd >= 0) close(listen_fd);
+        return 1;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = serve_on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    entry.listen_fd = listen_fd;
+
+    printf("Accepting marks for %d stored student(s) on 127.0.0.1:%d (Ctrl-C to stop).\n", student_store.cohort.count, port);
+    fflush(stdout);
+    while (!serve_stop) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (serve_stop) break;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("accept");
+            break;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        entry_start_session(fd);
+    }
+    close(listen_fd);
+
+    /* after a failed sync, sessions may still be sending their ERR replies */
+    int how = __atomic_load_n(&entry.sync_failed, __ATOMIC_ACQUIRE) ? SHUT_RD : SHUT_RDWR;
+    pthread_mutex_lock(&entry.sessions_lock);
+    for (int i = 0; i < ENTRY_MAX_SESSIONS; i++) {
+        if (entry.session_fds[i] >= 0) shutdown(entry.session_fds[i], how);
+    }
+    while (entry.num_sessions > 0) pthread_cond_wait(&entry.sessions_done, &entry.sessions_lock);
+    pthread_mutex_unlock(&entry.sessions_lock);
+    printf("Stopped after %ld commit(s) and %ld read(s).\n", entry.commits, entry.reads);
+    if (entry.sync_failed) {
+        fprintf(stderr, "--entry: the store log failed; the store keeps only what reached the log.\n");
+        student_store.log_records = 0;      /* no compaction from the cohort in memory */
+        student_store.pending = 0;
+        return 1;
+    }
+    return 0;
+#else
+    (void)port;
+    fprintf(stderr, "--entry needs Linux sockets.\n");
+    return 1;
+#endif
+}
+
+/* ===========================
+   Benchmarks (--bench [SCALES]): synthetic cohorts graded through the real code paths.
+   One JSON object per line: {"bench","scale","ops","seconds","ns_per_op","records_per_s","peak_rss_kb"}.
+   Each scale runs in a child process of its own, so peak_rss_kb is the high-water mark of that
+   scale up to the benchmark that reports it, not of the whole run.
+   Marks follow a per-student ability around 68 with per-subject noise, and roughly 3% of P/F
+   attempts fail. Scales above BENCH_POOL_STUDENTS reuse a resident pool of that many students,
+   so large scales measure throughput rather than holding the whole cohort in memory.
+   =========================== */
+#define BENCH_DEFAULT_SCALES "1000,100000,10000000"
+#define BENCH_POOL_STUDENTS 262144
+#define BENCH_PF_FAIL_PERCENT 3
+#define BENCH_MAX_SUBJECTS 256              /* per semester, for the synthetic mark buffers */
+#ifdef HAVE_POSIX
+#define BENCH_NULL_DEVICE "/dev/null"
+#else
+#define BENCH_NULL_DEVICE "NUL"
+#endif
+
+static unsigned long long bench_rng = 0x9E3779B97F4A7C15ull;
+
+static unsigned int bench_rand(void) {
+    bench_rng ^= bench_rng >> 12;
+    bench_rng ^= bench_rng << 25;
+    bench_rng ^= bench_rng >> 27;
+    return (unsigned int)((bench_rng * 2685821657736338717ull) >> 32);
+}
+
+/* Roughly normal marks (sum of four uniforms) around mean, clamped to 0-100 */
+static int bench_marks(int mean, int spread) {
+    int u = 0;
+    for (int k = 0; k < 4; k++) u += (int)(bench_rand() % (unsigned int)(2 * spread + 1)) - spread;
+    int m = mean + u / 2;
+    return m < 0 ? 0 : m > 100 ? 100 : m;
+}
+
+/* Marks of one synthetic semester: regular subjects around the student's ability, P/F mostly passed */
+static void bench_semester_marks(const Semester *syl, int ability, int *marks) {
+    const GradingScheme *g = SEMESTER_SCHEME(syl);
+    for (int i = 0; i < syl->num_subjects; i++) {
+        if (!syl->subjects[i].is_passfail) marks[i] = bench_marks(ability, 12);
+        else if (bench_rand() % 100 < BENCH_PF_FAIL_PERCENT) marks[i] = (int)(bench_rand() % (g->pf_pass ? g->pf_pass : 1));
+        else marks[i] = g->pf_pass + (int)(bench_rand() % (unsigned int)(101 - g->pf_pass));
+    }
+}
+
+static int bench_fill_cohort(Cohort *c, long n) {
+    int marks[BENCH_MAX_SUBJECTS];
+    for (long k = 0; k < n; k++) {
+        char reg[16];
+        snprintf(reg, sizeof reg, "B%09ld", k);
+        int b = (int)(bench_rand() % (unsigned int)num_branches);
+        StudentRecord *st = cohort_add(c, reg, b);
+        if (!st) return 0;
+        int ability = bench_marks(68, 14);
+        for (int s = 0; s < all_branches[b].num_semesters; s++) {
+            const Semester *syl = &all_branches[b].semesters[s];
+            bench_semester_marks(syl, ability, marks);
+            for (int i = 0; i < syl->num_subjects; i++) set_subject_marks(st, s, i, marks[i]);
+            st->sems[s].activity_points = (unsigned char)(bench_rand() % 41);
+            update_pf_failed(st, s);
+            grade_semester(st, s);
+        }
+    }
+    return 1;
+}
+
+static double bench_now(void) {
+#ifdef HAVE_POSIX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static long bench_peak_rss_kb(void) {
+#ifdef HAVE_POSIX
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#ifdef __APPLE__
+        return (long)(ru.ru_maxrss / 1024);     /* bytes on macOS */
+#else
+        return (long)ru.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+static void bench_report(const char *name, long scale, long ops, double seconds, long records) {
+    if (seconds <= 0) seconds = 1e-9;
+    printf("{\"bench\":\"%s\",\"scale\":%ld,\"ops\":%ld,\"seconds\":%.6f,\"ns_per_op\":%.2f,"
+           "\"records_per_s\":%.0f,\"peak_rss_kb\":%ld,\"lanes\":%d}\n",
+           name, scale, ops, seconds, seconds * 1e9 / (double)(ops ? ops : 1),
+           (double)records / seconds, bench_peak_rss_kb(), GRADE_LANES);
+    fflush(stdout);
+}
+
+static volatile long bench_sink;   /* keeps results observable so loops are not optimised away */
+
+static int bench_scale(long scale) {
+    long pool_n = scale < BENCH_POOL_STUDENTS ? scale : BENCH_POOL_STUDENTS;
+    long reps = (scale + pool_n - 1) / pool_n;
+    Cohort pool;
+    cohort_init(&pool);
+    if (!bench_fill_cohort(&pool, pool_n)) { cohort_free(&pool); return 0; }
+    double t;
+    long ops, sink = 0;
+
+    /* get_grade_point: one lookup per subject mark */
+    {
+        static unsigned char marks[1 << 16];
+        for (size_t i = 0; i < sizeof marks; i++) marks[i] = (unsigned char)bench_marks(68, 14);
+        long n = scale * 40;
+        t = bench_now();
+        for (long k = 0; k < n; k++) sink += get_grade_point(marks[k & (sizeof marks - 1)]);
+        bench_report("get_grade_point", scale, n, bench_now() - t, n);
+    }
+
+    /* grade_semester: regrade every semester of every student, one at a time */
+    t = bench_now();
+    ops = 0;
+    for (long r = 0; r < reps; r++) {
+        for (long k = 0; k < pool_n && r * pool_n + k < scale; k++) {
+            StudentRecord *st = &pool.students[k];
+            for (int s = 0; s < all_branches[st->branch].num_semesters; s++, ops++) grade_semester(st, s);
+            sink += st->total_credit_points;
+        }
+    }
+    bench_report("grade_semester", scale, ops, bench_now() - t, scale);
+
+    /* total_activity_points / total_pf_failures per student */
+    t = bench_now();
+    ops = 0;
+    for (long r = 0; r < reps; r++) {
+        for (long k = 0; k < pool_n && r * pool_n + k < scale; k++, ops++) {
+            sink += sum_activity_points(&pool.students[k]) + count_pf_failures(&pool.students[k]);
+        }
+    }
+    bench_report("activity_and_pf_totals", scale, ops, bench_now() - t, scale);
+
+    /* Bulk SIMD/scalar kernel over every semester of the cohort */
+    t = bench_now();
+    ops = 0;
+    for (long r = 0; r < reps; r++) {
+        long n = cohort_grade(&pool);
+        if (n < 0) { cohort_free(&pool); return 0; }
+        ops += n;
+    }
+    bench_report("cohort_grade", scale, ops, bench_now() - t, (long)pool_n * reps);
+
+    /* Report rendering into memory, one semester report per student */
+    {
+        OutBuf ob;
+        memset(&ob, 0, sizeof ob);
+        size_t bytes = 0;
+        t = bench_now();
+        for (long r = 0; r < reps; r++) {
+            for (long k = 0; k < pool_n && r * pool_n + k < scale; k++) {
+                const StudentRecord *st = &pool.students[k];
+                ob.len = 0;
+                render_report(&ob, st, (int)(k % all_branches[st->branch].num_semesters));
+                bytes += ob.len;
+            }
+        }
+        double dt = bench_now() - t;
+        bench_report("render_report", scale, scale, dt, scale);
+        sink += (long)bytes;
+        free(ob.data);
+    }
+    cohort_free(&pool);
+
+    /* End to end: CSV rows parsed, graded and formatted as --batch does (scale rows) */
+    {
+        BatchContext bc;
+        FILE *null_out = fopen(BENCH_NULL_DEVICE, "w");
+        if (!null_out || !batch_context_init(&bc)) { if (null_out) fclose(null_out); return 0; }
+        long rows_n = scale < BENCH_POOL_STUDENTS ? scale : BENCH_POOL_STUDENTS;
+        size_t cap = (size_t)rows_n * 96 + 4096, len = 0;
+        char *rows = malloc(cap);
+        int marks[BENCH_MAX_SUBJECTS];
+        long made = 0, student = 0;
+        while (rows && made < rows_n) {
+            int b = (int)(bench_rand() % (unsigned int)num_branches), ability = bench_marks(68, 14);
+            for (int s = 0; s < all_branches[b].num_semesters && made < rows_n; s++, made++) {
+                const Semester *syl = &all_branches[b].semesters[s];
+                if (len + 64 + 4 * (size_t)syl->num_subjects > cap) {
+                    char *grown = realloc(rows, cap * 2);
+                    if (!grown) { free(rows); rows = NULL; break; }
+                    rows = grown;
+                    cap *= 2;
+                }
+                bench_semester_marks(syl, ability, marks);
+                len += (size_t)sprintf(rows + len, "B%09ld,%s,%d", student, all_branches[b].code, s + 1);
+                for (int i = 0; i < syl->num_subjects; i++) len += (size_t)sprintf(rows + len, ",%d", marks[i]);
+                len += (size_t)sprintf(rows + len, ",%u\n", bench_rand() % 41);
+            }
+            student++;
+        }
+        if (!rows) { batch_context_free(&bc); fclose(null_out); return 0; }
+        long done = 0;
+        bc.limit = rows + len;
+        t = bench_now();
+        while (done < scale) {
+            for (const char *p = rows; p < rows + len && done < scale; done++) {
+                const char *nl = memchr(p, '\n', (size_t)(rows + len - p));
+                size_t n = (size_t)(nl - p) + 1;
+                batch_row(&bc, p, n, done + 2, null_out, stderr);
+                p += n;
+            }
+        }
+        batch_flush(&bc, null_out, stderr);
+        bench_report("batch_end_to_end", scale, done, bench_now() - t, done);
+        sink += bc.graded;
+        free(rows);
+        batch_context_free(&bc);
+        fclose(null_out);
+    }
+    bench_sink = sink;
+    return 1;
+}
+
+/* One scale in a child process where fork() is available, so its peak RSS is its own */
+static int bench_run_scale(long scale) {
+#ifdef HAVE_POSIX
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int ok = bench_scale(scale);
+        fflush(stdout);
+        _exit(ok ? 0 : 1);
+    }
+    if (pid > 0) {
+        int status;
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) return 0;
+        }
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+#endif
+    return bench_scale(scale);
+}
+
+/* Bit-identity check of the SIMD kernel against the scalar path, run before the benchmarks: every
+   branch-semester is graded for a block whose columns each go through all marks 0-100, with a
+   student count that also leaves a scalar tail. Reported as one JSON line; returns 0 on a mismatch. */
+#define BENCH_CHECK_STUDENTS 1021
+
+static int bench_check_kernel(void) {
+    long blocks = 0, students = 0, mismatches = 0;
+    for (int b = 0; b < num_branches; b++) {
+        for (int s = 0; s < all_branches[b].num_semesters; s++) {
+            GradeBlock blk;
+            if (all_branches[b].semesters[s].num_subjects == 0) continue;
+            if (!grade_block_init(&blk, b, s, BENCH_CHECK_STUDENTS)) return 0;
+            blk.num_students = BENCH_CHECK_STUDENTS;
+            for (int i = 0; i < blk.num_subjects; i++) {
+                for (int j = 0; j < blk.num_students; j++) blk.marks[(size_t)i * blk.stride + j] = (unsigned char)((j + 13 * i) % 101);
+            }
+            int differ = grade_block_compare(&blk);
+            grade_block_free(&blk);
+            if (differ < 0) return 0;
+            mismatches += differ;
+            students += BENCH_CHECK_STUDENTS;
+            blocks++;
+        }
+    }
+    printf("{\"check\":\"simd_scalar_identity\",\"blocks\":%ld,\"students\":%ld,\"mismatches\":%ld,\"lanes\":%d}\n",
+           blocks, students, mismatches, GRADE_LANES);
+    fflush(stdout);
+    if (mismatches) fprintf(stderr, "SIMD kernel results differ from the scalar path for %ld student(s).\n", mismatches);
+    return mismatches == 0;
+}
+
+/* Run every benchmark at each scale of a comma-separated list */
+int run_bench(const char *scales) {
+    for (int b = 0; b < num_branches; b++) {
+        for (int s = 0; s < all_branches[b].num_semesters; s++) {
+            if (all_branches[b].semesters[s].num_subjects > BENCH_MAX_SUBJECTS) {
+                fprintf(stderr, "Benchmarks support at most %d subjects per semester.\n", BENCH_MAX_SUBJECTS);
+                return 1;
+            }
+        }
+    }
+    if (!scales) scales = BENCH_DEFAULT_SCALES;
+    for (int run = 0; run < 2; run++) {     /* validate the whole list, check the kernel, then run it */
+        if (run && !bench_check_kernel()) return 1;
+        const char *p = scales;
+        while (*p) {
+            char *end;
+            long scale = strtol(p, &end, 10);
+            if (end == p || (*end && *end != ',') || scale < 1) { fprintf(stderr, "Invalid benchmark scales '%s'.\n", scales); return 1; }
+            if (run && !bench_run_scale(scale)) { fprintf(stderr, "Benchmark at scale %ld ran out of memory.\n", scale); return 1; }
+            p = *end ? end + 1 : end;
+        }
+    }
+    return 0;
+}
+
+/* End of a run: save the store, close the --errors file and write the --metrics snapshot */
+static int finish_run(int rc) {
+    store_close(&student_store);
+    if (batch_errors && fclose(batch_errors) != 0) { perror("--errors"); rc = 1; }
+#ifdef HAVE_METRICS
+    if (metrics_path && !metrics_write(metrics_path)) rc = 1;
+#endif
+    return rc;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--syllabus FILE] [--store DIR] [mode]\n", prog);
+    printf("  (no mode)                       interactive menu\n");
+    printf("  --batch FILE [-o OUT]           grade a marks file (CSV/TSV, '-' = stdin)\n");
+    printf("  --errors FILE                   rejected rows of a marks file, with the reason, go to FILE\n");
+    printf("  --threads N                     batch worker threads (0 = one per core, default 1)\n");
+    printf("  --reports FILE [-o OUT]         semester reports for every row of a marks file\n");
+    printf("  --report-dir DIR                with --reports: one DIR/<student_id>.txt per student\n");
+    printf("  --analytics FILE [-o OUT]       grade distributions, SGPA statistics, toppers and CGPA percentiles\n");
+    printf("  --top K                         with --analytics: toppers listed per branch (default %d)\n", ANALYTICS_TOP_K);
+    printf("  --plan FILE [-o OUT]            SGPA and cheapest subject grades each student needs for --target\n");
+    printf("  --target CGPA                   with --plan: target CGPA (default %d.%02d)\n", PLAN_DEFAULT_TARGET / 100, PLAN_DEFAULT_TARGET % 100);
+    printf("  --revaluate FILE [-o OUT]       with --store: apply revised marks, write a changelog\n");
+    printf("  --eligibility [FILE] [-o OUT]   degree eligibility of each student of a marks file (no FILE: of --store)\n");
+    printf("  --verify-gpa FILE [-o OUT]      check every SGPA/CGPA against exact arithmetic, list float-path differences\n");
+    printf("  --archive FILE -o ARCHIVE       grade a marks file into a compact columnar result archive\n");
+    printf("  --archive-scan ARCHIVE [-o OUT] grade distributions and SGPA statistics from an archive\n");
+    printf("  --export FILE                   with --store: every graded subject as a Parquet file\n");
+    printf("  --transcripts OUT               with --store: a transcript per student into directory OUT, or OUT.tar\n");
+    printf("  --template FILE                 with --transcripts: template to render (default built in)\n");
+    printf("  --pdf                           with --transcripts: PDF instead of HTML\n");
+    printf("  --serve PORT                    with --store: JSON results over HTTP on 127.0.0.1:PORT\n");
+    printf("  --entry PORT                    with --store: concurrent mark entry (MARKS/GET lines) on 127.0.0.1:PORT\n");
+    printf("  --compile-syllabus TXT BIN      validate a text syllabus and write its binary snapshot\n");
+    printf("  --bench [SCALES]                benchmarks as JSON lines (default %s students)\n", BENCH_DEFAULT_SCALES);
+    printf("  --syllabus FILE                 syllabus text or snapshot (default %s)\n", DEFAULT_SYLLABUS);
+    printf("  --store DIR                     keep student results in DIR across runs (menu and batch)\n");
+    printf("  --schemes FILE                  grading schemes and their branch/semester use (default %s)\n", DEFAULT_SCHEMES);
+    printf("  --rules FILE                    degree eligibility rules (default %s)\n", DEFAULT_RULES);
+    printf("  --metrics FILE                  counters and latency histograms on exit (Prometheus text, JSON if FILE ends in .json)\n");
+}
+
+int main(int argc, char **argv) {
+    const char *batch_in = NULL, *out_path = NULL, *syllabus_path = DEFAULT_SYLLABUS, *store_dir = NULL;
+    const char *schemes_path = NULL, *bench_scales = NULL;
+    int bench = 0;
+    const char *reports_in = NULL, *report_dir = NULL, *analytics_in = NULL;
+    const char *archive_in = NULL, *archive_scan = NULL, *errors_path = NULL;
+    int top_k = ANALYTICS_TOP_K;
+    int threads = 1;
+    int serve_port = 0;
+    int entry_port = 0;
+    const char *plan_in = NULL, *revaluate_in = NULL, *rules_path = NULL, *eligibility_in = NULL;
+    const char *verify_in = NULL, *export_path = NULL, *transcripts_out = NULL, *template_path = NULL;
+    const char *compile_in = NULL, *compile_out = NULL;
+    int pdf = 0;
+    int eligibility = 0;
+    int target_x100 = PLAN_DEFAULT_TARGET;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batch_in = argv[++i];
+        else if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--out") == 0) && i + 1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "--syllabus") == 0 && i + 1 < argc) syllabus_path = argv[++i];
+        else if (strcmp(argv[i], "--store") == 0 && i + 1 < argc) store_dir = argv[++i];
+        else if (strcmp(argv[i], "--schemes") == 0 && i + 1 < argc) schemes_path = argv[++i];
+        else if (strcmp(argv[i], "--bench") == 0) {
+            bench = 1;
+            if (i + 1 < argc && argv[i + 1][0] != '-') bench_scales = argv[++i];
+        }
+        else if (strcmp(argv[i], "--reports") == 0 && i + 1 < argc) reports_in = argv[++i];
+        else if (strcmp(argv[i], "--report-dir") == 0 && i + 1 < argc) report_dir = argv[++i];
+        else if (strcmp(argv[i], "--analytics") == 0 && i + 1 < argc) analytics_in = argv[++i];
+        else if (strcmp(argv[i], "--errors") == 0 && i + 1 < argc) errors_path = argv[++i];
+        else if (strcmp(argv[i], "--archive") == 0 && i + 1 < argc) archive_in = argv[++i];
+        else if (strcmp(argv[i], "--archive-scan") == 0 && i + 1 < argc) archive_scan = argv[++i];
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc && parse_int_field(argv[i + 1], &top_k) && top_k >= 0) i++;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && parse_int_field(argv[i + 1], &threads) && threads >= 0) i++;
+        else if (strcmp(argv[i], "--revaluate") == 0 && i + 1 < argc) revaluate_in = argv[++i];
+        else if (strcmp(argv[i], "--plan") == 0 && i + 1 < argc) plan_in = argv[++i];
+        else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) rules_path = argv[++i];
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) metrics_path = argv[++i];
+        else if (strcmp(argv[i], "--verify-gpa") == 0 && i + 1 < argc) verify_in = argv[++i];
+        else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) export_path = argv[++i];
+        else if (strcmp(argv[i], "--transcripts") == 0 && i + 1 < argc) transcripts_out = argv[++i];
+        else if (strcmp(argv[i], "--template") == 0 && i + 1 < argc) template_path = argv[++i];
+        else if (strcmp(argv[i], "--pdf") == 0) pdf = 1;
+        else if (strcmp(argv[i], "--eligibility") == 0) {
+            eligibility = 1;
+            if (i + 1 < argc && (argv[i + 1][0] != '-' || strcmp(argv[i + 1], "-") == 0)) eligibility_in = argv[++i];
+        }
+        else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc && parse_cgpa_x100(argv[i + 1], &target_x100)) i++;
+        else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc && parse_int_field(argv[i + 1], &serve_port) && serve_port > 0 && serve_port < 65536) i++;
+        else if (strcmp(argv[i], "--entry") == 0 && i + 1 < argc && parse_int_field(argv[i + 1], &entry_port) && entry_port > 0 && entry_port < 65536) i++;
+        else if (strcmp(argv[i], "--compile-syllabus") == 0 && i + 2 < argc) {
+            compile_in = argv[++i];
+            compile_out = argv[++i];
+        }
+        else { print_usage(argv[0]); return 1; }
+    }
+
+#ifndef HAVE_METRICS
+    if (metrics_path) {
+        fprintf(stderr, "--metrics: this build has metrics compiled out.\n");
+        return 1;
+    }
+#endif
+    /* each scale runs in a child process, whose probes would never reach the snapshot, and the
+       probes would also be timed along with the code under test */
+    if (metrics_path && bench) {
+        fprintf(stderr, "--metrics cannot be combined with --bench.\n");
+        return 1;
+    }
+    metrics_enabled = metrics_path != NULL || serve_port > 0 || entry_port > 0;
+    if (compile_in) return finish_run(compile_syllabus(compile_in, compile_out));
+    /* an archive carries its own syllabus */
+    if (archive_scan) return finish_run(run_archive_scan(archive_scan, out_path));
+    if (!load_syllabus(syllabus_path)) {
+        fprintf(stderr, "Could not load syllabus '%s'.\n", syllabus_path);
+        return 1;
+    }
+    if (!load_grading_schemes(schemes_path ? schemes_path : DEFAULT_SCHEMES, schemes_path != NULL)) {
+        fprintf(stderr, "Could not load grading schemes '%s'.\n", schemes_path ? schemes_path : DEFAULT_SCHEMES);
+        return 1;
+    }
+    if (!load_eligibility_rules(rules_path ? rules_path : DEFAULT_RULES, rules_path != NULL)) {
+        fprintf(stderr, "Could not load eligibility rules '%s'.\n", rules_path ? rules_path : DEFAULT_RULES);
+        return 1;
+    }
+    initialize_branches();
+    if (bench) {
+        /* synthetic cohorts only: with a store open, the end-to-end benchmark would save them there */
+        if (store_dir) {
+            fprintf(stderr, "--bench does not take --store.\n");
+            return 1;
+        }
+        return finish_run(run_bench(bench_scales));
+    }
+    /* interactive entries are synced one by one; batch imports in groups */
+    if (store_dir && !store_open(&student_store, store_dir, batch_in || reports_in || analytics_in || archive_in || plan_in || revaluate_in || eligibility || verify_in ? STORE_BATCH_SYNC : 1)) {
+        fprintf(stderr, "Could not open student store '%s'.\n", store_dir);
+        return 1;
+    }
+    if (errors_path && !(batch_errors = fopen(errors_path, "w"))) {
+        perror(errors_path);
+        store_close(&student_store);
+        return 1;
+    }
+    if (serve_port) {
+        return finish_run(run_serve(serve_port));
+    }
+    if (entry_port) {
+        return finish_run(run_entry(entry_port));
+    }
+#ifdef HAVE_POSIX
+    if (threads == 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (threads < 1) threads = 1;
+    if (export_path) {
+        return finish_run(run_export(export_path));
+    }
+    if (transcripts_out) {
+        return finish_run(run_transcripts(transcripts_out, template_path, pdf, threads));
+    }
+    if (revaluate_in) {
+        return finish_run(run_revaluation(revaluate_in, out_path));
+    }
+    if (plan_in) {
+        return finish_run(run_plan(plan_in, out_path, target_x100));
+    }
+    if (eligibility) {
+        return finish_run(run_eligibility(eligibility_in, out_path));
+    }
+    if (verify_in) {
+        return finish_run(run_verify_gpa(verify_in, out_path));
+    }
+    if (archive_in) {
+        return finish_run(run_archive_write(archive_in, out_path));
+    }
+    if (analytics_in) {
+        return finish_run(run_analytics(analytics_in, out_path, top_k));
+    }
+    if (reports_in) {
+        return finish_run(run_reports(reports_in, out_path, report_dir));
+    }
+    if (batch_in) {
+        if (threads > 1 && store_dir) fprintf(stderr, "Note: --store batches run on one thread.\n");
+        return finish_run(run_batch(batch_in, out_path, threads));
+    }
+
+    printf("MBCET CGPA System initialized. %d branch syllabi loaded from %s.\n", num_branches, syllabus_path);
+    if (store_dir) printf("Student store: %s (%d record(s)).\n", store_dir, student_store.cohort.count);
+    printf("Note: P/F subjects are asked by marks and do not affect SGPA/CGPA. Pass threshold for P/F = %d.\n", grading_schemes[0].pf_pass);
+    show_main_menu();
+    return finish_run(0);
+}